@@ -1,36 +1,105 @@
 #include "accelerator.h"
 
+#include "cpu/image/image_mixer.h"
 #include "ogl/image/image_mixer.h"
 #include "ogl/util/device.h"
 
 #include <boost/property_tree/ptree.hpp>
 
+#include <common/env.h>
+
 #include <core/mixer/image/image_mixer.h>
 
+#include <algorithm>
 #include <memory>
 #include <mutex>
 #include <utility>
+#include <vector>
 
 namespace caspar { namespace accelerator {
 
+namespace {
+
+// Presents the OpenGL contexts to the protocols as a single device.
+class device_group final : public accelerator_device
+{
+    std::vector<std::shared_ptr<ogl::device>> devices_;
+
+  public:
+    explicit device_group(std::vector<std::shared_ptr<ogl::device>> devices)
+        : devices_(std::move(devices))
+    {
+    }
+
+    boost::property_tree::wptree info() const override
+    {
+        if (devices_.size() == 1) {
+            return devices_[0]->info();
+        }
+
+        boost::property_tree::wptree info;
+        for (auto& device : devices_) {
+            info.add_child(L"contexts.context", device->info());
+        }
+        return info;
+    }
+
+    std::future<void> gc() override
+    {
+        std::vector<std::future<void>> futures;
+        for (auto& device : devices_) {
+            futures.push_back(device->gc());
+        }
+
+        return std::async(std::launch::deferred, [futures = std::move(futures)]() mutable {
+            for (auto& future : futures) {
+                future.get();
+            }
+        });
+    }
+};
+
+} // namespace
+
 struct accelerator::impl
 {
-    std::shared_ptr<ogl::device> ogl_device_;
+    // Channels are spread over the contexts, which share objects so that frames can be drawn on any of them.
+    std::vector<std::shared_ptr<ogl::device>> ogl_devices_;
+    std::shared_ptr<device_group>             device_group_;
 
-    impl() {}
+    impl()
+        : ogl_devices_(std::max(1, env::properties().get(L"configuration.ogl.contexts", 1)))
+    {
+    }
 
-    std::unique_ptr<core::image_mixer> create_image_mixer(int channel_id)
+    std::unique_ptr<core::image_mixer> create_image_mixer(int channel_id, image_mixer_type type, bit_depth depth)
     {
-        return std::make_unique<ogl::image_mixer>(spl::make_shared_ptr(get_device()), channel_id);
+        if (type == image_mixer_type::cpu)
+            return std::make_unique<cpu::image_mixer>(channel_id);
+
+        auto& device = ogl_devices_.at((std::max(channel_id, 1) - 1) % ogl_devices_.size());
+        return std::make_unique<ogl::image_mixer>(spl::make_shared_ptr(get_device(device)), channel_id, depth);
     }
 
-    std::shared_ptr<ogl::device> get_device()
+    std::shared_ptr<ogl::device> get_device(std::shared_ptr<ogl::device>& device)
     {
-        if (!ogl_device_) {
-            ogl_device_ = std::make_shared<ogl::device>();
+        if (!device) {
+            device = std::make_shared<ogl::device>(ogl_devices_.size() > 1);
         }
 
-        return ogl_device_;
+        return device;
+    }
+
+    std::shared_ptr<device_group> get_device_group()
+    {
+        if (!device_group_) {
+            for (auto& device : ogl_devices_) {
+                get_device(device);
+            }
+            device_group_ = std::make_shared<device_group>(ogl_devices_);
+        }
+
+        return device_group_;
     }
 };
 
@@ -41,14 +110,12 @@ accelerator::accelerator()
 
 accelerator::~accelerator() {}
 
-std::unique_ptr<core::image_mixer> accelerator::create_image_mixer(int channel_id)
+std::unique_ptr<core::image_mixer>
+accelerator::create_image_mixer(int channel_id, image_mixer_type type, bit_depth depth)
 {
-    return impl_->create_image_mixer(channel_id);
+    return impl_->create_image_mixer(channel_id, type, depth);
 }
 
-std::shared_ptr<accelerator_device> accelerator::get_device() const
-{
-    return std::dynamic_pointer_cast<accelerator_device>(impl_->get_device());
-}
+std::shared_ptr<accelerator_device> accelerator::get_device() const { return impl_->get_device_group(); }
 
 }} // namespace caspar::accelerator
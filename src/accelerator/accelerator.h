@@ -1,5 +1,7 @@
 #pragma once
 
+#include <common/bit_depth.h>
+
 #include <core/mixer/mixer.h>
 
 #include <boost/property_tree/ptree.hpp>
@@ -10,6 +12,12 @@
 
 namespace caspar { namespace accelerator {
 
+enum class image_mixer_type
+{
+    ogl,
+    cpu,
+};
+
 class accelerator_device
 {
   public:
@@ -26,7 +34,10 @@ class accelerator
 
     accelerator& operator=(accelerator&) = delete;
 
-    std::unique_ptr<caspar::core::image_mixer> create_image_mixer(int channel_id);
+    // The cpu image mixer always mixes in 8 bits.
+    std::unique_ptr<caspar::core::image_mixer> create_image_mixer(int              channel_id,
+                                                                  image_mixer_type type  = image_mixer_type::ogl,
+                                                                  bit_depth        depth = bit_depth::bit8);
 
     std::shared_ptr<accelerator_device> get_device() const;
 
@@ -0,0 +1,938 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+#include "image_kernel.h"
+
+#include <common/assert.h>
+
+#include <core/frame/frame_transform.h>
+#include <core/frame/pixel_format.h>
+
+#include <boost/range/algorithm/equal.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <smmintrin.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+namespace caspar { namespace accelerator { namespace cpu {
+
+surface::surface(int width, int height, int channels)
+    : width_(width)
+    , height_(height)
+    , channels_(channels)
+    , data_(static_cast<std::size_t>(width) * height * channels, 0.0f)
+{
+}
+
+void surface::clear() { std::fill(data_.begin(), data_.end(), 0.0f); }
+
+namespace {
+
+const double epsilon  = 0.001;
+const int    row_tile = 16;
+
+using pixel_row = std::vector<float, tbb::cache_aligned_allocator<float>>;
+
+struct linear_function
+{
+    double c  = 0.0;
+    double dx = 0.0;
+    double dy = 0.0;
+
+    double operator()(double x, double y) const { return c + dx * x + dy * y; }
+};
+
+// Maps destination pixels back onto the drawn quad. Everything is evaluated at pixel centers.
+struct mapping
+{
+    int x0 = 0;
+    int x1 = 0;
+    int y0 = 0;
+    int y1 = 0;
+
+    // Quad parameters, a pixel is covered when both are within [0, 1).
+    linear_function s;
+    linear_function t;
+
+    // Normalized texture coordinates.
+    linear_function u;
+    linear_function v;
+
+    bool nearest = false;
+};
+
+// Range of pixels [begin, end) in a row for which 0 <= f < 1.
+void clip_span(const linear_function& f, double y, int& begin, int& end)
+{
+    auto a = f.c + f.dy * y;
+
+    if (std::abs(f.dx) < 1e-12) {
+        if (a < 0.0 || a >= 1.0)
+            end = begin;
+        return;
+    }
+
+    auto lo = (0.0 - a) / f.dx;
+    auto hi = (1.0 - a) / f.dx;
+    if (lo > hi)
+        std::swap(lo, hi);
+
+    begin = std::max(begin, static_cast<int>(std::ceil(lo - 0.5)));
+    end   = std::min(end, static_cast<int>(std::ceil(hi - 0.5)));
+}
+
+bool make_mapping(const draw_params& params, int width, int height, int source_width, int source_height, mapping& m)
+{
+    auto coords = params.geometry.data();
+
+    if (coords.size() != 4)
+        return false;
+
+    auto f_p    = params.transform.fill_translation;
+    auto f_s    = params.transform.fill_scale;
+    auto aspect = params.aspect_ratio;
+    auto angle  = params.transform.angle;
+    auto anchor = params.transform.anchor;
+    auto crop   = params.transform.crop;
+
+    bool is_default_geometry = boost::equal(coords, core::frame_geometry::get_default().data()) ||
+                               boost::equal(coords, core::frame_geometry::get_default_vflip().data());
+
+    for (auto& coord : coords) {
+        if (is_default_geometry) {
+            coord.vertex_x  = std::min(std::max(coord.vertex_x, crop.ul[0]), crop.lr[0]);
+            coord.vertex_y  = std::min(std::max(coord.vertex_y, crop.ul[1]), crop.lr[1]);
+            coord.texture_x = std::min(std::max(coord.texture_x, crop.ul[0]), crop.lr[0]);
+            coord.texture_y = std::min(std::max(coord.texture_y, crop.ul[1]), crop.lr[1]);
+        }
+
+        auto orig_x    = (coord.vertex_x - anchor[0]) * f_s[0];
+        auto orig_y    = (coord.vertex_y - anchor[1]) * f_s[1] / aspect;
+        coord.vertex_x = (orig_x * std::cos(angle) - orig_y * std::sin(angle)) + f_p[0];
+        coord.vertex_y = (orig_x * std::sin(angle) + orig_y * std::cos(angle)) * aspect + f_p[1];
+    }
+
+    // Quads are treated as parallelograms spanned by the upper left, upper right and lower left corners.
+    const auto& c0 = coords[0];
+    const auto& c1 = coords[1];
+    const auto& c3 = coords[3];
+
+    auto p0x = c0.vertex_x * width;
+    auto p0y = c0.vertex_y * height;
+    auto ax  = c1.vertex_x * width - p0x;
+    auto ay  = c1.vertex_y * height - p0y;
+    auto bx  = c3.vertex_x * width - p0x;
+    auto by  = c3.vertex_y * height - p0y;
+    auto det = ax * by - bx * ay;
+
+    if (std::abs(det) < 1e-9)
+        return false;
+
+    m.s.dx = by / det;
+    m.s.dy = -bx / det;
+    m.s.c  = -(m.s.dx * p0x + m.s.dy * p0y);
+    m.t.dx = -ay / det;
+    m.t.dy = ax / det;
+    m.t.c  = -(m.t.dx * p0x + m.t.dy * p0y);
+
+    auto texture = [&](double t0, double t1, double t3) {
+        linear_function f;
+        f.c  = t0 + m.s.c * (t1 - t0) + m.t.c * (t3 - t0);
+        f.dx = m.s.dx * (t1 - t0) + m.t.dx * (t3 - t0);
+        f.dy = m.s.dy * (t1 - t0) + m.t.dy * (t3 - t0);
+        return f;
+    };
+    m.u = texture(c0.texture_x, c1.texture_x, c3.texture_x);
+    m.v = texture(c0.texture_y, c1.texture_y, c3.texture_y);
+
+    // Bounding box of the quad, clipped to the target and the clip rectangle.
+    auto min_x = width * 1.0;
+    auto max_x = 0.0;
+    auto min_y = height * 1.0;
+    auto max_y = 0.0;
+    for (auto& coord : coords) {
+        min_x = std::min(min_x, coord.vertex_x * width);
+        max_x = std::max(max_x, coord.vertex_x * width);
+        min_y = std::min(min_y, coord.vertex_y * height);
+        max_y = std::max(max_y, coord.vertex_y * height);
+    }
+
+    m.x0 = std::max(0, static_cast<int>(std::floor(min_x)));
+    m.x1 = std::min(width, static_cast<int>(std::ceil(max_x)));
+    m.y0 = std::max(0, static_cast<int>(std::floor(min_y)));
+    m.y1 = std::min(height, static_cast<int>(std::ceil(max_y)));
+
+    auto m_p = params.transform.clip_translation;
+    auto m_s = params.transform.clip_scale;
+
+    bool scissor = m_p[0] > std::numeric_limits<double>::epsilon() || m_p[1] > std::numeric_limits<double>::epsilon() ||
+                   m_s[0] < 1.0 - std::numeric_limits<double>::epsilon() ||
+                   m_s[1] < 1.0 - std::numeric_limits<double>::epsilon();
+
+    if (scissor) {
+        auto clip_x = static_cast<int>(m_p[0] * width);
+        auto clip_y = static_cast<int>(m_p[1] * height);
+        m.x0        = std::max(m.x0, clip_x);
+        m.x1        = std::min(m.x1, clip_x + std::max(0, static_cast<int>(m_s[0] * width)));
+        m.y0        = std::max(m.y0, clip_y);
+        m.y1        = std::min(m.y1, clip_y + std::max(0, static_cast<int>(m_s[1] * height)));
+    }
+
+    if (m.x0 >= m.x1 || m.y0 >= m.y1)
+        return false;
+
+    // Unscaled, unrotated and texel aligned draws sample exactly one texel per pixel, skip the filtering.
+    auto texel_x = m.u(0.5, 0.5) * source_width - 0.5;
+    auto texel_y = m.v(0.5, 0.5) * source_height - 0.5;
+    m.nearest    = std::abs(m.u.dy) < 1e-9 && std::abs(m.v.dx) < 1e-9 &&
+                std::abs(std::abs(m.u.dx * source_width) - 1.0) < 1e-6 &&
+                std::abs(std::abs(m.v.dy * source_height) - 1.0) < 1e-6 &&
+                std::abs(texel_x - std::round(texel_x)) < 1e-3 && std::abs(texel_y - std::round(texel_y)) < 1e-3;
+
+    return true;
+}
+
+// Sampling
+
+struct plane_view
+{
+    const std::uint8_t* data     = nullptr;
+    int                 width    = 0;
+    int                 height   = 0;
+    int                 linesize = 0;
+};
+
+template <int Stride>
+__m128 load_texel(const plane_view& plane, int x, int y)
+{
+    std::uint32_t value = 0;
+    std::memcpy(&value, plane.data + static_cast<std::size_t>(y) * plane.linesize + x * Stride, Stride);
+    return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(static_cast<int>(value))));
+}
+
+// Returns the channels of the plane in memory order, in the range [0, 255].
+template <int Stride>
+__m128 sample(const plane_view& plane, double u, double v, bool nearest)
+{
+    if (nearest) {
+        auto x = std::min(std::max(static_cast<int>(std::floor(u * plane.width)), 0), plane.width - 1);
+        auto y = std::min(std::max(static_cast<int>(std::floor(v * plane.height)), 0), plane.height - 1);
+        return load_texel<Stride>(plane, x, y);
+    }
+
+    auto fx = u * plane.width - 0.5;
+    auto fy = v * plane.height - 0.5;
+    auto ix = static_cast<int>(std::floor(fx));
+    auto iy = static_cast<int>(std::floor(fy));
+    auto wx = _mm_set1_ps(static_cast<float>(fx - ix));
+    auto wy = _mm_set1_ps(static_cast<float>(fy - iy));
+
+    auto x0 = std::min(std::max(ix, 0), plane.width - 1);
+    auto x1 = std::min(std::max(ix + 1, 0), plane.width - 1);
+    auto y0 = std::min(std::max(iy, 0), plane.height - 1);
+    auto y1 = std::min(std::max(iy + 1, 0), plane.height - 1);
+
+    auto t00 = load_texel<Stride>(plane, x0, y0);
+    auto t10 = load_texel<Stride>(plane, x1, y0);
+    auto t01 = load_texel<Stride>(plane, x0, y1);
+    auto t11 = load_texel<Stride>(plane, x1, y1);
+
+    auto top    = _mm_add_ps(t00, _mm_mul_ps(_mm_sub_ps(t10, t00), wx));
+    auto bottom = _mm_add_ps(t01, _mm_mul_ps(_mm_sub_ps(t11, t01), wx));
+    return _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), wy));
+}
+
+// Single channel variant for planar formats.
+float sample_plane(const plane_view& plane, double u, double v, bool nearest)
+{
+    if (nearest) {
+        auto x = std::min(std::max(static_cast<int>(std::floor(u * plane.width)), 0), plane.width - 1);
+        auto y = std::min(std::max(static_cast<int>(std::floor(v * plane.height)), 0), plane.height - 1);
+        return plane.data[static_cast<std::size_t>(y) * plane.linesize + x];
+    }
+
+    auto fx = u * plane.width - 0.5;
+    auto fy = v * plane.height - 0.5;
+    auto ix = static_cast<int>(std::floor(fx));
+    auto iy = static_cast<int>(std::floor(fy));
+    auto wx = static_cast<float>(fx - ix);
+    auto wy = static_cast<float>(fy - iy);
+
+    auto x0 = std::min(std::max(ix, 0), plane.width - 1);
+    auto x1 = std::min(std::max(ix + 1, 0), plane.width - 1);
+    auto r0 = plane.data + static_cast<std::size_t>(std::min(std::max(iy, 0), plane.height - 1)) * plane.linesize;
+    auto r1 = plane.data + static_cast<std::size_t>(std::min(std::max(iy + 1, 0), plane.height - 1)) * plane.linesize;
+
+    auto top    = r0[x0] + (r0[x1] - r0[x0]) * wx;
+    auto bottom = r1[x0] + (r1[x1] - r1[x0]) * wx;
+    return top + (bottom - top) * wy;
+}
+
+template <int A, int B, int C, int D>
+__m128 swizzle(__m128 value)
+{
+    return _mm_shuffle_ps(value, value, _MM_SHUFFLE(D, C, B, A));
+}
+
+__m128 opaque(__m128 value) { return _mm_blend_ps(value, _mm_set1_ps(1.0f), 8); }
+
+__m128 normalize(__m128 value) { return _mm_mul_ps(value, _mm_set1_ps(1.0f / 255.0f)); }
+
+struct ycbcr_coefficients
+{
+    __m128 cb;
+    __m128 cr;
+};
+
+// Same coefficients as the OpenGL image shader, output in BGRA order.
+const ycbcr_coefficients ycbcr_sd = {_mm_setr_ps(2.018f, -0.391f, 0.0f, 0.0f),
+                                     _mm_setr_ps(0.0f, -0.813f, 1.596f, 0.0f)};
+const ycbcr_coefficients ycbcr_hd = {_mm_setr_ps(2.115f, -0.213f, 0.0f, 0.0f),
+                                     _mm_setr_ps(0.0f, -0.534f, 1.793f, 0.0f)};
+
+__m128 ycbcra_to_bgra(float y, float cb, float cr, float a, const ycbcr_coefficients& coefficients)
+{
+    auto luma   = _mm_set1_ps(1.164f * (y - 16.0f));
+    auto chroma = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(cb - 128.0f), coefficients.cb),
+                             _mm_mul_ps(_mm_set1_ps(cr - 128.0f), coefficients.cr));
+    auto bgra   = normalize(_mm_add_ps(luma, chroma));
+    return _mm_blend_ps(bgra, _mm_set1_ps(a / 255.0f), 8);
+}
+
+float lane(__m128 value, int index)
+{
+    alignas(16) float values[4];
+    _mm_store_ps(values, value);
+    return values[index];
+}
+
+template <typename Func>
+void sample_row(double u, double v, double du, double dv, int count, __m128* out, Func&& func)
+{
+    for (int n = 0; n < count; ++n)
+        out[n] = func(u + du * n, v + dv * n);
+}
+
+int texel_index(double coord, int size) { return static_cast<int>(std::floor(coord * size)); }
+
+// Texel aligned BGRA and planar YCbCr rows are read straight from memory without per pixel coordinate math.
+bool fetch_aligned_row(const core::pixel_format_desc&  desc,
+                       const std::vector<plane_view>& planes,
+                       double                          u,
+                       double                          v,
+                       double                          du,
+                       int                             count,
+                       __m128*                         out)
+{
+    const auto& p0 = planes.at(0);
+
+    auto step  = du > 0.0 ? 1 : -1;
+    auto first = texel_index(u, p0.width);
+    auto last  = first + step * (count - 1);
+    auto y     = texel_index(v, p0.height);
+
+    if (first < 0 || first >= p0.width || last < 0 || last >= p0.width || y < 0 || y >= p0.height)
+        return false;
+
+    auto src = p0.data + static_cast<std::size_t>(y) * p0.linesize;
+
+    if (desc.format == core::pixel_format::bgra) {
+        auto scale = _mm_set1_ps(1.0f / 255.0f);
+        int  n     = 0;
+
+        if (step == 1) {
+            for (; n + 4 <= count; n += 4) {
+                auto px    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (first + n) * 4));
+                out[n + 0] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(px)), scale);
+                out[n + 1] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(px, 4))), scale);
+                out[n + 2] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(px, 8))), scale);
+                out[n + 3] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(px, 12))), scale);
+            }
+        }
+
+        for (; n < count; ++n)
+            out[n] = _mm_mul_ps(load_texel<4>(p0, first + step * n, y), scale);
+
+        return true;
+    }
+
+    if (desc.format == core::pixel_format::ycbcr || desc.format == core::pixel_format::ycbcra) {
+        const auto& cb_plane     = planes.at(1);
+        const auto& cr_plane     = planes.at(2);
+        const auto  has_alpha    = desc.format == core::pixel_format::ycbcra && planes.size() > 3;
+        const auto& coefficients = p0.height > 700 ? ycbcr_hd : ycbcr_sd;
+
+        auto cy = std::min(texel_index(v, cb_plane.height), cb_plane.height - 1);
+        auto cb = cb_plane.data + static_cast<std::size_t>(cy) * cb_plane.linesize;
+        auto cr = cr_plane.data + static_cast<std::size_t>(cy) * cr_plane.linesize;
+        auto a  = has_alpha ? planes[3].data + static_cast<std::size_t>(y) * planes[3].linesize : nullptr;
+
+        for (int n = 0; n < count; ++n) {
+            auto x  = first + step * n;
+            auto cx = std::min((2 * x + 1) * cb_plane.width / (2 * p0.width), cb_plane.width - 1);
+            out[n]  = ycbcra_to_bgra(src[x], cb[cx], cr[cx], a != nullptr ? a[x] : 255.0f, coefficients);
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+// Fills a row of premultiplied BGRA pixels from the frame planes.
+void fetch_row(const core::pixel_format_desc&  desc,
+               const std::vector<plane_view>& planes,
+               bool                            nearest,
+               double                          u,
+               double                          v,
+               double                          du,
+               double                          dv,
+               int                             count,
+               __m128*                         out)
+{
+    const auto& p0 = planes.at(0);
+
+    if (nearest && fetch_aligned_row(desc, planes, u, v, du, count, out))
+        return;
+
+    switch (desc.format) {
+        case core::pixel_format::gray:
+            sample_row(u, v, du, dv, count, out, [&](double u, double v) {
+                return opaque(normalize(swizzle<0, 0, 0, 0>(sample<1>(p0, u, v, nearest))));
+            });
+            break;
+        case core::pixel_format::bgra:
+            sample_row(u, v, du, dv, count, out, [&](double u, double v) {
+                return normalize(sample<4>(p0, u, v, nearest));
+            });
+            break;
+        case core::pixel_format::rgba:
+            sample_row(u, v, du, dv, count, out, [&](double u, double v) {
+                return normalize(swizzle<2, 1, 0, 3>(sample<4>(p0, u, v, nearest)));
+            });
+            break;
+        case core::pixel_format::argb:
+            sample_row(u, v, du, dv, count, out, [&](double u, double v) {
+                return normalize(swizzle<3, 2, 1, 0>(sample<4>(p0, u, v, nearest)));
+            });
+            break;
+        case core::pixel_format::abgr:
+            sample_row(u, v, du, dv, count, out, [&](double u, double v) {
+                return normalize(swizzle<1, 2, 3, 0>(sample<4>(p0, u, v, nearest)));
+            });
+            break;
+        case core::pixel_format::bgr:
+            sample_row(u, v, du, dv, count, out, [&](double u, double v) {
+                return opaque(normalize(sample<3>(p0, u, v, nearest)));
+            });
+            break;
+        case core::pixel_format::rgb:
+            sample_row(u, v, du, dv, count, out, [&](double u, double v) {
+                return opaque(normalize(swizzle<2, 1, 0, 3>(sample<3>(p0, u, v, nearest))));
+            });
+            break;
+        case core::pixel_format::luma:
+            sample_row(u, v, du, dv, count, out, [&](double u, double v) {
+                auto y = _mm_sub_ps(normalize(swizzle<0, 0, 0, 0>(sample<1>(p0, u, v, nearest))), _mm_set1_ps(0.065f));
+                return opaque(_mm_mul_ps(y, _mm_set1_ps(1.0f / 0.859f)));
+            });
+            break;
+        case core::pixel_format::ycbcr:
+        case core::pixel_format::ycbcra: {
+            const auto& coefficients = p0.height > 700 ? ycbcr_hd : ycbcr_sd;
+            const auto  has_alpha    = desc.format == core::pixel_format::ycbcra && planes.size() > 3;
+            sample_row(u, v, du, dv, count, out, [&](double u, double v) {
+                auto y  = sample_plane(p0, u, v, nearest);
+                auto cb = sample_plane(planes.at(1), u, v, nearest);
+                auto cr = sample_plane(planes.at(2), u, v, nearest);
+                auto a  = has_alpha ? sample_plane(planes.at(3), u, v, nearest) : 255.0f;
+                return ycbcra_to_bgra(y, cb, cr, a, coefficients);
+            });
+            break;
+        }
+        case core::pixel_format::uyvy: {
+            const auto& coefficients = p0.height > 700 ? ycbcr_hd : ycbcr_sd;
+            sample_row(u, v, du, dv, count, out, [&](double u, double v) {
+                auto y      = lane(sample<2>(p0, u, v, nearest), 1);
+                auto chroma = sample<4>(planes.at(1), u, v, nearest);
+                return ycbcra_to_bgra(y, lane(chroma, 0), lane(chroma, 2), 255.0f, coefficients);
+            });
+            break;
+        }
+        default:
+            std::fill(out, out + count, _mm_setzero_ps());
+            break;
+    }
+}
+
+// Image adjustments, mirrors the OpenGL image shader.
+
+float levels_control(float color, const core::levels& levels)
+{
+    auto input = std::min(std::max(color - static_cast<float>(levels.min_input), 0.0f) /
+                              static_cast<float>(levels.max_input - levels.min_input),
+                          1.0f);
+    auto gamma = std::pow(input, static_cast<float>(1.0 / levels.gamma));
+    return static_cast<float>(levels.min_output + (levels.max_output - levels.min_output) * gamma);
+}
+
+void apply_levels(__m128* row, int count, const core::levels& levels)
+{
+    for (int n = 0; n < count; ++n) {
+        alignas(16) float c[4];
+        _mm_store_ps(c, row[n]);
+        for (int i = 0; i < 3; ++i)
+            c[i] = levels_control(c[i], levels);
+        row[n] = _mm_load_ps(c);
+    }
+}
+
+void apply_csb(__m128* row, int count, const core::image_transform& transform, bool is_hd)
+{
+    auto brt       = _mm_set1_ps(static_cast<float>(transform.brightness));
+    auto sat       = _mm_set1_ps(static_cast<float>(transform.saturation));
+    auto con       = _mm_set1_ps(static_cast<float>(transform.contrast));
+    auto avg_lumin = _mm_set1_ps(0.5f);
+    auto lum_coeff = is_hd ? _mm_setr_ps(0.0722f, 0.7152f, 0.2126f, 0.0f) : _mm_setr_ps(0.114f, 0.587f, 0.299f, 0.0f);
+
+    for (int n = 0; n < count; ++n) {
+        auto color = row[n];
+        auto alpha = _mm_shuffle_ps(color, color, _MM_SHUFFLE(3, 3, 3, 3));
+
+        if (_mm_cvtss_f32(alpha) > 0.0f)
+            color = _mm_div_ps(color, alpha);
+
+        auto brt_color = _mm_mul_ps(color, brt);
+        auto intensity = _mm_dp_ps(brt_color, lum_coeff, 0x7F);
+        auto sat_color = _mm_add_ps(intensity, _mm_mul_ps(_mm_sub_ps(brt_color, intensity), sat));
+        auto con_color = _mm_add_ps(avg_lumin, _mm_mul_ps(_mm_sub_ps(sat_color, avg_lumin), con));
+
+        row[n] = _mm_blend_ps(_mm_mul_ps(con_color, alpha), alpha, 8);
+    }
+}
+
+void apply_key(__m128* row, int count, const float* key)
+{
+    for (int n = 0; n < count; ++n)
+        row[n] = _mm_mul_ps(row[n], _mm_set1_ps(key[n]));
+}
+
+void apply_opacity(__m128* row, int count, float opacity)
+{
+    auto factor = _mm_set1_ps(opacity);
+    for (int n = 0; n < count; ++n)
+        row[n] = _mm_mul_ps(row[n], factor);
+}
+
+void apply_invert(__m128* row, int count)
+{
+    auto one = _mm_set1_ps(1.0f);
+    for (int n = 0; n < count; ++n)
+        row[n] = _mm_sub_ps(one, row[n]);
+}
+
+// Blend modes, mirrors get_blend_color in the OpenGL image shader. Colors are straight, in BGRA order.
+
+using blend_function = float (*)(float base, float blend);
+
+float blend_add(float base, float blend) { return std::min(base + blend, 1.0f); }
+float blend_subtract(float base, float blend) { return std::max(base + blend - 1.0f, 0.0f); }
+float blend_lighten(float base, float blend) { return std::max(blend, base); }
+float blend_darken(float base, float blend) { return std::min(blend, base); }
+float blend_multiply(float base, float blend) { return base * blend; }
+float blend_average(float base, float blend) { return (base + blend) / 2.0f; }
+float blend_difference(float base, float blend) { return std::abs(base - blend); }
+float blend_negation(float base, float blend) { return 1.0f - std::abs(1.0f - base - blend); }
+float blend_exclusion(float base, float blend) { return base + blend - 2.0f * base * blend; }
+float blend_screen(float base, float blend) { return 1.0f - ((1.0f - base) * (1.0f - blend)); }
+float blend_overlay(float base, float blend)
+{
+    return base < 0.5f ? (2.0f * base * blend) : (1.0f - 2.0f * (1.0f - base) * (1.0f - blend));
+}
+float blend_hard_light(float base, float blend) { return blend_overlay(blend, base); }
+float blend_color_dodge(float base, float blend)
+{
+    return blend == 1.0f ? blend : std::min(base / (1.0f - blend), 1.0f);
+}
+float blend_color_burn(float base, float blend)
+{
+    return blend == 0.0f ? blend : std::max(1.0f - ((1.0f - base) / blend), 0.0f);
+}
+float blend_linear_light(float base, float blend)
+{
+    return blend < 0.5f ? blend_subtract(base, 2.0f * blend) : blend_add(base, 2.0f * (blend - 0.5f));
+}
+float blend_vivid_light(float base, float blend)
+{
+    return blend < 0.5f ? blend_color_burn(base, 2.0f * blend) : blend_color_dodge(base, 2.0f * (blend - 0.5f));
+}
+float blend_pin_light(float base, float blend)
+{
+    return blend < 0.5f ? blend_darken(base, 2.0f * blend) : blend_lighten(base, 2.0f * (blend - 0.5f));
+}
+float blend_hard_mix(float base, float blend) { return blend_vivid_light(base, blend) < 0.5f ? 0.0f : 1.0f; }
+float blend_reflect(float base, float blend)
+{
+    return blend == 1.0f ? blend : std::min(base * base / (1.0f - blend), 1.0f);
+}
+float blend_glow(float base, float blend) { return blend_reflect(blend, base); }
+float blend_phoenix(float base, float blend) { return std::min(base, blend) - std::max(base, blend) + 1.0f; }
+
+std::array<float, 3> rgb_to_hsl(const float* color)
+{
+    std::array<float, 3> hsl{};
+
+    auto fmin  = std::min(std::min(color[0], color[1]), color[2]);
+    auto fmax  = std::max(std::max(color[0], color[1]), color[2]);
+    auto delta = fmax - fmin;
+
+    hsl[2] = (fmax + fmin) / 2.0f;
+
+    if (delta == 0.0f)
+        return hsl;
+
+    hsl[1] = hsl[2] < 0.5f ? delta / (fmax + fmin) : delta / (2.0f - fmax - fmin);
+
+    auto delta_r = (((fmax - color[0]) / 6.0f) + (delta / 2.0f)) / delta;
+    auto delta_g = (((fmax - color[1]) / 6.0f) + (delta / 2.0f)) / delta;
+    auto delta_b = (((fmax - color[2]) / 6.0f) + (delta / 2.0f)) / delta;
+
+    if (color[0] == fmax)
+        hsl[0] = delta_b - delta_g;
+    else if (color[1] == fmax)
+        hsl[0] = (1.0f / 3.0f) + delta_r - delta_b;
+    else
+        hsl[0] = (2.0f / 3.0f) + delta_g - delta_r;
+
+    if (hsl[0] < 0.0f)
+        hsl[0] += 1.0f;
+    else if (hsl[0] > 1.0f)
+        hsl[0] -= 1.0f;
+
+    return hsl;
+}
+
+float hue_to_rgb(float f1, float f2, float hue)
+{
+    if (hue < 0.0f)
+        hue += 1.0f;
+    else if (hue > 1.0f)
+        hue -= 1.0f;
+
+    if ((6.0f * hue) < 1.0f)
+        return f1 + (f2 - f1) * 6.0f * hue;
+    if ((2.0f * hue) < 1.0f)
+        return f2;
+    if ((3.0f * hue) < 2.0f)
+        return f1 + (f2 - f1) * ((2.0f / 3.0f) - hue) * 6.0f;
+    return f1;
+}
+
+void hsl_to_rgb(const std::array<float, 3>& hsl, float* color)
+{
+    if (hsl[1] == 0.0f) {
+        color[0] = color[1] = color[2] = hsl[2];
+        return;
+    }
+
+    auto f2 = hsl[2] < 0.5f ? hsl[2] * (1.0f + hsl[1]) : (hsl[2] + hsl[1]) - (hsl[1] * hsl[2]);
+    auto f1 = 2.0f * hsl[2] - f2;
+
+    color[0] = hue_to_rgb(f1, f2, hsl[0] + (1.0f / 3.0f));
+    color[1] = hue_to_rgb(f1, f2, hsl[0]);
+    color[2] = hue_to_rgb(f1, f2, hsl[0] - (1.0f / 3.0f));
+}
+
+blend_function get_blend_function(core::blend_mode mode)
+{
+    switch (mode) {
+        case core::blend_mode::lighten:
+            return blend_lighten;
+        case core::blend_mode::darken:
+            return blend_darken;
+        case core::blend_mode::multiply:
+            return blend_multiply;
+        case core::blend_mode::average:
+            return blend_average;
+        case core::blend_mode::add:
+        case core::blend_mode::linear_dodge:
+            return blend_add;
+        case core::blend_mode::subtract:
+        case core::blend_mode::linear_burn:
+            return blend_subtract;
+        case core::blend_mode::difference:
+            return blend_difference;
+        case core::blend_mode::negation:
+            return blend_negation;
+        case core::blend_mode::exclusion:
+            return blend_exclusion;
+        case core::blend_mode::screen:
+            return blend_screen;
+        case core::blend_mode::overlay:
+            return blend_overlay;
+        case core::blend_mode::hard_light:
+            return blend_hard_light;
+        case core::blend_mode::color_dodge:
+            return blend_color_dodge;
+        case core::blend_mode::color_burn:
+            return blend_color_burn;
+        case core::blend_mode::linear_light:
+            return blend_linear_light;
+        case core::blend_mode::vivid_light:
+            return blend_vivid_light;
+        case core::blend_mode::pin_light:
+            return blend_pin_light;
+        case core::blend_mode::hard_mix:
+            return blend_hard_mix;
+        case core::blend_mode::reflect:
+            return blend_reflect;
+        case core::blend_mode::glow:
+            return blend_glow;
+        case core::blend_mode::phoenix:
+            return blend_phoenix;
+        default: // soft_light is disabled in the shader as well.
+            return nullptr;
+    }
+}
+
+void blend_color(core::blend_mode mode, blend_function func, const float* back, float* fore)
+{
+    if (func != nullptr) {
+        for (int i = 0; i < 3; ++i)
+            fore[i] = func(back[i], fore[i]);
+        return;
+    }
+
+    // The shader maps the remaining modes by index, contrast being its hue blend.
+    switch (mode) {
+        case core::blend_mode::contrast: {
+            auto base = rgb_to_hsl(back);
+            hsl_to_rgb({rgb_to_hsl(fore)[0], base[1], base[2]}, fore);
+            break;
+        }
+        case core::blend_mode::saturation: {
+            auto base = rgb_to_hsl(back);
+            hsl_to_rgb({base[0], rgb_to_hsl(fore)[1], base[2]}, fore);
+            break;
+        }
+        case core::blend_mode::color: {
+            auto blend = rgb_to_hsl(fore);
+            hsl_to_rgb({blend[0], blend[1], rgb_to_hsl(back)[2]}, fore);
+            break;
+        }
+        case core::blend_mode::luminosity: {
+            auto base = rgb_to_hsl(back);
+            hsl_to_rgb({base[0], base[1], rgb_to_hsl(fore)[2]}, fore);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+bool is_normal_blend(core::blend_mode mode)
+{
+    return mode == core::blend_mode::normal || mode == core::blend_mode::soft_light || mode == core::blend_mode::mix;
+}
+
+void blend_row(const draw_params& params, __m128* row, int count, float* target)
+{
+    auto zero = _mm_setzero_ps();
+    auto one  = _mm_set1_ps(1.0f);
+
+    if (params.background->channels() == 1) {
+        for (int n = 0; n < count; ++n) {
+            auto fore = row[n];
+            auto key  = _mm_set_ss(target[n]);
+            auto red  = _mm_shuffle_ps(fore, fore, _MM_SHUFFLE(2, 2, 2, 2));
+            auto back = params.keyer == keyer::additive
+                            ? key
+                            : _mm_mul_ss(key, _mm_sub_ss(one, _mm_shuffle_ps(fore, fore, _MM_SHUFFLE(3, 3, 3, 3))));
+            _mm_store_ss(target + n, _mm_min_ss(_mm_max_ss(_mm_add_ss(red, back), zero), one));
+        }
+        return;
+    }
+
+    auto mode = params.transform.is_key ? core::blend_mode::normal : params.blend_mode;
+    auto func = get_blend_function(mode);
+
+    for (int n = 0; n < count; ++n) {
+        auto fore = row[n];
+        auto back = _mm_load_ps(target + n * 4);
+
+        if (!is_normal_blend(mode)) {
+            alignas(16) float f[4];
+            alignas(16) float b[4];
+            _mm_store_ps(f, fore);
+            _mm_store_ps(b, back);
+
+            auto fore_alpha = f[3];
+            for (int i = 0; i < 3; ++i) {
+                b[i] /= b[3] + 0.0000001f;
+                f[i] /= fore_alpha + 0.0000001f;
+            }
+
+            blend_color(mode, func, b, f);
+
+            for (int i = 0; i < 3; ++i)
+                f[i] *= fore_alpha;
+            fore = _mm_load_ps(f);
+        }
+
+        if (params.keyer == keyer::linear)
+            back = _mm_mul_ps(back, _mm_sub_ps(one, _mm_shuffle_ps(fore, fore, _MM_SHUFFLE(3, 3, 3, 3))));
+
+        _mm_store_ps(target + n * 4, _mm_min_ps(_mm_max_ps(_mm_add_ps(fore, back), zero), one));
+    }
+}
+
+} // namespace
+
+struct image_kernel::impl
+{
+    void draw(const draw_params& params)
+    {
+        if (!params.background)
+            return;
+
+        if (params.transform.opacity < epsilon)
+            return;
+
+        auto& target = *params.background;
+
+        std::vector<plane_view> planes;
+        int                     source_width  = target.width();
+        int                     source_height = target.height();
+
+        if (params.source) {
+            source_width  = params.source->width();
+            source_height = params.source->height();
+        } else {
+            const auto& desc = params.frame.pixel_format_desc();
+
+            if (desc.planes.empty() || desc.format == core::pixel_format::invalid)
+                return;
+
+            for (int n = 0; n < static_cast<int>(desc.planes.size()); ++n) {
+                plane_view plane;
+                plane.data     = params.frame.image_data(n).data();
+                plane.width    = desc.planes[n].width;
+                plane.height   = desc.planes[n].height;
+                plane.linesize = desc.planes[n].linesize;
+
+                if (plane.data == nullptr || plane.width < 1 || plane.height < 1)
+                    return;
+
+                planes.push_back(plane);
+            }
+
+            source_width  = planes[0].width;
+            source_height = planes[0].height;
+        }
+
+        mapping m;
+        if (!make_mapping(params, target.width(), target.height(), source_width, source_height, m))
+            return;
+
+        const auto& transform = params.transform;
+
+        const bool levels = transform.levels.min_input > epsilon || transform.levels.max_input < 1.0 - epsilon ||
+                            transform.levels.min_output > epsilon || transform.levels.max_output < 1.0 - epsilon ||
+                            std::abs(transform.levels.gamma - 1.0) > epsilon;
+        const bool csb = std::abs(transform.brightness - 1.0) > epsilon ||
+                         std::abs(transform.saturation - 1.0) > epsilon ||
+                         std::abs(transform.contrast - 1.0) > epsilon;
+        const bool is_hd   = !planes.empty() && planes[0].height > 700;
+        const auto opacity = static_cast<float>(transform.is_key ? 1.0 : transform.opacity);
+
+        tbb::parallel_for(tbb::blocked_range<int>(m.y0, m.y1, row_tile), [&](const tbb::blocked_range<int>& r) {
+            pixel_row buffer((m.x1 - m.x0) * 4);
+            auto      row = reinterpret_cast<__m128*>(buffer.data());
+
+            for (auto y = r.begin(); y != r.end(); ++y) {
+                auto yc    = y + 0.5;
+                auto begin = m.x0;
+                auto end   = m.x1;
+
+                clip_span(m.s, yc, begin, end);
+                clip_span(m.t, yc, begin, end);
+
+                if (begin >= end)
+                    continue;
+
+                auto count = end - begin;
+                auto xc    = begin + 0.5;
+
+                if (params.source) {
+                    // Intermediate surfaces are always drawn untransformed onto a target of the same size.
+                    auto source = params.source->row(y) + begin * 4;
+                    for (int n = 0; n < count; ++n)
+                        row[n] = _mm_load_ps(source + n * 4);
+                } else {
+                    fetch_row(params.frame.pixel_format_desc(),
+                              planes,
+                              m.nearest,
+                              m.u(xc, yc),
+                              m.v(xc, yc),
+                              m.u.dx,
+                              m.v.dx,
+                              count,
+                              row);
+                }
+
+                if (levels)
+                    apply_levels(row, count, transform.levels);
+
+                if (csb)
+                    apply_csb(row, count, transform, is_hd);
+
+                if (params.local_key)
+                    apply_key(row, count, params.local_key->row(y) + begin);
+
+                if (params.layer_key)
+                    apply_key(row, count, params.layer_key->row(y) + begin);
+
+                if (opacity < 1.0f - epsilon)
+                    apply_opacity(row, count, opacity);
+
+                if (transform.invert)
+                    apply_invert(row, count);
+
+                blend_row(params, row, count, target.row(y) + begin * target.channels());
+            }
+        });
+    }
+};
+
+image_kernel::image_kernel()
+    : impl_(new impl())
+{
+}
+image_kernel::~image_kernel() {}
+void image_kernel::draw(const draw_params& params) { impl_->draw(params); }
+
+}}} // namespace caspar::accelerator::cpu
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+
+#pragma once
+
+#include <core/mixer/image/blend_modes.h>
+
+#include <common/memory.h>
+
+#include <core/frame/frame.h>
+#include <core/frame/frame_transform.h>
+#include <core/frame/geometry.h>
+#include <core/frame/pixel_format.h>
+
+#include <tbb/cache_aligned_allocator.h>
+
+#include <vector>
+
+namespace caspar { namespace accelerator { namespace cpu {
+
+enum class keyer
+{
+    linear = 0,
+    additive,
+};
+
+/**
+ * Render target of the cpu mixer. Pixels are premultiplied floats in BGRA order, a key target has a single channel.
+ */
+class surface final
+{
+  public:
+    surface(int width, int height, int channels);
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int channels() const { return channels_; }
+
+    float*       row(int y) { return data_.data() + static_cast<std::size_t>(y) * width_ * channels_; }
+    const float* row(int y) const { return data_.data() + static_cast<std::size_t>(y) * width_ * channels_; }
+
+    void clear();
+
+  private:
+    int                                                     width_;
+    int                                                     height_;
+    int                                                     channels_;
+    std::vector<float, tbb::cache_aligned_allocator<float>> data_;
+};
+
+struct draw_params final
+{
+    core::const_frame              frame;
+    std::shared_ptr<const surface> source;
+    core::image_transform          transform;
+    core::frame_geometry           geometry   = core::frame_geometry::get_default();
+    core::blend_mode               blend_mode = core::blend_mode::normal;
+    cpu::keyer                     keyer      = cpu::keyer::linear;
+    std::shared_ptr<surface>       background;
+    std::shared_ptr<const surface> local_key;
+    std::shared_ptr<const surface> layer_key;
+    double                         aspect_ratio = 1.0;
+};
+
+class image_kernel final
+{
+    image_kernel(const image_kernel&);
+    image_kernel& operator=(const image_kernel&);
+
+  public:
+    image_kernel();
+    ~image_kernel();
+
+    void draw(const draw_params& params);
+
+  private:
+    struct impl;
+    spl::unique_ptr<impl> impl_;
+};
+
+}}} // namespace caspar::accelerator::cpu
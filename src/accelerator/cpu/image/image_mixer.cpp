@@ -0,0 +1,385 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+#include "image_mixer.h"
+
+#include "image_kernel.h"
+
+#include <common/array.h>
+#include <common/except.h>
+#include <common/executor.h>
+#include <common/future.h>
+#include <common/log.h>
+
+#include <core/frame/frame.h>
+#include <core/frame/frame_transform.h>
+#include <core/frame/geometry.h>
+#include <core/frame/pixel_format.h>
+#include <core/video_format.h>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <smmintrin.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace caspar { namespace accelerator { namespace cpu {
+
+struct item
+{
+    core::const_frame     frame;
+    core::image_transform transform;
+    core::frame_geometry  geometry = core::frame_geometry::get_default();
+};
+
+struct layer
+{
+    std::vector<layer> sublayers;
+    std::vector<item>  items;
+    core::blend_mode   blend_mode;
+
+    explicit layer(core::blend_mode blend_mode)
+        : blend_mode(blend_mode)
+    {
+    }
+};
+
+class image_renderer
+{
+    image_kernel                          kernel_;
+    std::vector<std::shared_ptr<surface>> surfaces_;
+    executor                              executor_;
+
+  public:
+    explicit image_renderer(int channel_id)
+        : executor_(L"cpu-image-mixer-" + std::to_wstring(channel_id))
+    {
+    }
+
+    std::future<array<const std::uint8_t>> operator()(std::vector<layer>             layers,
+                                                      const core::video_format_desc& format_desc)
+    {
+        if (layers.empty()) { // Bypass with empty frame.
+            static const std::vector<uint8_t> buffer(4096 * 4096 * 4, 0);
+            return make_ready_future(array<const std::uint8_t>(buffer.data(), format_desc.size, true));
+        }
+
+        return executor_.begin_invoke([=]() mutable -> array<const std::uint8_t> {
+            auto target = create_surface(format_desc.width, format_desc.height, 4);
+
+            draw(target, std::move(layers), format_desc);
+
+            return to_bgra8(*target);
+        });
+    }
+
+  private:
+    // Surfaces are recycled between frames, only ever touched from the executor.
+    std::shared_ptr<surface> create_surface(int width, int height, int channels)
+    {
+        for (auto& surface : surfaces_) {
+            if (surface.use_count() == 1 && surface->width() == width && surface->height() == height &&
+                surface->channels() == channels) {
+                surface->clear();
+                return surface;
+            }
+        }
+
+        surfaces_.erase(std::remove_if(surfaces_.begin(),
+                                       surfaces_.end(),
+                                       [&](const std::shared_ptr<surface>& surface) {
+                                           return surface.use_count() == 1 &&
+                                                  (surface->width() != width || surface->height() != height);
+                                       }),
+                        surfaces_.end());
+
+        surfaces_.push_back(std::make_shared<surface>(width, height, channels));
+        return surfaces_.back();
+    }
+
+    static array<const std::uint8_t> to_bgra8(const surface& source)
+    {
+        const auto width = source.width();
+
+        array<std::uint8_t> result(static_cast<std::size_t>(width) * source.height() * 4);
+
+        tbb::parallel_for(tbb::blocked_range<int>(0, source.height()), [&](const tbb::blocked_range<int>& r) {
+            auto scale = _mm_set1_ps(255.0f);
+
+            for (auto y = r.begin(); y != r.end(); ++y) {
+                auto src = source.row(y);
+                auto dst = result.data() + static_cast<std::size_t>(y) * width * 4;
+
+                int x = 0;
+                for (; x + 4 <= width; x += 4) {
+                    auto p0 = _mm_cvtps_epi32(_mm_mul_ps(_mm_load_ps(src + x * 4 + 0), scale));
+                    auto p1 = _mm_cvtps_epi32(_mm_mul_ps(_mm_load_ps(src + x * 4 + 4), scale));
+                    auto p2 = _mm_cvtps_epi32(_mm_mul_ps(_mm_load_ps(src + x * 4 + 8), scale));
+                    auto p3 = _mm_cvtps_epi32(_mm_mul_ps(_mm_load_ps(src + x * 4 + 12), scale));
+                    auto px = _mm_packus_epi16(_mm_packus_epi32(p0, p1), _mm_packus_epi32(p2, p3));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), px);
+                }
+                for (; x < width; ++x) {
+                    auto p  = _mm_cvtps_epi32(_mm_mul_ps(_mm_load_ps(src + x * 4), scale));
+                    auto px = _mm_packus_epi16(_mm_packus_epi32(p, p), _mm_setzero_si128());
+                    auto v  = _mm_cvtsi128_si32(px);
+                    std::memcpy(dst + x * 4, &v, 4);
+                }
+            }
+        });
+
+        return array<const std::uint8_t>(std::move(result));
+    }
+
+    void draw(std::shared_ptr<surface>&      target_surface,
+              std::vector<layer>             layers,
+              const core::video_format_desc& format_desc)
+    {
+        std::shared_ptr<surface> layer_key_surface;
+
+        for (auto& layer : layers) {
+            draw(target_surface, layer.sublayers, format_desc);
+            draw(target_surface, std::move(layer), layer_key_surface, format_desc);
+        }
+    }
+
+    void draw(std::shared_ptr<surface>&      target_surface,
+              layer                          layer,
+              std::shared_ptr<surface>&      layer_key_surface,
+              const core::video_format_desc& format_desc)
+    {
+        if (layer.items.empty())
+            return;
+
+        std::shared_ptr<surface> local_key_surface;
+        std::shared_ptr<surface> local_mix_surface;
+
+        if (layer.blend_mode != core::blend_mode::normal) {
+            auto layer_surface = create_surface(target_surface->width(), target_surface->height(), 4);
+
+            for (auto& item : layer.items)
+                draw(layer_surface,
+                     std::move(item),
+                     layer_key_surface,
+                     local_key_surface,
+                     local_mix_surface,
+                     format_desc);
+
+            draw(layer_surface, std::move(local_mix_surface), core::blend_mode::normal);
+            draw(target_surface, std::move(layer_surface), layer.blend_mode);
+        } else // fast path
+        {
+            for (auto& item : layer.items)
+                draw(target_surface,
+                     std::move(item),
+                     layer_key_surface,
+                     local_key_surface,
+                     local_mix_surface,
+                     format_desc);
+
+            draw(target_surface, std::move(local_mix_surface), core::blend_mode::normal);
+        }
+
+        layer_key_surface = std::move(local_key_surface);
+    }
+
+    void draw(std::shared_ptr<surface>&      target_surface,
+              item                           item,
+              std::shared_ptr<surface>&      layer_key_surface,
+              std::shared_ptr<surface>&      local_key_surface,
+              std::shared_ptr<surface>&      local_mix_surface,
+              const core::video_format_desc& format_desc)
+    {
+        draw_params draw_params;
+        draw_params.frame     = std::move(item.frame);
+        draw_params.transform = std::move(item.transform);
+        draw_params.geometry  = item.geometry;
+        draw_params.aspect_ratio =
+            static_cast<double>(format_desc.square_width) / static_cast<double>(format_desc.square_height);
+
+        if (item.transform.is_key) {
+            local_key_surface = local_key_surface
+                                    ? local_key_surface
+                                    : create_surface(target_surface->width(), target_surface->height(), 1);
+
+            draw_params.background = local_key_surface;
+            draw_params.local_key  = nullptr;
+            draw_params.layer_key  = nullptr;
+
+            kernel_.draw(draw_params);
+        } else if (item.transform.is_mix) {
+            local_mix_surface = local_mix_surface
+                                    ? local_mix_surface
+                                    : create_surface(target_surface->width(), target_surface->height(), 4);
+
+            draw_params.background = local_mix_surface;
+            draw_params.local_key  = std::move(local_key_surface);
+            draw_params.layer_key  = layer_key_surface;
+
+            draw_params.keyer = keyer::additive;
+
+            kernel_.draw(draw_params);
+        } else {
+            draw(target_surface, std::move(local_mix_surface), core::blend_mode::normal);
+
+            draw_params.background = target_surface;
+            draw_params.local_key  = std::move(local_key_surface);
+            draw_params.layer_key  = layer_key_surface;
+
+            kernel_.draw(draw_params);
+        }
+    }
+
+    void draw(std::shared_ptr<surface>&  target_surface,
+              std::shared_ptr<surface>&& source_surface,
+              core::blend_mode           blend_mode = core::blend_mode::normal)
+    {
+        if (!source_surface)
+            return;
+
+        draw_params draw_params;
+        draw_params.source     = std::move(source_surface);
+        draw_params.transform  = core::image_transform();
+        draw_params.blend_mode = blend_mode;
+        draw_params.background = target_surface;
+        draw_params.geometry   = core::frame_geometry::get_default();
+
+        kernel_.draw(draw_params);
+    }
+};
+
+struct image_mixer::impl : public core::frame_factory
+{
+    image_renderer                     renderer_;
+    std::vector<core::image_transform> transform_stack_;
+    std::vector<layer>                 layers_; // layer/stream/items
+    std::vector<layer*>                layer_stack_;
+
+  public:
+    explicit impl(int channel_id)
+        : renderer_(channel_id)
+        , transform_stack_(1)
+    {
+        CASPAR_LOG(info) << L"Initialized CPU Image Mixer for channel " << channel_id;
+    }
+
+    void push(const core::frame_transform& transform)
+    {
+        auto previous_layer_depth = transform_stack_.back().layer_depth;
+        transform_stack_.push_back(transform_stack_.back() * transform.image_transform);
+        auto new_layer_depth = transform_stack_.back().layer_depth;
+
+        if (previous_layer_depth < new_layer_depth) {
+            layer new_layer(transform_stack_.back().blend_mode);
+
+            if (layer_stack_.empty()) {
+                layers_.push_back(std::move(new_layer));
+                layer_stack_.push_back(&layers_.back());
+            } else {
+                layer_stack_.back()->sublayers.push_back(std::move(new_layer));
+                layer_stack_.push_back(&layer_stack_.back()->sublayers.back());
+            }
+        }
+    }
+
+    void visit(const core::const_frame& frame)
+    {
+        if (frame.pixel_format_desc().format == core::pixel_format::invalid)
+            return;
+
+        if (frame.pixel_format_desc().planes.empty())
+            return;
+
+        item item;
+        item.frame     = frame;
+        item.transform = transform_stack_.back();
+        item.geometry  = frame.geometry();
+
+        layer_stack_.back()->items.push_back(item);
+    }
+
+    void pop()
+    {
+        transform_stack_.pop_back();
+        layer_stack_.resize(transform_stack_.back().layer_depth);
+    }
+
+    std::future<std::vector<array<const std::uint8_t>>>
+    render(const core::video_format_desc& format_desc, const std::vector<core::output_rendition>& renditions)
+    {
+        // Conversions are left to the consumers.
+        auto image = renderer_(std::move(layers_), format_desc);
+        return std::async(std::launch::deferred, [image = std::move(image), count = renditions.size()]() mutable {
+            std::vector<array<const std::uint8_t>> images(count + 1);
+            images[0] = image.get();
+            return images;
+        });
+    }
+
+    core::mutable_frame create_frame(const void* tag, const core::pixel_format_desc& desc) override
+    {
+        std::vector<array<std::uint8_t>> image_data;
+        for (auto& plane : desc.planes) {
+            image_data.push_back(array<std::uint8_t>(plane.size));
+        }
+
+        return core::mutable_frame(tag, std::move(image_data), array<int32_t>{}, desc);
+    }
+
+#ifdef WIN32
+    core::const_frame
+    import_d3d_texture(const void* tag, const std::shared_ptr<d3d::d3d_texture2d>& d3d_texture, bool vflip) override
+    {
+        CASPAR_THROW_EXCEPTION(not_supported() << msg_info("The CPU image mixer cannot import Direct3D textures."));
+    }
+#endif
+};
+
+image_mixer::image_mixer(int channel_id)
+    : impl_(std::make_unique<impl>(channel_id))
+{
+}
+image_mixer::~image_mixer() {}
+void image_mixer::push(const core::frame_transform& transform) { impl_->push(transform); }
+void image_mixer::visit(const core::const_frame& frame) { impl_->visit(frame); }
+void image_mixer::pop() { impl_->pop(); }
+std::future<std::vector<array<const std::uint8_t>>>
+image_mixer::operator()(const core::video_format_desc&             format_desc,
+                        const std::vector<core::output_rendition>& renditions,
+                        bool                                       read_back)
+{
+    return impl_->render(format_desc, renditions);
+}
+core::mutable_frame image_mixer::create_frame(const void* tag, const core::pixel_format_desc& desc)
+{
+    return impl_->create_frame(tag, desc);
+}
+
+#ifdef WIN32
+core::const_frame
+image_mixer::import_d3d_texture(const void* tag, const std::shared_ptr<d3d::d3d_texture2d>& d3d_texture, bool vflip)
+{
+    return impl_->import_d3d_texture(tag, d3d_texture, vflip);
+}
+#endif
+}}} // namespace caspar::accelerator::cpu
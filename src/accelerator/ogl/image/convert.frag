@@ -0,0 +1,150 @@
+#version 450
+
+// Converts the BGRA mixer output to the layouts of core::output_pixel_format, scaled to width x height. Every target
+// texel is one little endian 32-bit word of the destination image, which is read back as BGRA.
+
+uniform sampler2D source;
+uniform int       format;
+uniform int       width;
+uniform int       height;
+uniform int       target_width;
+uniform int       source_width;
+uniform int       source_height;
+uniform bool      is_hd;
+
+out vec4 fragColor;
+
+const int UYVY      = 0;
+const int V210      = 1;
+const int YUV422P10 = 2;
+const int NV12      = 3;
+
+vec3 rgb(int x, int y)
+{
+    ivec2 pos = ivec2(clamp(x, 0, width - 1), clamp(y, 0, height - 1));
+    if (source_width == width && source_height == height) {
+        return texelFetch(source, pos, 0).rgb;
+    }
+
+    // Averages the source pixels covered by the pixel, each bilinear tap covering up to 2x2 of them.
+    vec2  size  = vec2(source_width, source_height);
+    vec2  scale = size / vec2(width, height);
+    ivec2 taps  = max(ivec2(ceil(scale * 0.5)), ivec2(1));
+    vec2  step  = scale / vec2(taps);
+    vec3  sum   = vec3(0.0);
+    for (int j = 0; j < taps.y; ++j) {
+        for (int i = 0; i < taps.x; ++i) {
+            sum += texture(source, (vec2(pos) * scale + (vec2(i, j) + 0.5) * step) / size).rgb;
+        }
+    }
+    return sum / float(taps.x * taps.y);
+}
+
+// Y' in [0, 1], Pb and Pr in [-0.5, 0.5].
+vec3 ypbpr(vec3 c)
+{
+    vec3  k = is_hd ? vec3(0.2126, 0.7152, 0.0722) : vec3(0.299, 0.587, 0.114);
+    float y = dot(c, k);
+    return vec3(y, (c.b - y) / (2.0 * (1.0 - k.b)), (c.r - y) / (2.0 * (1.0 - k.r)));
+}
+
+// Limited range, scale is 1.0 for 8-bit and 4.0 for 10-bit samples.
+uint quantize(float v, float offset, float range, float scale)
+{
+    return uint(clamp(round((offset + range * v) * scale), 0.0, 256.0 * scale - 1.0));
+}
+
+uint luma(float y, float scale)
+{
+    return quantize(y, 16.0, 219.0, scale);
+}
+
+uint chroma(float c, float scale)
+{
+    return quantize(c, 128.0, 224.0, scale);
+}
+
+vec2 chroma_pair(int x, int y)
+{
+    return (ypbpr(rgb(x, y)).yz + ypbpr(rgb(x + 1, y)).yz) * 0.5;
+}
+
+uint uyvy(int x, int y)
+{
+    vec3 p0 = ypbpr(rgb(x * 2, y));
+    vec3 p1 = ypbpr(rgb(x * 2 + 1, y));
+    vec2 c  = (p0.yz + p1.yz) * 0.5;
+    return chroma(c.x, 1.0) | luma(p0.x, 1.0) << 8 | chroma(c.y, 1.0) << 16 | luma(p1.x, 1.0) << 24;
+}
+
+// Four words hold the 12 samples Cb0 Y0 Cr0 Y1 Cb2 Y2 Cr2 Y3 Cb4 Y4 Cr4 Y5, three per word.
+uint v210(int x, int y)
+{
+    int  first = x / 4 * 6;
+    uint samples[12];
+    for (int n = 0; n < 3; ++n) {
+        vec3 p0 = ypbpr(rgb(first + n * 2, y));
+        vec3 p1 = ypbpr(rgb(first + n * 2 + 1, y));
+        vec2 c  = (p0.yz + p1.yz) * 0.5;
+
+        samples[n * 4 + 0] = chroma(c.x, 4.0);
+        samples[n * 4 + 1] = luma(p0.x, 4.0);
+        samples[n * 4 + 2] = chroma(c.y, 4.0);
+        samples[n * 4 + 3] = luma(p1.x, 4.0);
+    }
+    int n = (x % 4) * 3;
+    return samples[n] | samples[n + 1] << 10 | samples[n + 2] << 20;
+}
+
+uint yuv422p10(int index)
+{
+    int luma_size = width * height;
+    if (index < luma_size) {
+        return luma(ypbpr(rgb(index % width, index / width)).x, 4.0);
+    }
+    index -= luma_size;
+
+    int  chroma_width = width / 2;
+    int  plane        = index / (chroma_width * height);
+    int  offset       = index % (chroma_width * height);
+    vec2 c            = chroma_pair(offset % chroma_width * 2, offset / chroma_width);
+    return chroma(plane == 0 ? c.x : c.y, 4.0);
+}
+
+uint nv12(int index)
+{
+    int luma_size = width * height;
+    if (index < luma_size) {
+        return luma(ypbpr(rgb(index % width, index / width)).x, 1.0);
+    }
+    index -= luma_size;
+
+    int  x = index % width / 2 * 2;
+    int  y = index / width * 2;
+    vec2 c = (chroma_pair(x, y) + chroma_pair(x, y + 1)) * 0.5;
+    return chroma(index % 2 == 0 ? c.x : c.y, 1.0);
+}
+
+vec4 pack(uint word)
+{
+    return vec4((word >> 16) & 0xFFu, (word >> 8) & 0xFFu, word & 0xFFu, word >> 24) / 255.0;
+}
+
+void main()
+{
+    ivec2 pos   = ivec2(gl_FragCoord.xy);
+    int   index = pos.y * target_width + pos.x;
+    uint  word  = 0u;
+
+    if (format == UYVY) {
+        word = uyvy(pos.x, pos.y);
+    } else if (format == V210) {
+        word = v210(pos.x, pos.y);
+    } else if (format == YUV422P10) {
+        word = yuv422p10(index * 2) | yuv422p10(index * 2 + 1) << 16;
+    } else if (format == NV12) {
+        word = nv12(index * 4) | nv12(index * 4 + 1) << 8 | nv12(index * 4 + 2) << 16 | nv12(index * 4 + 3) << 24;
+    }
+
+    fragColor = pack(word);
+}
@@ -0,0 +1,8 @@
+#version 450
+
+// Full screen triangle, the fragment shader works on gl_FragCoord only.
+void main()
+{
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+#include "convert_kernel.h"
+
+#include "../util/device.h"
+#include "../util/shader.h"
+#include "../util/texture.h"
+
+#include "ogl_convert_fragment.h"
+#include "ogl_convert_vertex.h"
+
+#include <common/gl/gl_check.h>
+
+#include <GL/glew.h>
+
+#include <string>
+
+namespace caspar { namespace accelerator { namespace ogl {
+
+struct convert_kernel::impl
+{
+    spl::shared_ptr<device> ogl_;
+    std::unique_ptr<shader> shader_;
+    GLuint                  vao_;
+
+    explicit impl(const spl::shared_ptr<device>& ogl)
+        : ogl_(ogl)
+    {
+        ogl_->dispatch_sync([&] {
+            shader_ =
+                std::make_unique<shader>(std::string(convert_vertex_shader), std::string(convert_fragment_shader));
+            GL(glGenVertexArrays(1, &vao_));
+        });
+    }
+
+    ~impl()
+    {
+        ogl_->dispatch_sync([&] {
+            shader_.reset();
+            GL(glDeleteVertexArrays(1, &vao_));
+        });
+    }
+
+    std::shared_ptr<texture> convert(const std::shared_ptr<texture>& source, const core::output_rendition& rendition)
+    {
+        const auto format = rendition.format;
+        const auto width  = rendition.width > 0 ? rendition.width : source->width();
+        const auto height = rendition.height > 0 ? rendition.height : source->height();
+
+        // Every target texel is one 32-bit word of the converted image.
+        int target_width  = 0;
+        int target_height = 0;
+
+        switch (format) {
+            case core::output_pixel_format::uyvy:
+                if (width % 2 == 0) {
+                    target_width  = width / 2;
+                    target_height = height;
+                }
+                break;
+            case core::output_pixel_format::v210:
+                // 48 pixels per 128 byte aligned block.
+                target_width  = (width + 47) / 48 * 32;
+                target_height = height;
+                break;
+            case core::output_pixel_format::yuv422p10:
+                if (width % 2 == 0) {
+                    target_width  = width / 2;
+                    target_height = height * 2;
+                }
+                break;
+            case core::output_pixel_format::nv12:
+                if (width % 4 == 0 && height % 2 == 0) {
+                    target_width  = width / 4;
+                    target_height = height * 3 / 2;
+                }
+                break;
+            default:
+                break;
+        }
+
+        if (target_width <= 0 || target_height <= 0) {
+            return nullptr;
+        }
+
+        auto target = ogl_->create_texture(target_width, target_height, 4);
+
+        source->bind(0);
+
+        shader_->use();
+        shader_->set("source", 0);
+        shader_->set("format", format);
+        shader_->set("width", width);
+        shader_->set("height", height);
+        shader_->set("target_width", target_width);
+        shader_->set("source_width", source->width());
+        shader_->set("source_height", source->height());
+        shader_->set("is_hd", source->height() > 700);
+
+        GL(glViewport(0, 0, target_width, target_height));
+        glDisable(GL_DEPTH_TEST);
+
+        target->attach();
+
+        GL(glBindVertexArray(vao_));
+        GL(glDrawArrays(GL_TRIANGLES, 0, 3));
+        GL(glBindVertexArray(0));
+
+        return target;
+    }
+};
+
+convert_kernel::convert_kernel(const spl::shared_ptr<device>& ogl)
+    : impl_(new impl(ogl))
+{
+}
+convert_kernel::~convert_kernel() {}
+std::shared_ptr<texture> convert_kernel::convert(const std::shared_ptr<texture>& source,
+                                                 const core::output_rendition&   rendition)
+{
+    return impl_->convert(source, rendition);
+}
+
+}}} // namespace caspar::accelerator::ogl
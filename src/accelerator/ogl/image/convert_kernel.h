@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+
+#pragma once
+
+#include <common/memory.h>
+
+#include <core/frame/pixel_format.h>
+
+#include <memory>
+
+namespace caspar { namespace accelerator { namespace ogl {
+
+class convert_kernel final
+{
+    convert_kernel(const convert_kernel&);
+    convert_kernel& operator=(const convert_kernel&);
+
+  public:
+    explicit convert_kernel(const spl::shared_ptr<class device>& ogl);
+    ~convert_kernel();
+
+    // Renders source, scaled to the size of the rendition, into a texture holding its bytes in the layout of the
+    // rendition. Returns nullptr if the dimensions are not supported by the layout. Must be called on the device
+    // thread.
+    std::shared_ptr<class texture> convert(const std::shared_ptr<class texture>& source,
+                                           const core::output_rendition&         rendition);
+
+  private:
+    struct impl;
+    spl::unique_ptr<impl> impl_;
+};
+
+}}} // namespace caspar::accelerator::ogl
@@ -94,6 +94,12 @@ bool is_left_of_screen(double x) { return x < 0.0; }
 
 bool is_right_of_screen(double x) { return x > 1.0; }
 
+// The shader works on 8-bit code values, i.e. 10-bit 940 should sample as 235 / 255 rather than 940 / 1023.
+float precision_factor(bit_depth depth)
+{
+    return depth == bit_depth::bit8 ? 1.0f : 65535.0f / (255 << (bits_per_sample(depth) - 8));
+}
+
 bool is_outside_screen(const std::vector<core::frame_geometry::coord>& coords)
 {
     auto x_coords =
@@ -106,20 +112,124 @@ bool is_outside_screen(const std::vector<core::frame_geometry::coord>& coords)
            boost::algorithm::all_of(y_coords, &is_above_screen) || boost::algorithm::all_of(y_coords, &is_below_screen);
 }
 
+// The uniforms of image.frag, resolved once per kernel so that draws don't look them up by name.
+enum class uniform
+{
+    plane0,
+    plane1,
+    plane2,
+    plane3,
+    precision_factor0,
+    precision_factor1,
+    precision_factor2,
+    precision_factor3,
+    local_key,
+    layer_key,
+    is_hd,
+    has_local_key,
+    has_layer_key,
+    pixel_format,
+    opacity,
+    chroma,
+    chroma_show_mask,
+    chroma_target_hue,
+    chroma_hue_width,
+    chroma_min_saturation,
+    chroma_min_brightness,
+    chroma_softness,
+    chroma_spill_suppress,
+    chroma_spill_suppress_saturation,
+    background,
+    blend_mode,
+    keyer,
+    invert,
+    levels,
+    min_input,
+    max_input,
+    min_output,
+    max_output,
+    gamma,
+    csb,
+    brt,
+    sat,
+    con,
+    count
+};
+
+const char* const uniform_names[] = {"plane[0]",
+                                     "plane[1]",
+                                     "plane[2]",
+                                     "plane[3]",
+                                     "precision_factor[0]",
+                                     "precision_factor[1]",
+                                     "precision_factor[2]",
+                                     "precision_factor[3]",
+                                     "local_key",
+                                     "layer_key",
+                                     "is_hd",
+                                     "has_local_key",
+                                     "has_layer_key",
+                                     "pixel_format",
+                                     "opacity",
+                                     "chroma",
+                                     "chroma_show_mask",
+                                     "chroma_target_hue",
+                                     "chroma_hue_width",
+                                     "chroma_min_saturation",
+                                     "chroma_min_brightness",
+                                     "chroma_softness",
+                                     "chroma_spill_suppress",
+                                     "chroma_spill_suppress_saturation",
+                                     "background",
+                                     "blend_mode",
+                                     "keyer",
+                                     "invert",
+                                     "levels",
+                                     "min_input",
+                                     "max_input",
+                                     "min_output",
+                                     "max_output",
+                                     "gamma",
+                                     "csb",
+                                     "brt",
+                                     "sat",
+                                     "con"};
+
+static_assert(sizeof(uniform_names) / sizeof(uniform_names[0]) == static_cast<size_t>(uniform::count),
+              "uniform_names must match uniform");
+
 struct image_kernel::impl
 {
-    spl::shared_ptr<device> ogl_;
-    spl::shared_ptr<shader> shader_;
-    GLuint                  vao_;
-    GLuint                  vbo_;
+    spl::shared_ptr<device>                                ogl_;
+    spl::shared_ptr<shader>                                shader_;
+    GLuint                                                 vao_;
+    GLuint                                                 vbo_;
+    std::array<GLint, static_cast<size_t>(uniform::count)> locations_;
 
     explicit impl(const spl::shared_ptr<device>& ogl)
         : ogl_(ogl)
         , shader_(ogl_->dispatch_sync([&] { return get_image_shader(ogl); }))
     {
         ogl_->dispatch_sync([&] {
-            GL(glGenVertexArrays(1, &vao_));
-            GL(glGenBuffers(1, &vbo_));
+            for (size_t n = 0; n < locations_.size(); ++n) {
+                locations_[n] = shader_->get_uniform_location(uniform_names[n]);
+            }
+
+            // The vertex layout never changes, only the buffer contents do.
+            GL(glCreateBuffers(1, &vbo_));
+            GL(glCreateVertexArrays(1, &vao_));
+            GL(glVertexArrayVertexBuffer(vao_, 0, vbo_, 0, static_cast<GLsizei>(sizeof(core::frame_geometry::coord))));
+
+            const auto vtx_loc = shader_->get_attrib_location("Position");
+            const auto tex_loc = shader_->get_attrib_location("TexCoordIn");
+
+            GL(glEnableVertexArrayAttrib(vao_, vtx_loc));
+            GL(glVertexArrayAttribFormat(vao_, vtx_loc, 2, GL_DOUBLE, GL_FALSE, 0));
+            GL(glVertexArrayAttribBinding(vao_, vtx_loc, 0));
+
+            GL(glEnableVertexArrayAttrib(vao_, tex_loc));
+            GL(glVertexArrayAttribFormat(vao_, tex_loc, 4, GL_DOUBLE, GL_FALSE, 2 * sizeof(GLdouble)));
+            GL(glVertexArrayAttribBinding(vao_, tex_loc, 0));
         });
     }
 
@@ -131,6 +241,12 @@ struct image_kernel::impl
         });
     }
 
+    template <typename T>
+    void set(uniform u, T value)
+    {
+        shader_->set(locations_[static_cast<size_t>(u)], value);
+    }
+
     void draw(draw_params params)
     {
         static const double epsilon = 0.001;
@@ -239,30 +355,36 @@ struct image_kernel::impl
 
         shader_->use();
 
-        shader_->set("plane[0]", texture_id::plane0);
-        shader_->set("plane[1]", texture_id::plane1);
-        shader_->set("plane[2]", texture_id::plane2);
-        shader_->set("plane[3]", texture_id::plane3);
-        shader_->set("local_key", texture_id::local_key);
-        shader_->set("layer_key", texture_id::layer_key);
-        shader_->set("is_hd", params.pix_desc.planes.at(0).height > 700 ? 1 : 0);
-        shader_->set("has_local_key", static_cast<bool>(params.local_key));
-        shader_->set("has_layer_key", static_cast<bool>(params.layer_key));
-        shader_->set("pixel_format", params.pix_desc.format);
-        shader_->set("opacity", params.transform.is_key ? 1.0 : params.transform.opacity);
+        set(uniform::plane0, texture_id::plane0);
+        set(uniform::plane1, texture_id::plane1);
+        set(uniform::plane2, texture_id::plane2);
+        set(uniform::plane3, texture_id::plane3);
+
+        for (int n = 0; n < static_cast<int>(params.pix_desc.planes.size()) && n < 4; ++n) {
+            set(static_cast<uniform>(static_cast<int>(uniform::precision_factor0) + n),
+                precision_factor(params.pix_desc.planes[n].depth));
+        }
+
+        set(uniform::local_key, texture_id::local_key);
+        set(uniform::layer_key, texture_id::layer_key);
+        set(uniform::is_hd, params.pix_desc.planes.at(0).height > 700 ? 1 : 0);
+        set(uniform::has_local_key, static_cast<bool>(params.local_key));
+        set(uniform::has_layer_key, static_cast<bool>(params.layer_key));
+        set(uniform::pixel_format, params.pix_desc.format);
+        set(uniform::opacity, params.transform.is_key ? 1.0 : params.transform.opacity);
 
         if (params.transform.chroma.enable) {
-            shader_->set("chroma", true);
-            shader_->set("chroma_show_mask", params.transform.chroma.show_mask);
-            shader_->set("chroma_target_hue", params.transform.chroma.target_hue / 360.0);
-            shader_->set("chroma_hue_width", params.transform.chroma.hue_width);
-            shader_->set("chroma_min_saturation", params.transform.chroma.min_saturation);
-            shader_->set("chroma_min_brightness", params.transform.chroma.min_brightness);
-            shader_->set("chroma_softness", 1.0 + params.transform.chroma.softness);
-            shader_->set("chroma_spill_suppress", params.transform.chroma.spill_suppress / 360.0);
-            shader_->set("chroma_spill_suppress_saturation", params.transform.chroma.spill_suppress_saturation);
+            set(uniform::chroma, true);
+            set(uniform::chroma_show_mask, params.transform.chroma.show_mask);
+            set(uniform::chroma_target_hue, params.transform.chroma.target_hue / 360.0);
+            set(uniform::chroma_hue_width, params.transform.chroma.hue_width);
+            set(uniform::chroma_min_saturation, params.transform.chroma.min_saturation);
+            set(uniform::chroma_min_brightness, params.transform.chroma.min_brightness);
+            set(uniform::chroma_softness, 1.0 + params.transform.chroma.softness);
+            set(uniform::chroma_spill_suppress, params.transform.chroma.spill_suppress / 360.0);
+            set(uniform::chroma_spill_suppress_saturation, params.transform.chroma.spill_suppress_saturation);
         } else {
-            shader_->set("chroma", false);
+            set(uniform::chroma, false);
         }
 
         // Setup blend_func
@@ -272,36 +394,36 @@ struct image_kernel::impl
         }
 
         params.background->bind(static_cast<int>(texture_id::background));
-        shader_->set("background", texture_id::background);
-        shader_->set("blend_mode", params.blend_mode);
-        shader_->set("keyer", params.keyer);
+        set(uniform::background, texture_id::background);
+        set(uniform::blend_mode, params.blend_mode);
+        set(uniform::keyer, params.keyer);
 
         // Setup image-adjustements
-        shader_->set("invert", params.transform.invert);
+        set(uniform::invert, params.transform.invert);
 
         if (params.transform.levels.min_input > epsilon || params.transform.levels.max_input < 1.0 - epsilon ||
             params.transform.levels.min_output > epsilon || params.transform.levels.max_output < 1.0 - epsilon ||
             std::abs(params.transform.levels.gamma - 1.0) > epsilon) {
-            shader_->set("levels", true);
-            shader_->set("min_input", params.transform.levels.min_input);
-            shader_->set("max_input", params.transform.levels.max_input);
-            shader_->set("min_output", params.transform.levels.min_output);
-            shader_->set("max_output", params.transform.levels.max_output);
-            shader_->set("gamma", params.transform.levels.gamma);
+            set(uniform::levels, true);
+            set(uniform::min_input, params.transform.levels.min_input);
+            set(uniform::max_input, params.transform.levels.max_input);
+            set(uniform::min_output, params.transform.levels.min_output);
+            set(uniform::max_output, params.transform.levels.max_output);
+            set(uniform::gamma, params.transform.levels.gamma);
         } else {
-            shader_->set("levels", false);
+            set(uniform::levels, false);
         }
 
         if (std::abs(params.transform.brightness - 1.0) > epsilon ||
             std::abs(params.transform.saturation - 1.0) > epsilon ||
             std::abs(params.transform.contrast - 1.0) > epsilon) {
-            shader_->set("csb", true);
+            set(uniform::csb, true);
 
-            shader_->set("brt", params.transform.brightness);
-            shader_->set("sat", params.transform.saturation);
-            shader_->set("con", params.transform.contrast);
+            set(uniform::brt, params.transform.brightness);
+            set(uniform::sat, params.transform.saturation);
+            set(uniform::con, params.transform.contrast);
         } else {
-            shader_->set("csb", false);
+            set(uniform::csb, false);
         }
 
         // Setup drawing area
@@ -377,36 +499,19 @@ struct image_kernel::impl
         // Draw
         switch (params.geometry.type()) {
             case core::frame_geometry::geometry_type::quad: {
-                GL(glBindVertexArray(vao_));
-                GL(glBindBuffer(GL_ARRAY_BUFFER, vbo_));
-
-                std::vector<core::frame_geometry::coord> coords_triangles{
-                    coords[0], coords[1], coords[2], coords[0], coords[2], coords[3]};
-
-                GL(glBufferData(GL_ARRAY_BUFFER,
-                                static_cast<GLsizeiptr>(sizeof(core::frame_geometry::coord)) * coords_triangles.size(),
-                                coords_triangles.data(),
-                                GL_STATIC_DRAW));
+                const std::array<core::frame_geometry::coord, 6> coords_triangles{
+                    {coords[0], coords[1], coords[2], coords[0], coords[2], coords[3]}};
 
-                auto stride = static_cast<GLsizei>(sizeof(core::frame_geometry::coord));
-
-                auto vtx_loc = shader_->get_attrib_location("Position");
-                auto tex_loc = shader_->get_attrib_location("TexCoordIn");
-
-                GL(glEnableVertexAttribArray(vtx_loc));
-                GL(glEnableVertexAttribArray(tex_loc));
-
-                GL(glVertexAttribPointer(vtx_loc, 2, GL_DOUBLE, GL_FALSE, stride, nullptr));
-                GL(glVertexAttribPointer(tex_loc, 4, GL_DOUBLE, GL_FALSE, stride, (GLvoid*)(2 * sizeof(GLdouble))));
+                GL(glNamedBufferData(vbo_,
+                                     static_cast<GLsizeiptr>(sizeof(core::frame_geometry::coord)) *
+                                         coords_triangles.size(),
+                                     coords_triangles.data(),
+                                     GL_STREAM_DRAW));
 
+                GL(glBindVertexArray(vao_));
                 GL(glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(coords_triangles.size())));
                 GL(glTextureBarrier());
-
-                GL(glDisableVertexAttribArray(vtx_loc));
-                GL(glDisableVertexAttribArray(tex_loc));
-
                 GL(glBindVertexArray(0));
-                GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
 
                 break;
             }
@@ -20,6 +20,7 @@
  */
 #include "image_mixer.h"
 
+#include "convert_kernel.h"
 #include "image_kernel.h"
 
 #include "../util/buffer.h"
@@ -27,6 +28,7 @@
 #include "../util/texture.h"
 
 #include <common/array.h>
+#include <common/diagnostics/graph.h>
 #include <common/future.h>
 #include <common/log.h>
 
@@ -43,8 +45,12 @@
 #endif
 
 #include <boost/any.hpp>
+#include <boost/range/algorithm/equal.hpp>
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
 #include <vector>
 
 namespace caspar { namespace accelerator { namespace ogl {
@@ -53,12 +59,16 @@ using future_texture = std::shared_future<std::shared_ptr<texture>>;
 
 struct item
 {
+    core::const_frame           frame;
     core::pixel_format_desc     pix_desc = core::pixel_format::invalid;
     std::vector<future_texture> textures;
     core::image_transform       transform;
     core::frame_geometry        geometry = core::frame_geometry::get_default();
 };
 
+// Frames are immutable, so an item draws the same as long as its frame and transform are the same.
+bool operator==(const item& lhs, const item& rhs) { return lhs.frame == rhs.frame && lhs.transform == rhs.transform; }
+
 struct layer
 {
     std::vector<layer> sublayers;
@@ -71,45 +81,280 @@ struct layer
     }
 };
 
+bool operator==(const layer& lhs, const layer& rhs)
+{
+    return lhs.blend_mode == rhs.blend_mode && lhs.items == rhs.items && lhs.sublayers == rhs.sublayers;
+}
+
+// A normalized region of the target, in the coordinates of image_transform.
+struct area
+{
+    double left   = 0.0;
+    double top    = 0.0;
+    double right  = 1.0;
+    double bottom = 1.0;
+
+    bool empty() const { return right <= left || bottom <= top; }
+
+    bool covers_target() const { return left <= 0.0 && top <= 0.0 && right >= 1.0 && bottom >= 1.0; }
+};
+
+area intersect(const area& lhs, const area& rhs)
+{
+    return {std::max(lhs.left, rhs.left),
+            std::max(lhs.top, rhs.top),
+            std::min(lhs.right, rhs.right),
+            std::min(lhs.bottom, rhs.bottom)};
+}
+
+area unite(const area& lhs, const area& rhs)
+{
+    if (lhs.empty()) {
+        return rhs;
+    }
+    if (rhs.empty()) {
+        return lhs;
+    }
+    return {std::min(lhs.left, rhs.left),
+            std::min(lhs.top, rhs.top),
+            std::max(lhs.right, rhs.right),
+            std::max(lhs.bottom, rhs.bottom)};
+}
+
+// The part of the target that image_kernel can touch when drawing the item. It is exact for items that are only
+// cropped, scaled and translated and falls back to the clip region otherwise, which exact is set to tell.
+area get_area(const item& item, bool& exact)
+{
+    const auto& t = item.transform;
+
+    area result;
+    exact = false;
+
+    // Same condition as the scissor test of image_kernel.
+    const auto eps = std::numeric_limits<double>::epsilon();
+    if (t.clip_translation[0] > eps || t.clip_translation[1] > eps || t.clip_scale[0] < 1.0 - eps ||
+        t.clip_scale[1] < 1.0 - eps) {
+        result = intersect(result,
+                           {t.clip_translation[0],
+                            t.clip_translation[1],
+                            t.clip_translation[0] + std::max(0.0, t.clip_scale[0]),
+                            t.clip_translation[1] + std::max(0.0, t.clip_scale[1])});
+    }
+
+    auto coords              = item.geometry.data();
+    auto is_default_geometry = boost::equal(coords, core::frame_geometry::get_default().data()) ||
+                               boost::equal(coords, core::frame_geometry::get_default_vflip().data());
+
+    const core::corners p;
+    const auto&         pers = t.perspective;
+    if (!is_default_geometry || t.angle != 0.0 || pers.ul != p.ul || pers.ur != p.ur || pers.lr != p.lr ||
+        pers.ll != p.ll) {
+        return result;
+    }
+
+    exact = true;
+
+    area fill;
+    for (int n = 0; n < 2; ++n) {
+        // The default geometry spans 0 to 1, which image_kernel clamps to the crop before scaling.
+        auto v0 = (std::min(std::max(0.0, t.crop.ul[n]), t.crop.lr[n]) - t.anchor[n]) * t.fill_scale[n];
+        auto v1 = (std::min(std::max(1.0, t.crop.ul[n]), t.crop.lr[n]) - t.anchor[n]) * t.fill_scale[n];
+        (n == 0 ? fill.left : fill.top)     = std::min(v0, v1) + t.fill_translation[n];
+        (n == 0 ? fill.right : fill.bottom) = std::max(v0, v1) + t.fill_translation[n];
+    }
+
+    return intersect(result, fill);
+}
+
+bool is_opaque(core::pixel_format format)
+{
+    switch (format) {
+        case core::pixel_format::gray:
+        case core::pixel_format::ycbcr:
+        case core::pixel_format::luma:
+        case core::pixel_format::bgr:
+        case core::pixel_format::rgb:
+        case core::pixel_format::uyvy:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// True if drawing the item, unkeyed, replaces every pixel of the target. Only known for items whose area is exact.
+bool covers_target(const item& item)
+{
+    const auto& t = item.transform;
+    if (t.is_key || t.is_mix || t.invert || t.chroma.enable || t.opacity < 1.0 || !is_opaque(item.pix_desc.format)) {
+        return false;
+    }
+
+    bool exact;
+    auto item_area = get_area(item, exact);
+    return exact && item_area.covers_target();
+}
+
+// The index of the last item that hides all items before it, -1 if there is none. Items after a key item are keyed
+// and can't hide anything.
+int find_covering_item(const std::vector<item>& items)
+{
+    int result = -1;
+    for (int n = 0; n < static_cast<int>(items.size()) && !items[n].transform.is_key; ++n) {
+        if (covers_target(items[n])) {
+            result = n;
+        }
+    }
+    return result;
+}
+
+bool has_key(const layer& layer)
+{
+    return std::any_of(
+        layer.items.begin(), layer.items.end(), [](const item& item) { return item.transform.is_key; });
+}
+
 class image_renderer
 {
-    spl::shared_ptr<device> ogl_;
-    image_kernel            kernel_;
+    spl::shared_ptr<device>             ogl_;
+    bit_depth                           depth_;
+    image_kernel                        kernel_;
+    convert_kernel                      convert_kernel_;
+    std::shared_ptr<diagnostics::graph> graph_;
+
+    // The last rendered frame, which is returned again as long as the channel doesn't change.
+    std::vector<layer>                                         last_layers_;
+    core::video_format_desc                                    last_format_desc_;
+    std::vector<core::output_rendition>                        last_renditions_;
+    bool                                                       last_read_back_ = true;
+    std::shared_future<std::vector<array<const std::uint8_t>>> last_images_;
 
   public:
-    explicit image_renderer(const spl::shared_ptr<device>& ogl)
+    image_renderer(const spl::shared_ptr<device>& ogl, bit_depth depth)
         : ogl_(ogl)
+        , depth_(depth)
         , kernel_(ogl_)
+        , convert_kernel_(ogl_)
     {
     }
 
-    std::future<array<const std::uint8_t>> operator()(std::vector<layer>             layers,
-                                                      const core::video_format_desc& format_desc)
+    void set_graph(const spl::shared_ptr<diagnostics::graph>& graph)
     {
-        if (layers.empty()) { // Bypass GPU with empty frame.
+        graph->set_color("readback-time", diagnostics::color(0.4f, 0.8f, 1.0f, 0.8f));
+        graph_ = graph;
+    }
+
+    std::future<std::vector<array<const std::uint8_t>>>
+    operator()(std::vector<layer>                         layers,
+               const core::video_format_desc&             format_desc,
+               const std::vector<core::output_rendition>& renditions,
+               bool                                       read_back)
+    {
+        if (layers.empty() && renditions.empty()) { // Bypass GPU with empty frame.
             static const std::vector<uint8_t> buffer(4096 * 4096 * 4, 0);
-            return make_ready_future(array<const std::uint8_t>(buffer.data(), format_desc.size, true));
+            std::vector<array<const std::uint8_t>> images;
+            images.emplace_back(buffer.data(), format_desc.size, true);
+            return make_ready_future(std::move(images));
+        }
+
+        if (last_images_.valid() && layers == last_layers_ && format_desc == last_format_desc_ &&
+            renditions == last_renditions_ && read_back == last_read_back_) {
+            return std::async(std::launch::deferred, [images = last_images_] { return images.get(); });
         }
 
-        return flatten(ogl_->dispatch_async([=]() mutable -> std::shared_future<array<const std::uint8_t>> {
-            auto target_texture = ogl_->create_texture(format_desc.width, format_desc.height, 4);
+        auto on_latency = [graph = graph_, fps = format_desc.fps](double latency) {
+            if (graph) {
+                graph->set_value("readback-time", latency * fps * 0.5);
+            }
+        };
+
+        last_layers_      = layers;
+        last_format_desc_ = format_desc;
+        last_renditions_  = renditions;
+        last_read_back_   = read_back;
+
+        auto images = ogl_->dispatch_async([=]() mutable {
+            auto target_texture = ogl_->create_texture(format_desc.width, format_desc.height, 4, depth_);
+
+            auto textures = std::make_shared<std::vector<std::shared_ptr<texture>>>();
+            collect_textures(layers, *textures);
 
             draw(target_texture, std::move(layers), format_desc);
 
-            return ogl_->copy_async(target_texture);
-        }));
+            ogl_->retain(std::move(textures));
+
+            // The conversions are read back through the same asynchronous PBO path as the BGRA image.
+            std::vector<std::shared_future<array<const std::uint8_t>>> images;
+            if (read_back) {
+                images.emplace_back(ogl_->copy_async(target_texture, bit_depth::bit8, on_latency));
+            } else {
+                // Consumers that share the device's textures draw the target itself, once the GPU is done with it.
+                target_texture->fence();
+                images.emplace_back(make_ready_future(array<const std::uint8_t>(nullptr, 0, target_texture)));
+            }
+            for (auto& rendition : renditions) {
+                if (rendition.format == core::output_pixel_format::bgra16 && !rendition.width && !rendition.height) {
+                    images.emplace_back(ogl_->copy_async(target_texture, bit_depth::bit16));
+                    continue;
+                }
+                auto converted = convert_kernel_.convert(target_texture, rendition);
+                if (converted) {
+                    images.emplace_back(ogl_->copy_async(converted));
+                } else {
+                    images.emplace_back(make_ready_future(array<const std::uint8_t>{}));
+                }
+            }
+            return images;
+        });
+
+        auto result = std::async(std::launch::deferred, [images = std::move(images)]() mutable {
+            std::vector<array<const std::uint8_t>> result;
+            for (auto& image : images.get()) {
+                result.push_back(image.get());
+            }
+            return result;
+        });
+        last_images_ = result.share();
+
+        return std::async(std::launch::deferred, [images = last_images_] { return images.get(); });
     }
 
   private:
+    // The textures of frames from other channels may have been uploaded on other devices.
+    static void collect_textures(const std::vector<layer>& layers, std::vector<std::shared_ptr<texture>>& textures)
+    {
+        for (auto& layer : layers) {
+            for (auto& item : layer.items) {
+                for (auto& texture : item.textures) {
+                    textures.push_back(texture.get());
+                }
+            }
+            collect_textures(layer.sublayers, textures);
+        }
+    }
+
     void draw(std::shared_ptr<texture>&      target_texture,
               std::vector<layer>             layers,
               const core::video_format_desc& format_desc)
     {
         std::shared_ptr<texture> layer_key_texture;
 
-        for (auto& layer : layers) {
-            draw(target_texture, layer.sublayers, format_desc);
-            draw(target_texture, std::move(layer), layer_key_texture, format_desc);
+        // Layers below the last layer that hides the whole target aren't drawn, provided that it isn't keyed by the
+        // layer below it.
+        auto first = layers.begin();
+        for (auto it = layers.begin(); it != layers.end(); ++it) {
+            if (it->blend_mode == core::blend_mode::normal && find_covering_item(it->items) >= 0 &&
+                (it == layers.begin() || !has_key(*std::prev(it)))) {
+                first = it;
+            }
+        }
+
+        for (auto it = first; it != layers.end(); ++it) {
+            // The sublayers are drawn below the items of the layer.
+            if (layer_key_texture || it->blend_mode != core::blend_mode::normal ||
+                find_covering_item(it->items) < 0) {
+                draw(target_texture, it->sublayers, format_desc);
+            }
+            draw(target_texture, std::move(*it), layer_key_texture, format_desc);
         }
     }
 
@@ -121,11 +366,28 @@ class image_renderer
         if (layer.items.empty())
             return;
 
+        // Items hidden by a later unkeyed item of the layer aren't drawn.
+        if (!layer_key_texture) {
+            auto covering = find_covering_item(layer.items);
+            if (covering > 0) {
+                layer.items.erase(layer.items.begin(), layer.items.begin() + covering);
+            }
+        }
+
+        // The layer and mix textures are composited within the area that the items of the layer can touch.
+        area layer_area{0.0, 0.0, 0.0, 0.0};
+        for (auto& item : layer.items) {
+            if (!item.transform.is_key) {
+                bool exact;
+                layer_area = unite(layer_area, intersect(get_area(item, exact), area{}));
+            }
+        }
+
         std::shared_ptr<texture> local_key_texture;
         std::shared_ptr<texture> local_mix_texture;
 
         if (layer.blend_mode != core::blend_mode::normal) {
-            auto layer_texture = ogl_->create_texture(target_texture->width(), target_texture->height(), 4);
+            auto layer_texture = ogl_->create_texture(target_texture->width(), target_texture->height(), 4, depth_);
 
             for (auto& item : layer.items)
                 draw(layer_texture,
@@ -133,10 +395,11 @@ class image_renderer
                      layer_key_texture,
                      local_key_texture,
                      local_mix_texture,
+                     layer_area,
                      format_desc);
 
-            draw(layer_texture, std::move(local_mix_texture), core::blend_mode::normal);
-            draw(target_texture, std::move(layer_texture), layer.blend_mode);
+            draw(layer_texture, std::move(local_mix_texture), layer_area, core::blend_mode::normal);
+            draw(target_texture, std::move(layer_texture), layer_area, layer.blend_mode);
         } else // fast path
         {
             for (auto& item : layer.items)
@@ -145,9 +408,10 @@ class image_renderer
                      layer_key_texture,
                      local_key_texture,
                      local_mix_texture,
+                     layer_area,
                      format_desc);
 
-            draw(target_texture, std::move(local_mix_texture), core::blend_mode::normal);
+            draw(target_texture, std::move(local_mix_texture), layer_area, core::blend_mode::normal);
         }
 
         layer_key_texture = std::move(local_key_texture);
@@ -158,6 +422,7 @@ class image_renderer
               std::shared_ptr<texture>&      layer_key_texture,
               std::shared_ptr<texture>&      local_key_texture,
               std::shared_ptr<texture>&      local_mix_texture,
+              const area&                    layer_area,
               const core::video_format_desc& format_desc)
     {
         draw_params draw_params;
@@ -174,7 +439,8 @@ class image_renderer
         if (item.transform.is_key) {
             local_key_texture = local_key_texture
                                     ? local_key_texture
-                                    : ogl_->create_texture(target_texture->width(), target_texture->height(), 1);
+                                    : ogl_->create_texture(
+                                          target_texture->width(), target_texture->height(), 1, depth_);
 
             draw_params.background = local_key_texture;
             draw_params.local_key  = nullptr;
@@ -184,7 +450,8 @@ class image_renderer
         } else if (item.transform.is_mix) {
             local_mix_texture = local_mix_texture
                                     ? local_mix_texture
-                                    : ogl_->create_texture(target_texture->width(), target_texture->height(), 4);
+                                    : ogl_->create_texture(
+                                          target_texture->width(), target_texture->height(), 4, depth_);
 
             draw_params.background = local_mix_texture;
             draw_params.local_key  = std::move(local_key_texture);
@@ -194,7 +461,7 @@ class image_renderer
 
             kernel_.draw(std::move(draw_params));
         } else {
-            draw(target_texture, std::move(local_mix_texture), core::blend_mode::normal);
+            draw(target_texture, std::move(local_mix_texture), layer_area, core::blend_mode::normal);
 
             draw_params.background = target_texture;
             draw_params.local_key  = std::move(local_key_texture);
@@ -206,9 +473,10 @@ class image_renderer
 
     void draw(std::shared_ptr<texture>&  target_texture,
               std::shared_ptr<texture>&& source_buffer,
+              const area&                source_area,
               core::blend_mode           blend_mode = core::blend_mode::normal)
     {
-        if (!source_buffer)
+        if (!source_buffer || source_area.empty())
             return;
 
         draw_params draw_params;
@@ -221,6 +489,21 @@ class image_renderer
         draw_params.background = target_texture;
         draw_params.geometry   = core::frame_geometry::get_default();
 
+        if (!source_area.covers_target()) {
+            // Rounded out by a pixel, so that the scissor test of image_kernel can't lose the edges.
+            auto w = static_cast<double>(target_texture->width());
+            auto h = static_cast<double>(target_texture->height());
+
+            area bounds;
+            bounds.left   = std::max(0.0, (std::floor(source_area.left * w) - 1.0) / w);
+            bounds.top    = std::max(0.0, (std::floor(source_area.top * h) - 1.0) / h);
+            bounds.right  = std::min(1.0, (std::ceil(source_area.right * w) + 1.0) / w);
+            bounds.bottom = std::min(1.0, (std::ceil(source_area.bottom * h) + 1.0) / h);
+
+            draw_params.transform.clip_translation = {bounds.left, bounds.top};
+            draw_params.transform.clip_scale       = {bounds.right - bounds.left, bounds.bottom - bounds.top};
+        }
+
         kernel_.draw(std::move(draw_params));
     }
 };
@@ -231,17 +514,24 @@ struct image_mixer::impl
 {
     spl::shared_ptr<device>            ogl_;
     image_renderer                     renderer_;
+    bit_depth                          depth_;
     std::vector<core::image_transform> transform_stack_;
     std::vector<layer>                 layers_; // layer/stream/items
     std::vector<layer*>                layer_stack_;
 
+    // Uploads of frames without textures of their own, so that a frame shown on consecutive ticks is uploaded once.
+    std::map<core::const_frame, std::vector<future_texture>> uploads_;
+    std::map<core::const_frame, std::vector<future_texture>> previous_uploads_;
+
   public:
-    impl(const spl::shared_ptr<device>& ogl, int channel_id)
+    impl(const spl::shared_ptr<device>& ogl, int channel_id, bit_depth depth)
         : ogl_(ogl)
-        , renderer_(ogl)
+        , renderer_(ogl, depth)
+        , depth_(depth)
         , transform_stack_(1)
     {
-        CASPAR_LOG(info) << L"Initialized OpenGL Accelerated GPU Image Mixer for channel " << channel_id;
+        CASPAR_LOG(info) << L"Initialized OpenGL Accelerated GPU Image Mixer for channel " << channel_id << L" ("
+                         << (depth == bit_depth::bit8 ? L"8" : L"16") << L"-bit)";
     }
 
     void push(const core::frame_transform& transform)
@@ -272,6 +562,7 @@ struct image_mixer::impl
             return;
 
         item item;
+        item.frame     = frame;
         item.pix_desc  = frame.pixel_format_desc();
         item.transform = transform_stack_.back();
         item.geometry  = frame.geometry();
@@ -280,13 +571,19 @@ struct image_mixer::impl
 
         if (textures_ptr) {
             item.textures = *textures_ptr;
+        } else if (uploads_.count(frame) > 0) {
+            item.textures = uploads_[frame];
+        } else if (previous_uploads_.count(frame) > 0) {
+            item.textures = uploads_[frame] = previous_uploads_[frame];
         } else {
             for (int n = 0; n < static_cast<int>(item.pix_desc.planes.size()); ++n) {
                 item.textures.emplace_back(ogl_->copy_async(frame.image_data(n),
                                                             item.pix_desc.planes[n].width,
                                                             item.pix_desc.planes[n].height,
-                                                            item.pix_desc.planes[n].stride));
+                                                            item.pix_desc.planes[n].stride,
+                                                            item.pix_desc.planes[n].depth));
             }
+            uploads_[frame] = item.textures;
         }
 
         layer_stack_.back()->items.push_back(item);
@@ -298,9 +595,15 @@ struct image_mixer::impl
         layer_stack_.resize(transform_stack_.back().layer_depth);
     }
 
-    std::future<array<const std::uint8_t>> render(const core::video_format_desc& format_desc)
+    std::future<std::vector<array<const std::uint8_t>>>
+    render(const core::video_format_desc&             format_desc,
+           const std::vector<core::output_rendition>& renditions,
+           bool                                       read_back)
     {
-        return renderer_(std::move(layers_), format_desc);
+        previous_uploads_ = std::move(uploads_);
+        uploads_.clear();
+
+        return renderer_(std::move(layers_), format_desc, renditions, read_back);
     }
 
     core::mutable_frame create_frame(const void* tag, const core::pixel_format_desc& desc) override
@@ -323,9 +626,44 @@ struct image_mixer::impl
                 }
                 std::vector<future_texture> textures;
                 for (int n = 0; n < static_cast<int>(desc.planes.size()); ++n) {
-                    textures.emplace_back(self->ogl_->copy_async(
-                        image_data[n], desc.planes[n].width, desc.planes[n].height, desc.planes[n].stride));
+                    textures.emplace_back(self->ogl_->copy_async(image_data[n],
+                                                                 desc.planes[n].width,
+                                                                 desc.planes[n].height,
+                                                                 desc.planes[n].stride,
+                                                                 desc.planes[n].depth));
+                }
+                return std::make_shared<decltype(textures)>(std::move(textures));
+            });
+    }
+
+    // Only the regions are uploaded, the rest of the texture is copied from the one uploaded for base.
+    core::mutable_frame create_frame(const void*                            tag,
+                                     const core::pixel_format_desc&         desc,
+                                     const core::const_frame&               base,
+                                     const std::vector<core::frame_region>& regions) override
+    {
+        auto base_textures = boost::any_cast<std::shared_ptr<std::vector<future_texture>>>(&base.opaque());
+        if (!base_textures || !*base_textures || (*base_textures)->size() != 1 || desc.planes.size() != 1) {
+            return core::frame_factory::create_frame(tag, desc, base, regions);
+        }
+
+        std::vector<array<std::uint8_t>> image_data;
+        image_data.push_back(ogl_->create_array(desc.planes[0].size));
+
+        std::weak_ptr<image_mixer::impl> weak_self = shared_from_this();
+        return core::mutable_frame(
+            tag,
+            std::move(image_data),
+            array<int32_t>{},
+            desc,
+            [weak_self, base_texture = (*base_textures)->at(0), regions](
+                std::vector<array<const std::uint8_t>> image_data) -> boost::any {
+                auto self = weak_self.lock();
+                if (!self) {
+                    return boost::any{};
                 }
+                std::vector<future_texture> textures;
+                textures.emplace_back(self->ogl_->copy_async(image_data[0], base_texture, regions));
                 return std::make_shared<decltype(textures)>(std::move(textures));
             });
     }
@@ -370,24 +708,40 @@ struct image_mixer::impl
         return core::const_frame(std::move(frame));
     }
 #endif
+
+    bit_depth depth() const override { return depth_; }
+
+    void set_graph(const spl::shared_ptr<diagnostics::graph>& graph) { renderer_.set_graph(graph); }
 };
 
-image_mixer::image_mixer(const spl::shared_ptr<device>& ogl, int channel_id)
-    : impl_(std::make_unique<impl>(ogl, channel_id))
+image_mixer::image_mixer(const spl::shared_ptr<device>& ogl, int channel_id, bit_depth depth)
+    : impl_(std::make_unique<impl>(ogl, channel_id, depth))
 {
 }
 image_mixer::~image_mixer() {}
 void image_mixer::push(const core::frame_transform& transform) { impl_->push(transform); }
 void image_mixer::visit(const core::const_frame& frame) { impl_->visit(frame); }
 void image_mixer::pop() { impl_->pop(); }
-std::future<array<const std::uint8_t>> image_mixer::operator()(const core::video_format_desc& format_desc)
+std::future<std::vector<array<const std::uint8_t>>>
+image_mixer::operator()(const core::video_format_desc&             format_desc,
+                        const std::vector<core::output_rendition>& renditions,
+                        bool                                       read_back)
 {
-    return impl_->render(format_desc);
+    return impl_->render(format_desc, renditions, read_back);
 }
 core::mutable_frame image_mixer::create_frame(const void* tag, const core::pixel_format_desc& desc)
 {
     return impl_->create_frame(tag, desc);
 }
+core::mutable_frame image_mixer::create_frame(const void*                            tag,
+                                              const core::pixel_format_desc&         desc,
+                                              const core::const_frame&               base,
+                                              const std::vector<core::frame_region>& regions)
+{
+    return impl_->create_frame(tag, desc, base, regions);
+}
+bit_depth image_mixer::depth() const { return impl_->depth(); }
+void      image_mixer::set_graph(const spl::shared_ptr<diagnostics::graph>& graph) { impl_->set_graph(graph); }
 
 #ifdef WIN32
 core::const_frame
@@ -35,15 +35,24 @@ namespace caspar { namespace accelerator { namespace ogl {
 class image_mixer final : public core::image_mixer
 {
   public:
-    image_mixer(const spl::shared_ptr<class device>& ogl, int channel_id);
+    image_mixer(const spl::shared_ptr<class device>& ogl, int channel_id, bit_depth depth = bit_depth::bit8);
     image_mixer(const image_mixer&) = delete;
 
     ~image_mixer();
 
     image_mixer& operator=(const image_mixer&) = delete;
 
-    std::future<array<const std::uint8_t>> operator()(const core::video_format_desc& format_desc) override;
-    core::mutable_frame                    create_frame(const void* tag, const core::pixel_format_desc& desc) override;
+    std::future<std::vector<array<const std::uint8_t>>>
+                        operator()(const core::video_format_desc&             format_desc,
+                                   const std::vector<core::output_rendition>& renditions,
+                                   bool                                       read_back) override;
+    core::mutable_frame create_frame(const void* tag, const core::pixel_format_desc& desc) override;
+    core::mutable_frame create_frame(const void*                            tag,
+                                     const core::pixel_format_desc&         desc,
+                                     const core::const_frame&               base,
+                                     const std::vector<core::frame_region>& regions) override;
+    bit_depth           depth() const override;
+    void                set_graph(const spl::shared_ptr<diagnostics::graph>& graph) override;
 #ifdef WIN32
     core::const_frame
     import_d3d_texture(const void* tag, const std::shared_ptr<d3d::d3d_texture2d>& d3d_texture, bool vflip) override;
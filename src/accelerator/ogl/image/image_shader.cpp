@@ -26,15 +26,19 @@
 #include "ogl_image_fragment.h"
 #include "ogl_image_vertex.h"
 
+#include <map>
+#include <mutex>
+
 namespace caspar { namespace accelerator { namespace ogl {
 
-std::weak_ptr<shader> g_shader;
-std::mutex            g_shader_mutex;
+// Uniforms are program state, so devices that render concurrently need programs of their own.
+std::map<const device*, std::weak_ptr<shader>> g_shaders;
+std::mutex                                     g_shader_mutex;
 
 std::shared_ptr<shader> get_image_shader(const spl::shared_ptr<device>& ogl)
 {
     std::lock_guard<std::mutex> lock(g_shader_mutex);
-    auto                        existing_shader = g_shader.lock();
+    auto                        existing_shader = g_shaders[ogl.get()].lock();
 
     if (existing_shader) {
         return existing_shader;
@@ -54,7 +58,7 @@ std::shared_ptr<shader> get_image_shader(const spl::shared_ptr<device>& ogl)
 
     existing_shader.reset(new shader(std::string(vertex_shader), std::string(fragment_shader)), deleter);
 
-    g_shader = existing_shader;
+    g_shaders[ogl.get()] = existing_shader;
 
     return existing_shader;
 }
@@ -5,6 +5,7 @@ out vec4 fragColor;
 
 uniform sampler2D	background;
 uniform sampler2D	plane[4];
+uniform float		precision_factor[4];
 uniform sampler2D	local_key;
 uniform sampler2D	layer_key;
 
@@ -466,9 +467,10 @@ vec4 ycbcra_to_rgba(float y, float cb, float cr, float a)
         return ycbcra_to_rgba_sd(y, cb, cr, a);
 }
 
-vec4 get_sample(sampler2D sampler, vec2 coords)
+// Samples deeper than 8 bits are stored in the low bits of 16-bit textures and are scaled to 8-bit code values.
+vec4 get_sample(int index, vec2 coords)
 {
-    return texture2D(sampler, coords);
+    return texture2D(plane[index], coords) * precision_factor[index];
 }
 
 vec4 get_rgba_color()
@@ -476,44 +478,44 @@ vec4 get_rgba_color()
     switch(pixel_format)
     {
     case 0:		//gray
-        return vec4(get_sample(plane[0], TexCoord.st / TexCoord.q).rrr, 1.0);
+        return vec4(get_sample(0, TexCoord.st / TexCoord.q).rrr, 1.0);
     case 1:		//bgra,
-        return get_sample(plane[0], TexCoord.st / TexCoord.q).bgra;
+        return get_sample(0, TexCoord.st / TexCoord.q).bgra;
     case 2:		//rgba,
-        return get_sample(plane[0], TexCoord.st / TexCoord.q).rgba;
+        return get_sample(0, TexCoord.st / TexCoord.q).rgba;
     case 3:		//argb,
-        return get_sample(plane[0], TexCoord.st / TexCoord.q).argb;
+        return get_sample(0, TexCoord.st / TexCoord.q).argb;
     case 4:		//abgr,
-        return get_sample(plane[0], TexCoord.st / TexCoord.q).gbar;
+        return get_sample(0, TexCoord.st / TexCoord.q).gbar;
     case 5:		//ycbcr,
         {
-            float y  = get_sample(plane[0], TexCoord.st / TexCoord.q).r;
-            float cb = get_sample(plane[1], TexCoord.st / TexCoord.q).r;
-            float cr = get_sample(plane[2], TexCoord.st / TexCoord.q).r;
+            float y  = get_sample(0, TexCoord.st / TexCoord.q).r;
+            float cb = get_sample(1, TexCoord.st / TexCoord.q).r;
+            float cr = get_sample(2, TexCoord.st / TexCoord.q).r;
             return ycbcra_to_rgba(y, cb, cr, 1.0);
         }
     case 6:		//ycbcra
         {
-            float y  = get_sample(plane[0], TexCoord.st / TexCoord.q).r;
-            float cb = get_sample(plane[1], TexCoord.st / TexCoord.q).r;
-            float cr = get_sample(plane[2], TexCoord.st / TexCoord.q).r;
-            float a  = get_sample(plane[3], TexCoord.st / TexCoord.q).r;
+            float y  = get_sample(0, TexCoord.st / TexCoord.q).r;
+            float cb = get_sample(1, TexCoord.st / TexCoord.q).r;
+            float cr = get_sample(2, TexCoord.st / TexCoord.q).r;
+            float a  = get_sample(3, TexCoord.st / TexCoord.q).r;
             return ycbcra_to_rgba(y, cb, cr, a);
         }
     case 7:		//luma
         {
-            vec3 y3 = get_sample(plane[0], TexCoord.st / TexCoord.q).rrr;
+            vec3 y3 = get_sample(0, TexCoord.st / TexCoord.q).rrr;
             return vec4((y3-0.065)/0.859, 1.0);
         }
     case 8:		//bgr,
-        return vec4(get_sample(plane[0], TexCoord.st / TexCoord.q).bgr, 1.0);
+        return vec4(get_sample(0, TexCoord.st / TexCoord.q).bgr, 1.0);
     case 9:		//rgb,
-        return vec4(get_sample(plane[0], TexCoord.st / TexCoord.q).rgb, 1.0);
+        return vec4(get_sample(0, TexCoord.st / TexCoord.q).rgb, 1.0);
 	case 10:	// uyvy
 		{
-			float y = get_sample(plane[0], TexCoord.st / TexCoord.q).g;
-			float cb = get_sample(plane[1], TexCoord.st / TexCoord.q).b;
-			float cr = get_sample(plane[1], TexCoord.st / TexCoord.q).r;			
+			float y = get_sample(0, TexCoord.st / TexCoord.q).g;
+			float cb = get_sample(1, TexCoord.st / TexCoord.q).b;
+			float cr = get_sample(1, TexCoord.st / TexCoord.q).r;			
 			return ycbcra_to_rgba(y, cb, cr, 1.0);
 		}
     }
@@ -30,6 +30,7 @@
 #include <common/except.h>
 #include <common/gl/gl_check.h>
 #include <common/os/thread.h>
+#include <common/timer.h>
 
 #include <GL/glew.h>
 
@@ -42,6 +43,7 @@
 
 #include <boost/asio/deadline_timer.hpp>
 #include <boost/asio/dispatch.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/asio/spawn.hpp>
 #include <boost/property_tree/ptree.hpp>
 
@@ -62,9 +64,22 @@ struct device::impl : public std::enable_shared_from_this<impl>
     using buffer_queue_t  = tbb::concurrent_bounded_queue<std::shared_ptr<buffer>>;
 
     sf::Context device_;
+    const bool  shared_;
 
-    std::array<tbb::concurrent_unordered_map<size_t, texture_queue_t>, 4> device_pools_;
-    std::array<tbb::concurrent_unordered_map<size_t, buffer_queue_t>, 2>  host_pools_;
+    struct fence_wait
+    {
+        GLsync                fence;
+        std::function<void()> signalled;
+    };
+
+    // Fences are waited for on a context of their own, which blocks until the GPU signals them rather than polling.
+    sf::Context                               fence_context_;
+    tbb::concurrent_bounded_queue<fence_wait> fence_queue_;
+    std::thread                               fence_thread_;
+
+    // Indexed by depth and stride.
+    std::array<tbb::concurrent_unordered_map<size_t, texture_queue_t>, 16> device_pools_;
+    std::array<tbb::concurrent_unordered_map<size_t, buffer_queue_t>, 2>   host_pools_;
 
     using sync_queue_t = tbb::concurrent_bounded_queue<std::shared_ptr<buffer>>;
 
@@ -83,12 +98,15 @@ struct device::impl : public std::enable_shared_from_this<impl>
     decltype(make_work_guard(service_)) work_;
     std::thread                         thread_;
 
-    impl()
+    explicit impl(bool shared)
         : device_(sf::ContextSettings(0, 0, 0, 4, 5, sf::ContextSettings::Attribute::Core), 1, 1)
+        , shared_(shared)
+        , fence_context_(sf::ContextSettings(0, 0, 0, 4, 5, sf::ContextSettings::Attribute::Core), 1, 1)
         , work_(make_work_guard(service_))
     {
         CASPAR_LOG(info) << L"Initializing OpenGL Device.";
 
+        fence_context_.setActive(false);
         device_.setActive(true);
 
         if (glewInit() != GLEW_OK) {
@@ -139,6 +157,28 @@ struct device::impl : public std::enable_shared_from_this<impl>
             service_.run();
             device_.setActive(false);
         });
+
+        fence_thread_ = std::thread([&] {
+            fence_context_.setActive(true);
+            set_thread_name(L"OpenGL Fence");
+            while (true) {
+                fence_wait wait;
+                fence_queue_.pop(wait);
+                if (!wait.fence) {
+                    break;
+                }
+
+                // The GPU passes fences in the order they were issued, so waiting for them one by one is enough.
+                while (true) {
+                    auto result = glClientWaitSync(wait.fence, 0, 1000000000);
+                    if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED) {
+                        break;
+                    }
+                }
+                wait.signalled();
+            }
+            fence_context_.setActive(false);
+        });
     }
 
     ~impl()
@@ -146,6 +186,9 @@ struct device::impl : public std::enable_shared_from_this<impl>
         work_.reset();
         thread_.join();
 
+        fence_queue_.push(fence_wait{nullptr, nullptr});
+        fence_thread_.join();
+
         device_.setActive(true);
 
         for (auto& pool : host_pools_)
@@ -191,17 +234,34 @@ struct device::impl : public std::enable_shared_from_this<impl>
 
     std::wstring version() { return version_; }
 
-    std::shared_ptr<texture> create_texture(int width, int height, int stride, bool clear)
+    // Suspends the calling coroutine until the GPU has passed the commands issued so far.
+    void wait_for_gpu(yield_context yield)
+    {
+        auto fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        GL(glFlush());
+
+        deadline_timer timer(service_, boost::posix_time::ptime(boost::posix_time::pos_infin));
+        fence_queue_.push(fence_wait{fence, [&] { post(service_, [&] { timer.cancel(); }); }});
+
+        boost::system::error_code ec;
+        timer.async_wait(yield[ec]);
+
+        glDeleteSync(fence);
+    }
+
+    std::shared_ptr<texture> create_texture(int width, int height, int stride, bit_depth depth, bool clear)
     {
         CASPAR_VERIFY(stride > 0 && stride < 5);
         CASPAR_VERIFY(width > 0 && height > 0);
 
         // TODO (perf) Shared pool.
-        auto pool = &device_pools_[stride - 1][(width << 16 & 0xFFFF0000) | (height & 0x0000FFFF)];
+        auto pool = &device_pools_[static_cast<int>(depth) * 4 + stride - 1]
+                                  [(width << 16 & 0xFFFF0000) | (height & 0x0000FFFF)];
 
         std::shared_ptr<texture> tex;
         if (!pool->try_pop(tex)) {
-            tex = std::make_shared<texture>(width, height, stride);
+            tex = std::make_shared<texture>(width, height, stride, depth);
         }
 
         if (clear) {
@@ -240,7 +300,7 @@ struct device::impl : public std::enable_shared_from_this<impl>
     }
 
     std::future<std::shared_ptr<texture>>
-    copy_async(const array<const uint8_t>& source, int width, int height, int stride)
+    copy_async(const array<const uint8_t>& source, int width, int height, int stride, bit_depth depth)
     {
         return dispatch_async([=] {
             std::shared_ptr<buffer> buf;
@@ -254,38 +314,80 @@ struct device::impl : public std::enable_shared_from_this<impl>
                 std::memcpy(buf->data(), source.data(), source.size());
             }
 
-            auto tex = create_texture(width, height, stride, false);
+            auto tex = create_texture(width, height, stride, depth, false);
             tex->copy_from(*buf);
+            if (shared_) {
+                tex->fence();
+            }
             // TODO (perf) save tex on source
             return tex;
         });
     }
 
-    std::future<array<const uint8_t>> copy_async(const std::shared_ptr<texture>& source)
+    std::future<std::shared_ptr<texture>> copy_async(const array<const uint8_t>&                  source,
+                                                     std::shared_future<std::shared_ptr<texture>> base,
+                                                     std::vector<core::frame_region>              regions)
     {
-        return spawn_async([=](yield_context yield) {
-            auto buf = create_buffer(source->size(), false);
-            source->copy_to(*buf);
+        return dispatch_async([=] {
+            // Uploads are dispatched in order, so an upload of base on this device has completed already.
+            auto base_tex = base.get();
 
-            sync_queue_.push(nullptr);
+            std::shared_ptr<buffer> buf;
 
-            auto fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            auto tmp = source.storage<std::shared_ptr<buffer>>();
+            if (tmp) {
+                buf = *tmp;
+            } else {
+                buf = create_buffer(static_cast<int>(source.size()), true);
+                std::memcpy(buf->data(), source.data(), source.size());
+            }
 
-            GL(glFlush());
+            auto tex =
+                create_texture(base_tex->width(), base_tex->height(), base_tex->stride(), base_tex->depth(), false);
+            tex->copy_from(*base_tex);
+            for (auto& region : regions) {
+                tex->copy_from(*buf, region.x, region.y, region.width, region.height);
+            }
+            if (shared_) {
+                tex->fence();
+            }
+            return tex;
+        });
+    }
 
-            deadline_timer timer(service_);
-            for (auto n = 0; true; ++n) {
-                // TODO (perf) Smarter non-polling solution?
-                timer.expires_from_now(boost::posix_time::milliseconds(2));
-                timer.async_wait(yield);
+    // Other contexts may write to released textures while this one still reads from them.
+    void retain(std::shared_ptr<void> resources)
+    {
+        if (!shared_) {
+            return;
+        }
 
-                auto wait = glClientWaitSync(fence, 0, 1);
-                if (wait == GL_ALREADY_SIGNALED || wait == GL_CONDITION_SATISFIED) {
-                    break;
-                }
-            }
+        auto fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        GL(glFlush());
+
+        fence_queue_.push(fence_wait{fence, [=, self = shared_from_this()] {
+                                         post(service_, [fence, resources, self] { glDeleteSync(fence); });
+                                     }});
+    }
+
+    std::future<array<const uint8_t>>
+    copy_async(const std::shared_ptr<texture>& source, bit_depth depth, const std::function<void(double)>& on_latency)
+    {
+        return spawn_async([=](yield_context yield) {
+            caspar::timer latency;
 
-            glDeleteSync(fence);
+            auto buf = create_buffer(
+                source->width() * source->height() * source->stride() * bytes_per_sample(depth), false);
+            source->copy_to(*buf, depth);
+
+            sync_queue_.push(nullptr);
+
+            wait_for_gpu(yield);
+
+            if (on_latency) {
+                on_latency(latency.elapsed());
+            }
 
             {
                 std::shared_ptr<buffer> buf2;
@@ -305,27 +407,11 @@ struct device::impl : public std::enable_shared_from_this<impl>
     std::future<std::shared_ptr<texture>> copy_async(GLuint source, int width, int height, int stride)
     {
         return spawn_async([=](yield_context yield) {
-            auto tex = create_texture(width, height, stride, false);
+            auto tex = create_texture(width, height, stride, bit_depth::bit8, false);
 
             tex->copy_from(source);
 
-            auto fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
-
-            GL(glFlush());
-
-            deadline_timer timer(service_);
-            for (auto n = 0; true; ++n) {
-                // TODO (perf) Smarter non-polling solution?
-                timer.expires_from_now(boost::posix_time::milliseconds(2));
-                timer.async_wait(yield);
-
-                auto wait = glClientWaitSync(fence, 0, 1);
-                if (wait == GL_ALREADY_SIGNALED || wait == GL_CONDITION_SATISFIED) {
-                    break;
-                }
-            }
-
-            glDeleteSync(fence);
+            wait_for_gpu(yield);
 
             return tex;
         });
@@ -341,14 +427,14 @@ struct device::impl : public std::enable_shared_from_this<impl>
         size_t                       total_pooled_device_buffer_count = 0;
 
         for (size_t i = 0; i < device_pools_.size(); ++i) {
-            auto& pools      = device_pools_.at(i);
-            bool  mipmapping = i > 3;
-            auto  stride     = mipmapping ? i - 3 : i + 1;
+            auto& pools  = device_pools_.at(i);
+            auto  depth  = static_cast<bit_depth>(i / 4);
+            auto  stride = i % 4 + 1;
 
             for (auto& pool : pools) {
                 auto width  = pool.first >> 16;
                 auto height = pool.first & 0x0000FFFF;
-                auto size   = width * height * stride;
+                auto size   = width * height * stride * bytes_per_sample(depth);
                 auto count  = pool.second.size();
 
                 if (count == 0)
@@ -357,7 +443,7 @@ struct device::impl : public std::enable_shared_from_this<impl>
                 boost::property_tree::wptree pool_info;
 
                 pool_info.add(L"stride", stride);
-                pool_info.add(L"mipmapping", mipmapping);
+                pool_info.add(L"bytes-per-sample", bytes_per_sample(depth));
                 pool_info.add(L"width", width);
                 pool_info.add(L"height", height);
                 pool_info.add(L"size", size);
@@ -436,24 +522,32 @@ struct device::impl : public std::enable_shared_from_this<impl>
     }
 };
 
-device::device()
-    : impl_(new impl())
+device::device(bool shared)
+    : impl_(new impl(shared))
 {
 }
 device::~device() {}
-std::shared_ptr<texture> device::create_texture(int width, int height, int stride)
+std::shared_ptr<texture> device::create_texture(int width, int height, int stride, bit_depth depth)
 {
-    return impl_->create_texture(width, height, stride, true);
+    return impl_->create_texture(width, height, stride, depth, true);
 }
 array<uint8_t> device::create_array(int size) { return impl_->create_array(size); }
 std::future<std::shared_ptr<texture>>
-device::copy_async(const array<const uint8_t>& source, int width, int height, int stride)
+device::copy_async(const array<const uint8_t>& source, int width, int height, int stride, bit_depth depth)
 {
-    return impl_->copy_async(source, width, height, stride);
+    return impl_->copy_async(source, width, height, stride, depth);
+}
+std::future<std::shared_ptr<texture>> device::copy_async(const array<const uint8_t>&                  source,
+                                                         std::shared_future<std::shared_ptr<texture>> base,
+                                                         std::vector<core::frame_region>              regions)
+{
+    return impl_->copy_async(source, std::move(base), std::move(regions));
 }
-std::future<array<const uint8_t>> device::copy_async(const std::shared_ptr<texture>& source)
+std::future<array<const uint8_t>> device::copy_async(const std::shared_ptr<texture>& source,
+                                                     bit_depth                       depth,
+                                                     std::function<void(double)>     on_latency)
 {
-    return impl_->copy_async(source);
+    return impl_->copy_async(source, depth, on_latency);
 }
 #ifdef WIN32
 std::shared_ptr<void>                 device::d3d_interop() const { return impl_->interop_handle_; }
@@ -462,6 +556,7 @@ std::future<std::shared_ptr<texture>> device::copy_async(GLuint source, int widt
     return impl_->copy_async(source, width, height, stride);
 }
 #endif
+void         device::retain(std::shared_ptr<void> resources) { impl_->retain(std::move(resources)); }
 void         device::dispatch(std::function<void()> func) { boost::asio::dispatch(impl_->service_, std::move(func)); }
 std::wstring device::version() const { return impl_->version(); }
 boost::property_tree::wptree device::info() const { return impl_->info(); }
@@ -23,6 +23,9 @@
 
 #include <accelerator/accelerator.h>
 #include <common/array.h>
+#include <common/bit_depth.h>
+
+#include <core/frame/frame_factory.h>
 
 #include <functional>
 #include <future>
@@ -38,19 +41,34 @@ class device final
     , public accelerator_device
 {
   public:
-    device();
+    // A shared device draws textures uploaded by other devices, which all share objects with each other. Its uploads
+    // are fenced so that other contexts wait for them.
+    explicit device(bool shared = false);
     ~device();
 
     device(const device&) = delete;
 
     device& operator=(const device&) = delete;
 
-    std::shared_ptr<class texture> create_texture(int width, int height, int stride);
+    std::shared_ptr<class texture> create_texture(int width, int height, int stride, bit_depth depth = bit_depth::bit8);
     array<uint8_t>                 create_array(int size);
 
-    std::future<std::shared_ptr<class texture>>
-                                      copy_async(const array<const uint8_t>& source, int width, int height, int stride);
-    std::future<array<const uint8_t>> copy_async(const std::shared_ptr<class texture>& source);
+    std::future<std::shared_ptr<class texture>> copy_async(const array<const uint8_t>& source,
+                                                           int                         width,
+                                                           int                         height,
+                                                           int                         stride,
+                                                           bit_depth                   depth = bit_depth::bit8);
+    // Uploads the regions of source on top of a copy of base, see core::frame_factory.
+    std::future<std::shared_ptr<class texture>> copy_async(const array<const uint8_t>&                   source,
+                                                           std::shared_future<std::shared_ptr<texture>> base,
+                                                           std::vector<core::frame_region>              regions);
+    // Reads back the texture with samples of the given depth, converting from its storage if needed. on_latency is
+    // called on the device thread with the seconds from issuing the readback until the GPU signalled its completion.
+    std::future<array<const uint8_t>> copy_async(const std::shared_ptr<class texture>& source,
+                                                 bit_depth                             depth      = bit_depth::bit8,
+                                                 std::function<void(double)>           on_latency = nullptr);
+    // Keeps resources alive until the GPU has passed the commands issued so far, if the device is shared.
+    void retain(std::shared_ptr<void> resources);
 #ifdef WIN32
     std::shared_ptr<void>                 d3d_interop() const;
     std::future<std::shared_ptr<texture>> copy_async(GLuint source, int width, int height, int stride);
@@ -24,7 +24,9 @@
 
 #include <GL/glew.h>
 
+#include <array>
 #include <unordered_map>
+#include <vector>
 
 namespace caspar { namespace accelerator { namespace ogl {
 
@@ -34,6 +36,13 @@ struct shader::impl
     std::unordered_map<std::string, GLint> uniform_locations_;
     std::unordered_map<std::string, GLint> attrib_locations_;
 
+    struct uniform_value
+    {
+        bool                  valid = false;
+        std::array<double, 2> value;
+    };
+    std::vector<uniform_value> uniform_values_; // By location.
+
     impl(const impl&) = delete;
     impl& operator=(const impl&) = delete;
 
@@ -117,22 +126,53 @@ struct shader::impl
         return it->second;
     }
 
-    void set(const std::string& name, bool value) { set(name, value ? 1 : 0); }
+    // Returns false if the program already holds the value at location.
+    bool update(GLint location, double value0, double value1 = 0.0)
+    {
+        if (location < 0) {
+            return false;
+        }
 
-    void set(const std::string& name, int value) { GL(glUniform1i(get_uniform_location(name.c_str()), value)); }
+        if (static_cast<size_t>(location) >= uniform_values_.size()) {
+            uniform_values_.resize(location + 1);
+        }
 
-    void set(const std::string& name, float value) { GL(glUniform1f(get_uniform_location(name.c_str()), value)); }
+        auto& cached = uniform_values_[location];
+        if (cached.valid && cached.value[0] == value0 && cached.value[1] == value1) {
+            return false;
+        }
+
+        cached.valid = true;
+        cached.value = {value0, value1};
+        return true;
+    }
 
-    void set(const std::string& name, double value0, double value1)
+    void set(GLint location, int value)
     {
-        GL(glUniform2f(get_uniform_location(name.c_str()), static_cast<float>(value0), static_cast<float>(value1)));
+        if (update(location, value)) {
+            GL(glProgramUniform1i(program_, location, value));
+        }
     }
 
-    void set(const std::string& name, double value)
+    void set(GLint location, float value)
     {
-        GL(glUniform1f(get_uniform_location(name.c_str()), static_cast<float>(value)));
+        if (update(location, value)) {
+            GL(glProgramUniform1f(program_, location, value));
+        }
+    }
+
+    void set(GLint location, double value0, double value1)
+    {
+        // Compared as set, so that values that only differ below float precision are not set again.
+        const auto f0 = static_cast<float>(value0);
+        const auto f1 = static_cast<float>(value1);
+        if (update(location, f0, f1)) {
+            GL(glProgramUniform2f(program_, location, f0, f1));
+        }
     }
 
+    void set(GLint location, double value) { set(location, static_cast<float>(value)); }
+
     void use() { GL(glUseProgramObjectARB(program_)); }
 };
 
@@ -141,11 +181,20 @@ shader::shader(const std::string& vertex_source_str, const std::string& fragment
 {
 }
 shader::~shader() {}
-void  shader::set(const std::string& name, bool value) { impl_->set(name, value); }
-void  shader::set(const std::string& name, int value) { impl_->set(name, value); }
-void  shader::set(const std::string& name, float value) { impl_->set(name, value); }
-void  shader::set(const std::string& name, double value0, double value1) { impl_->set(name, value0, value1); }
-void  shader::set(const std::string& name, double value) { impl_->set(name, value); }
+void  shader::set(const std::string& name, bool value) { set(get_uniform_location(name.c_str()), value); }
+void  shader::set(const std::string& name, int value) { set(get_uniform_location(name.c_str()), value); }
+void  shader::set(const std::string& name, float value) { set(get_uniform_location(name.c_str()), value); }
+void  shader::set(const std::string& name, double value0, double value1)
+{
+    set(get_uniform_location(name.c_str()), value0, value1);
+}
+void  shader::set(const std::string& name, double value) { set(get_uniform_location(name.c_str()), value); }
+GLint shader::get_uniform_location(const char* name) { return impl_->get_uniform_location(name); }
+void  shader::set(GLint location, bool value) { impl_->set(location, value ? 1 : 0); }
+void  shader::set(GLint location, int value) { impl_->set(location, value); }
+void  shader::set(GLint location, float value) { impl_->set(location, value); }
+void  shader::set(GLint location, double value0, double value1) { impl_->set(location, value0, value1); }
+void  shader::set(GLint location, double value) { impl_->set(location, value); }
 GLint shader::get_attrib_location(const char* name) { return impl_->get_attrib_location(name); }
 int   shader::id() const { return impl_->program_; }
 void  shader::use() const { impl_->use(); }
@@ -43,6 +43,15 @@ class shader final
     void set(const std::string& name, double value0, double value1);
     void set(const std::string& name, double value);
 
+    // Setting by location skips the name lookup, resolve it once with get_uniform_location. Values that the program
+    // already holds are not set again, by name or by location.
+    GLint get_uniform_location(const char* name);
+    void  set(GLint location, bool value);
+    void  set(GLint location, int value);
+    void  set(GLint location, float value);
+    void  set(GLint location, double value0, double value1);
+    void  set(GLint location, double value);
+
     GLint get_attrib_location(const char* name);
 
     template <typename E>
@@ -51,6 +60,12 @@ class shader final
         set(name, static_cast<typename std::underlying_type<E>::type>(value));
     }
 
+    template <typename E>
+    typename std::enable_if<std::is_enum<E>::value, void>::type set(GLint location, E value)
+    {
+        set(location, static_cast<typename std::underlying_type<E>::type>(value));
+    }
+
     void use() const;
 
     int id() const;
@@ -26,44 +26,76 @@
 
 #include <GL/glew.h>
 
+#include <algorithm>
+
 namespace caspar { namespace accelerator { namespace ogl {
 
-static GLenum FORMAT[]          = {0, GL_RED, GL_RG, GL_BGR, GL_BGRA};
-static GLenum INTERNAL_FORMAT[] = {0, GL_R8, GL_RG8, GL_RGB8, GL_RGBA8};
+static GLenum FORMAT[]            = {0, GL_RED, GL_RG, GL_BGR, GL_BGRA};
+static GLenum INTERNAL_FORMAT[]   = {0, GL_R8, GL_RG8, GL_RGB8, GL_RGBA8};
+static GLenum INTERNAL_FORMAT16[] = {0, GL_R16, GL_RG16, GL_RGB16, GL_RGBA16};
 static GLenum TYPE[] = {0, GL_UNSIGNED_BYTE, GL_UNSIGNED_BYTE, GL_UNSIGNED_BYTE, GL_UNSIGNED_INT_8_8_8_8_REV};
 
+static GLenum type(int stride, bit_depth depth)
+{
+    return depth == bit_depth::bit8 ? TYPE[stride] : GL_UNSIGNED_SHORT;
+}
+
 struct texture::impl
 {
-    GLuint  id_     = 0;
-    GLsizei width_  = 0;
-    GLsizei height_ = 0;
-    GLsizei stride_ = 0;
-    GLsizei size_   = 0;
+    GLuint    id_     = 0;
+    GLsizei   width_  = 0;
+    GLsizei   height_ = 0;
+    GLsizei   stride_ = 0;
+    bit_depth depth_  = bit_depth::bit8;
+    GLsizei   size_   = 0;
+    GLsync    fence_  = nullptr;
 
     impl(const impl&) = delete;
     impl& operator=(const impl&) = delete;
 
   public:
-    impl(int width, int height, int stride)
+    impl(int width, int height, int stride, bit_depth depth)
         : width_(width)
         , height_(height)
         , stride_(stride)
-        , size_(width * height * stride)
+        , depth_(depth)
+        , size_(width * height * stride * bytes_per_sample(depth))
     {
         GL(glCreateTextures(GL_TEXTURE_2D, 1, &id_));
         GL(glTextureParameteri(id_, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
         GL(glTextureParameteri(id_, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
         GL(glTextureParameteri(id_, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
         GL(glTextureParameteri(id_, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
-        GL(glTextureStorage2D(id_, 1, INTERNAL_FORMAT[stride_], width_, height_));
+        auto internal_format = depth_ == bit_depth::bit8 ? INTERNAL_FORMAT[stride_] : INTERNAL_FORMAT16[stride_];
+        GL(glTextureStorage2D(id_, 1, internal_format, width_, height_));
     }
 
-    ~impl() { glDeleteTextures(1, &id_); }
+    ~impl()
+    {
+        if (fence_) {
+            glDeleteSync(fence_);
+        }
+        glDeleteTextures(1, &id_);
+    }
+
+    void fence()
+    {
+        if (fence_) {
+            glDeleteSync(fence_);
+        }
+        fence_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        // Another context can only wait for a fence that has been flushed.
+        GL(glFlush());
+    }
 
     void bind() { GL(glBindTexture(GL_TEXTURE_2D, id_)); }
 
     void bind(int index)
     {
+        if (fence_) {
+            // The GPU waits rather than the caller, which costs nothing when the fence was issued on this context.
+            GL(glWaitSync(fence_, 0, GL_TIMEOUT_IGNORED));
+        }
         GL(glActiveTexture(GL_TEXTURE0 + index));
         bind();
     }
@@ -72,7 +104,7 @@ struct texture::impl
 
     void attach() { GL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + 0, GL_TEXTURE_2D, id_, 0)); }
 
-    void clear() { GL(glClearTexImage(id_, 0, FORMAT[stride_], TYPE[stride_], nullptr)); }
+    void clear() { GL(glClearTexImage(id_, 0, FORMAT[stride_], type(stride_, depth_), nullptr)); }
 
 #ifdef WIN32
     void copy_from(int texture_id)
@@ -92,21 +124,60 @@ struct texture::impl
             glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
         }
 
-        GL(glTextureSubImage2D(id_, 0, 0, 0, width_, height_, FORMAT[stride_], TYPE[stride_], nullptr));
+        GL(glTextureSubImage2D(id_, 0, 0, 0, width_, height_, FORMAT[stride_], type(stride_, depth_), nullptr));
+
+        src.unbind();
+    }
+
+    void copy_from(buffer& src, int x, int y, int width, int height)
+    {
+        x      = std::max(0, x);
+        y      = std::max(0, y);
+        width  = std::min(width, width_ - x);
+        height = std::min(height, height_ - y);
+        if (width <= 0 || height <= 0) {
+            return;
+        }
+
+        src.bind();
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, width_);
+
+        auto offset = (static_cast<size_t>(y) * width_ + x) * stride_ * bytes_per_sample(depth_);
+        GL(glTextureSubImage2D(
+            id_, 0, x, y, width, height, FORMAT[stride_], type(stride_, depth_), reinterpret_cast<void*>(offset)));
+
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 
         src.unbind();
     }
 
-    void copy_to(buffer& dst)
+    void copy_from(impl& src)
+    {
+        if (src.fence_) {
+            GL(glWaitSync(src.fence_, 0, GL_TIMEOUT_IGNORED));
+        }
+        GL(glCopyImageSubData(
+            src.id_, GL_TEXTURE_2D, 0, 0, 0, 0, id_, GL_TEXTURE_2D, 0, 0, 0, 0, width_, height_, 1));
+    }
+
+    // The driver converts when depth differs from the storage, e.g. to read an 8-bit image from a 16-bit target.
+    void copy_to(buffer& dst, bit_depth depth)
     {
         dst.bind();
-        GL(glGetTextureImage(id_, 0, FORMAT[stride_], TYPE[stride_], size_, nullptr));
+        GL(glGetTextureImage(id_,
+                             0,
+                             FORMAT[stride_],
+                             type(stride_, depth),
+                             width_ * height_ * stride_ * bytes_per_sample(depth),
+                             nullptr));
         dst.unbind();
     }
 };
 
-texture::texture(int width, int height, int stride)
-    : impl_(new impl(width, height, stride))
+texture::texture(int width, int height, int stride, bit_depth depth)
+    : impl_(new impl(width, height, stride, depth))
 {
 }
 texture::texture(texture&& other)
@@ -119,19 +190,26 @@ texture& texture::operator=(texture&& other)
     impl_ = std::move(other.impl_);
     return *this;
 }
-void texture::bind(int index) { impl_->bind(index); }
-void texture::unbind() { impl_->unbind(); }
-void texture::attach() { impl_->attach(); }
-void texture::clear() { impl_->clear(); }
+void      texture::fence() { impl_->fence(); }
+void      texture::bind(int index) { impl_->bind(index); }
+void      texture::unbind() { impl_->unbind(); }
+void      texture::attach() { impl_->attach(); }
+void      texture::clear() { impl_->clear(); }
 #ifdef WIN32
 void texture::copy_from(int source) { impl_->copy_from(source); }
 #endif
-void texture::copy_from(buffer& source) { impl_->copy_from(source); }
-void texture::copy_to(buffer& dest) { impl_->copy_to(dest); }
-int  texture::width() const { return impl_->width_; }
-int  texture::height() const { return impl_->height_; }
-int  texture::stride() const { return impl_->stride_; }
-int  texture::size() const { return impl_->width_ * impl_->height_ * impl_->stride_; }
-int  texture::id() const { return impl_->id_; }
+void      texture::copy_from(buffer& source) { impl_->copy_from(source); }
+void      texture::copy_from(buffer& source, int x, int y, int width, int height)
+{
+    impl_->copy_from(source, x, y, width, height);
+}
+void      texture::copy_from(texture& source) { impl_->copy_from(*source.impl_); }
+void      texture::copy_to(buffer& dest, bit_depth depth) { impl_->copy_to(dest, depth); }
+int       texture::width() const { return impl_->width_; }
+int       texture::height() const { return impl_->height_; }
+int       texture::stride() const { return impl_->stride_; }
+bit_depth texture::depth() const { return impl_->depth_; }
+int       texture::size() const { return impl_->size_; }
+int       texture::id() const { return impl_->id_; }
 
 }}} // namespace caspar::accelerator::ogl
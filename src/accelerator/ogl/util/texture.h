@@ -21,6 +21,8 @@
 
 #pragma once
 
+#include <common/bit_depth.h>
+
 #include <memory>
 
 namespace caspar { namespace accelerator { namespace ogl {
@@ -28,7 +30,7 @@ namespace caspar { namespace accelerator { namespace ogl {
 class texture final
 {
   public:
-    texture(int width, int height, int stride);
+    texture(int width, int height, int stride, bit_depth depth = bit_depth::bit8);
     texture(const texture&) = delete;
     texture(texture&& other);
     ~texture();
@@ -40,18 +42,25 @@ class texture final
     void copy_from(int source);
 #endif
     void copy_from(class buffer& source);
-    void copy_to(class buffer& dest);
+    // Copies a region of source, an image the size of the texture.
+    void copy_from(class buffer& source, int x, int y, int width, int height);
+    void copy_from(texture& source);
+    void copy_to(class buffer& dest, bit_depth depth);
+
+    // Lets other contexts that bind the texture wait for the writes to it issued so far.
+    void fence();
 
     void attach();
     void clear();
     void bind(int index);
     void unbind();
 
-    int width() const;
-    int height() const;
-    int stride() const;
-    int size() const;
-    int id() const;
+    int       width() const;
+    int       height() const;
+    int       stride() const;
+    bit_depth depth() const;
+    int       size() const;
+    int       id() const;
 
   private:
     struct impl;
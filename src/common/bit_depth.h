@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+namespace caspar {
+
+// Significant bits per sample. Everything above 8 bits is stored in 16-bit little endian words with the value in the
+// low bits.
+enum class bit_depth
+{
+    bit8 = 0,
+    bit10,
+    bit12,
+    bit16,
+};
+
+inline int bytes_per_sample(bit_depth depth) { return depth == bit_depth::bit8 ? 1 : 2; }
+
+inline int bits_per_sample(bit_depth depth)
+{
+    switch (depth) {
+        case bit_depth::bit10:
+            return 10;
+        case bit_depth::bit12:
+            return 12;
+        case bit_depth::bit16:
+            return 16;
+        default:
+            return 8;
+    }
+}
+
+} // namespace caspar
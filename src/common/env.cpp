@@ -41,6 +41,7 @@ std::wstring                 media;
 std::wstring                 log;
 std::wstring                 ftemplate;
 std::wstring                 data;
+std::wstring                 font;
 boost::property_tree::wptree pt;
 
 void check_is_configured()
@@ -99,6 +100,7 @@ void configure(const std::wstring& filename)
         ftemplate =
             clean_path(boost::filesystem::complete(paths.get(L"template-path", initial + L"/template/")).wstring());
         data = clean_path(paths.get(L"data-path", initial + L"/data/"));
+        font = clean_path(paths.get(L"font-path", initial + L"/font/"));
     } catch (...) {
         CASPAR_LOG(error) << L" ### Invalid configuration file. ###";
         throw;
@@ -108,6 +110,7 @@ void configure(const std::wstring& filename)
     log       = ensure_trailing_slash(resolve_or_create(log));
     ftemplate = ensure_trailing_slash(resolve_or_create(ftemplate));
     data      = ensure_trailing_slash(resolve_or_create(data));
+    font      = ensure_trailing_slash(resolve_or_create(font));
 
     ensure_writable(log);
     ensure_writable(ftemplate);
@@ -144,6 +147,12 @@ const std::wstring& data_folder()
     return data;
 }
 
+const std::wstring& font_folder()
+{
+    check_is_configured();
+    return font;
+}
+
 #define QUOTE(str) #str
 #define EXPAND_AND_QUOTE(str) QUOTE(str)
 
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <boost/filesystem/path.hpp>
+
+#include <functional>
+#include <memory>
+
+namespace caspar {
+
+/**
+ * Watches a directory tree and reports every path that has been created, removed, renamed or written to. The handler
+ * is invoked on the monitor thread. When individual changes cannot be tracked (e.g. the event queue overflowed, or the
+ * platform only reports that something changed) the handler is invoked with the root itself.
+ */
+class filesystem_monitor final
+{
+  public:
+    using handler_t = std::function<void(const boost::filesystem::path& path)>;
+
+    filesystem_monitor(const boost::filesystem::path& root, handler_t handler);
+    ~filesystem_monitor();
+
+    filesystem_monitor(const filesystem_monitor&) = delete;
+    filesystem_monitor& operator=(const filesystem_monitor&) = delete;
+
+    const boost::filesystem::path& root() const;
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> impl_;
+};
+
+} // namespace caspar
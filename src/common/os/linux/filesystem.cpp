@@ -23,46 +23,265 @@
 
 #include "../filesystem.h"
 
-#include <list>
+#include "../../log.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 
+#include <sys/inotify.h>
+#include <unistd.h>
+
 using namespace boost::filesystem;
 
 namespace caspar {
 
-boost::optional<std::wstring> find_case_insensitive(const std::wstring& case_insensitive)
-{
-    path p(case_insensitive);
+namespace {
 
-    if (exists(p))
-        return case_insensitive;
+const uint32_t LISTING_WATCH_MASK =
+    IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+// Upper bound on cached directories, keeps us well below the default inotify watch limit.
+const std::size_t MAX_LISTINGS = 4096;
 
-    p = absolute(p);
-    path result;
+/**
+ * Process-wide cache of directory listings used to resolve paths case-insensitively. Each cached directory is watched
+ * through inotify and the pending events are applied before every lookup. Listings are dropped when their directory,
+ * or one of its parents, is removed or moved, when the watch goes away and when the event queue overflows.
+ */
+class listing_cache
+{
+    struct listing
+    {
+        int                                            wd = -1;
+        std::unordered_set<std::wstring>               names;
+        std::unordered_map<std::wstring, std::wstring> lower_names;
 
-    for (auto part : p) {
-        auto concatenated = result / part;
+        void add(const std::wstring& name)
+        {
+            names.insert(name);
+            lower_names.emplace(boost::algorithm::to_lower_copy(name), name);
+        }
 
-        if (exists(concatenated)) {
-            result = concatenated;
-        } else {
-            bool found = false;
+        void remove(const std::wstring& name)
+        {
+            names.erase(name);
 
-            for (auto it = directory_iterator(absolute(result)); it != directory_iterator(); ++it) {
-                auto leaf = it->path().leaf();
+            auto lower = boost::algorithm::to_lower_copy(name);
+            auto it    = lower_names.find(lower);
+            if (it == lower_names.end() || it->second != name)
+                return;
 
-                if (boost::algorithm::iequals(part.wstring(), leaf.wstring())) {
-                    result = result / leaf;
-                    found  = true;
+            lower_names.erase(it);
+            for (auto& other : names) {
+                if (boost::algorithm::to_lower_copy(other) == lower) {
+                    lower_names.emplace(lower, other);
                     break;
                 }
             }
+        }
+
+        boost::optional<path> find(const path& part) const
+        {
+            auto name = part.wstring();
+            if (names.count(name) > 0)
+                return part;
 
-            if (!found)
+            auto it = lower_names.find(boost::algorithm::to_lower_copy(name));
+            if (it == lower_names.end())
                 return boost::none;
+
+            return path(it->second);
+        }
+    };
+
+    std::mutex                                mutex_;
+    int                                       inotify_fd_ = -1;
+    std::unordered_map<std::wstring, listing> listings_;
+    std::unordered_map<int, std::wstring>     directories_;
+
+  public:
+    listing_cache()
+    {
+        inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd_ < 0)
+            CASPAR_LOG(warning) << L"[filesystem] inotify unavailable, case insensitive lookups will not be cached.";
+    }
+
+    ~listing_cache()
+    {
+        if (inotify_fd_ >= 0)
+            close(inotify_fd_);
+    }
+
+    boost::optional<path> find(const path& dir, const path& part)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        process_events();
+
+        auto it = listings_.find(dir.wstring());
+        if (it != listings_.end())
+            return it->second.find(part);
+
+        listing l;
+        if (!load(dir, l))
+            return boost::none;
+
+        auto result = l.find(part);
+
+        // Only watched listings are kept, anything else could go stale.
+        if (l.wd >= 0) {
+            directories_[l.wd] = dir.wstring();
+            listings_.emplace(dir.wstring(), std::move(l));
+        }
+
+        return result;
+    }
+
+  private:
+    bool load(const path& dir, listing& l)
+    {
+        if (inotify_fd_ >= 0) {
+            if (listings_.size() >= MAX_LISTINGS)
+                clear();
+
+            // Watch before listing so that nothing created in between is missed.
+            l.wd = inotify_add_watch(inotify_fd_, dir.c_str(), LISTING_WATCH_MASK);
+
+            // The same directory reached through another path shares the watch descriptor.
+            auto existing = directories_.find(l.wd);
+            if (existing != directories_.end()) {
+                listings_.erase(existing->second);
+                directories_.erase(existing);
+            }
         }
+
+        boost::system::error_code ec;
+        for (auto it = directory_iterator(dir, ec); !ec && it != directory_iterator(); it.increment(ec))
+            l.add(it->path().filename().wstring());
+
+        if (ec && l.wd >= 0)
+            inotify_rm_watch(inotify_fd_, l.wd);
+
+        return !ec;
+    }
+
+    void drop(int wd)
+    {
+        auto it = directories_.find(wd);
+        if (it == directories_.end())
+            return;
+
+        inotify_rm_watch(inotify_fd_, wd);
+        listings_.erase(it->second);
+        directories_.erase(it);
+    }
+
+    // Drops the listings of a removed or moved directory and everything below it, their watches only report
+    // changes to the directories themselves.
+    void drop_tree(const path& dir)
+    {
+        auto prefix = dir.wstring() + L"/";
+
+        for (auto it = directories_.begin(); it != directories_.end();) {
+            if (it->second == dir.wstring() || boost::algorithm::starts_with(it->second, prefix)) {
+                inotify_rm_watch(inotify_fd_, it->first);
+                listings_.erase(it->second);
+                it = directories_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void clear()
+    {
+        for (auto& dir : directories_)
+            inotify_rm_watch(inotify_fd_, dir.first);
+
+        listings_.clear();
+        directories_.clear();
+    }
+
+    void process_events()
+    {
+        if (inotify_fd_ < 0)
+            return;
+
+        alignas(inotify_event) char buffer[16 * 1024];
+
+        while (true) {
+            auto len = read(inotify_fd_, buffer, sizeof(buffer));
+            if (len <= 0)
+                return;
+
+            for (char* ptr = buffer; ptr < buffer + len;) {
+                auto event = reinterpret_cast<const inotify_event*>(ptr);
+                ptr += sizeof(inotify_event) + event->len;
+
+                if ((event->mask & IN_Q_OVERFLOW) != 0) {
+                    clear();
+                    continue;
+                }
+
+                if ((event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) != 0) {
+                    drop(event->wd);
+                    continue;
+                }
+
+                auto dir = directories_.find(event->wd);
+                if (dir == directories_.end() || event->len == 0)
+                    continue;
+
+                auto& listing = listings_[dir->second];
+                auto  name    = path(event->name).wstring();
+
+                if ((event->mask & (IN_CREATE | IN_MOVED_TO)) != 0) {
+                    listing.add(name);
+                } else if ((event->mask & (IN_DELETE | IN_MOVED_FROM)) != 0) {
+                    listing.remove(name);
+                    if ((event->mask & IN_ISDIR) != 0)
+                        drop_tree(path(dir->second) / name);
+                }
+            }
+        }
+    }
+};
+
+listing_cache& get_listing_cache()
+{
+    static listing_cache cache;
+    return cache;
+}
+
+} // namespace
+
+boost::optional<std::wstring> find_case_insensitive(const std::wstring& case_insensitive)
+{
+    path p(case_insensitive);
+
+    if (exists(p))
+        return case_insensitive;
+
+    p           = absolute(p);
+    path result = p.root_path();
+
+    for (auto part : p.relative_path()) {
+        if (part == "." || part == "..") {
+            result /= part;
+            continue;
+        }
+
+        auto leaf = get_listing_cache().find(result.empty() ? path(".") : result, part);
+        if (!leaf)
+            return boost::none;
+
+        result /= *leaf;
     }
 
     return result.wstring();
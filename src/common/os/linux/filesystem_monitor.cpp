@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../../stdafx.h"
+
+#include "../filesystem_monitor.h"
+
+#include "../../except.h"
+#include "../../log.h"
+#include "../thread.h"
+
+#include <boost/filesystem.hpp>
+
+#include <atomic>
+#include <map>
+#include <thread>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace caspar {
+
+using namespace boost::filesystem;
+
+static const uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB |
+                                   IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+struct filesystem_monitor::impl
+{
+    const path      root_;
+    const handler_t handler_;
+
+    int                 inotify_fd_ = -1;
+    int                 stop_fd_    = -1;
+    std::map<int, path> watches_;
+    std::atomic<bool>   abort_request_{false};
+    std::thread         thread_;
+
+    impl(const path& root, handler_t handler)
+        : root_(root)
+        , handler_(std::move(handler))
+    {
+        inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd_ < 0)
+            CASPAR_THROW_EXCEPTION(caspar_exception()
+                                   << msg_info("inotify_init1 failed") << boost::errinfo_errno(errno));
+
+        stop_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (stop_fd_ < 0) {
+            close(inotify_fd_);
+            CASPAR_THROW_EXCEPTION(caspar_exception() << msg_info("eventfd failed") << boost::errinfo_errno(errno));
+        }
+
+        add_watches(root_);
+
+        thread_ = std::thread([this] {
+            set_thread_name(L"filesystem-monitor");
+            run();
+        });
+    }
+
+    ~impl()
+    {
+        abort_request_ = true;
+        uint64_t one   = 1;
+        if (write(stop_fd_, &one, sizeof(one)) < 0)
+            CASPAR_LOG(warning) << L"[filesystem_monitor] Failed to signal monitor thread.";
+        thread_.join();
+        close(stop_fd_);
+        close(inotify_fd_);
+    }
+
+    void add_watch(const path& dir)
+    {
+        auto wd = inotify_add_watch(inotify_fd_, dir.c_str(), WATCH_MASK);
+        if (wd < 0) {
+            CASPAR_LOG(warning) << L"[filesystem_monitor] Unable to watch " << dir.wstring() << L" (errno "
+                                << errno << L").";
+            return;
+        }
+        watches_[wd] = dir;
+    }
+
+    void add_watches(const path& dir)
+    {
+        boost::system::error_code ec;
+        if (!is_directory(dir, ec))
+            return;
+
+        add_watch(dir);
+
+        for (recursive_directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+            if (is_directory(it->status()))
+                add_watch(it->path());
+        }
+    }
+
+    void run()
+    {
+        alignas(inotify_event) char buffer[64 * 1024];
+
+        pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {stop_fd_, POLLIN, 0}};
+
+        while (!abort_request_) {
+            if (poll(fds, 2, -1) < 0) {
+                if (errno == EINTR)
+                    continue;
+                CASPAR_LOG(error) << L"[filesystem_monitor] poll failed (errno " << errno << L").";
+                return;
+            }
+
+            if ((fds[1].revents & POLLIN) != 0)
+                return;
+
+            while (true) {
+                auto len = read(inotify_fd_, buffer, sizeof(buffer));
+                if (len <= 0)
+                    break;
+
+                for (char* ptr = buffer; ptr < buffer + len;) {
+                    auto event = reinterpret_cast<const inotify_event*>(ptr);
+                    ptr += sizeof(inotify_event) + event->len;
+
+                    try {
+                        dispatch(*event);
+                    } catch (...) {
+                        CASPAR_LOG_CURRENT_EXCEPTION();
+                    }
+                }
+            }
+        }
+    }
+
+    void dispatch(const inotify_event& event)
+    {
+        if ((event.mask & IN_Q_OVERFLOW) != 0) {
+            handler_(root_);
+            return;
+        }
+
+        auto it = watches_.find(event.wd);
+        if (it == watches_.end())
+            return;
+
+        if ((event.mask & IN_IGNORED) != 0) {
+            watches_.erase(it);
+            return;
+        }
+
+        if ((event.mask & (IN_DELETE_SELF | IN_MOVE_SELF)) != 0) {
+            // The parent directory reports the same change through IN_DELETE / IN_MOVED_FROM.
+            if (it->second == root_)
+                handler_(root_);
+            return;
+        }
+
+        auto changed = event.len > 0 ? it->second / event.name : it->second;
+
+        if ((event.mask & IN_ISDIR) != 0 && (event.mask & (IN_CREATE | IN_MOVED_TO)) != 0)
+            add_watches(changed);
+
+        handler_(changed);
+    }
+};
+
+filesystem_monitor::filesystem_monitor(const path& root, handler_t handler)
+    : impl_(new impl(root, std::move(handler)))
+{
+}
+
+filesystem_monitor::~filesystem_monitor() {}
+
+const path& filesystem_monitor::root() const { return impl_->root_; }
+
+} // namespace caspar
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../../stdafx.h"
+
+#include "../filesystem_monitor.h"
+
+#include "../../except.h"
+#include "../../log.h"
+#include "../thread.h"
+#include "windows.h"
+
+#include <thread>
+
+namespace caspar {
+
+using namespace boost::filesystem;
+
+// FindFirstChangeNotification only tells that something below the root changed, so every change is reported as the
+// root and left to the handler to rescan.
+struct filesystem_monitor::impl
+{
+    const path      root_;
+    const handler_t handler_;
+
+    HANDLE      change_handle_ = INVALID_HANDLE_VALUE;
+    HANDLE      stop_event_    = nullptr;
+    std::thread thread_;
+
+    impl(const path& root, handler_t handler)
+        : root_(root)
+        , handler_(std::move(handler))
+    {
+        change_handle_ = FindFirstChangeNotificationW(root_.c_str(),
+                                                      TRUE,
+                                                      FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+                                                          FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE);
+        if (change_handle_ == INVALID_HANDLE_VALUE)
+            CASPAR_THROW_EXCEPTION(caspar_exception() << msg_info(L"Unable to watch " + root_.wstring()));
+
+        stop_event_ = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+
+        thread_ = std::thread([this] {
+            set_thread_name(L"filesystem-monitor");
+            run();
+        });
+    }
+
+    ~impl()
+    {
+        SetEvent(stop_event_);
+        thread_.join();
+        CloseHandle(stop_event_);
+        FindCloseChangeNotification(change_handle_);
+    }
+
+    void run()
+    {
+        HANDLE handles[2] = {change_handle_, stop_event_};
+
+        while (true) {
+            auto result = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+            if (result != WAIT_OBJECT_0)
+                return;
+
+            try {
+                handler_(root_);
+            } catch (...) {
+                CASPAR_LOG_CURRENT_EXCEPTION();
+            }
+
+            if (!FindNextChangeNotification(change_handle_))
+                return;
+        }
+    }
+};
+
+filesystem_monitor::filesystem_monitor(const path& root, handler_t handler)
+    : impl_(new impl(root, std::move(handler)))
+{
+}
+
+filesystem_monitor::~filesystem_monitor() {}
+
+const path& filesystem_monitor::root() const { return impl_->root_; }
+
+} // namespace caspar
@@ -122,6 +122,15 @@ class destroy_consumer_proxy : public frame_consumer
     bool                 has_synchronization_clock() const override { return consumer_->has_synchronization_clock(); }
     int                  index() const override { return consumer_->index(); }
     core::monitor::state state() const override { return consumer_->state(); }
+    void                 offline(bool offline) override { consumer_->offline(offline); }
+
+    std::vector<output_pixel_format> requested_pixel_formats() const override
+    {
+        return consumer_->requested_pixel_formats();
+    }
+
+    std::vector<output_rendition> requested_renditions() const override { return consumer_->requested_renditions(); }
+    bool                          needs_image_data() const override { return consumer_->needs_image_data(); }
 };
 
 class print_consumer_proxy : public frame_consumer
@@ -153,6 +162,15 @@ class print_consumer_proxy : public frame_consumer
     bool                 has_synchronization_clock() const override { return consumer_->has_synchronization_clock(); }
     int                  index() const override { return consumer_->index(); }
     core::monitor::state state() const override { return consumer_->state(); }
+    void                 offline(bool offline) override { consumer_->offline(offline); }
+
+    std::vector<output_pixel_format> requested_pixel_formats() const override
+    {
+        return consumer_->requested_pixel_formats();
+    }
+
+    std::vector<output_rendition> requested_renditions() const override { return consumer_->requested_renditions(); }
+    bool                          needs_image_data() const override { return consumer_->needs_image_data(); }
 };
 
 spl::shared_ptr<core::frame_consumer>
@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include "../frame/pixel_format.h"
 #include "../fwd.h"
 #include "../monitor/monitor.h"
 
@@ -59,6 +60,23 @@ class frame_consumer
     virtual std::wstring name() const  = 0;
     virtual bool         has_synchronization_clock() const { return false; }
     virtual int          index() const = 0;
+
+    // Offline channels render as fast as their consumers accept frames. Consumers that would drop frames to keep up
+    // with a real-time channel should block in send instead.
+    virtual void offline(bool offline) {}
+
+    // Formats the consumer would like the mixer to convert to in addition to BGRA. Polled once per frame, the
+    // results are available through const_frame::image_data(output_pixel_format) when supported by the mixer.
+    virtual std::vector<output_pixel_format> requested_pixel_formats() const { return {}; }
+
+    // Like requested_pixel_formats, for conversions scaled to another size than the channel's. The results are
+    // available through const_frame::image_data(output_rendition).
+    virtual std::vector<output_rendition> requested_renditions() const { return {}; }
+
+    // Consumers that draw the mixed image from the GPU mixer's texture, rather than reading its pixels, return false.
+    // When no consumer needs them the image is left on the GPU: image_data(0) is then empty and its storage holds
+    // the texture.
+    virtual bool needs_image_data() const { return true; }
 };
 
 using consumer_factory_t =
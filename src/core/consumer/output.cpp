@@ -32,6 +32,8 @@
 
 #include <boost/optional.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <map>
 #include <thread>
@@ -47,10 +49,11 @@ struct output::impl
     const int                           channel_index_;
     video_format_desc                   format_desc_;
 
-    std::mutex                                     consumers_mutex_;
+    mutable std::mutex                             consumers_mutex_;
     std::map<int, spl::shared_ptr<frame_consumer>> consumers_;
 
     boost::optional<time_point_t> time_;
+    std::atomic<bool>             offline_{false};
 
   public:
     impl(spl::shared_ptr<diagnostics::graph> graph, const video_format_desc& format_desc, int channel_index)
@@ -67,9 +70,19 @@ struct output::impl
         consumer->initialize(format_desc_, channel_index_);
 
         std::lock_guard<std::mutex> lock(consumers_mutex_);
+        consumer->offline(offline_);
         consumers_.emplace(index, std::move(consumer));
     }
 
+    void offline(bool offline)
+    {
+        std::lock_guard<std::mutex> lock(consumers_mutex_);
+        offline_ = offline;
+        for (auto& p : consumers_) {
+            p.second->offline(offline);
+        }
+    }
+
     void add(const spl::shared_ptr<frame_consumer>& consumer) { add(consumer->index(), consumer); }
 
     bool remove(int index)
@@ -81,6 +94,35 @@ struct output::impl
 
     bool remove(const spl::shared_ptr<frame_consumer>& consumer) { return remove(consumer->index()); }
 
+    std::vector<output_rendition> requested_renditions() const
+    {
+        std::vector<output_rendition> renditions;
+
+        auto add = [&](const output_rendition& rendition) {
+            if (std::find(renditions.begin(), renditions.end(), rendition) == renditions.end()) {
+                renditions.push_back(rendition);
+            }
+        };
+
+        std::lock_guard<std::mutex> lock(consumers_mutex_);
+        for (auto& p : consumers_) {
+            for (auto format : p.second->requested_pixel_formats()) {
+                add(output_rendition(format));
+            }
+            for (auto& rendition : p.second->requested_renditions()) {
+                add(rendition);
+            }
+        }
+        return renditions;
+    }
+
+    bool needs_image_data() const
+    {
+        std::lock_guard<std::mutex> lock(consumers_mutex_);
+        return std::any_of(
+            consumers_.begin(), consumers_.end(), [](auto& p) { return p.second->needs_image_data(); });
+    }
+
     void operator()(const_frame input_frame, const core::video_format_desc& format_desc)
     {
         if (!input_frame) {
@@ -118,8 +160,15 @@ struct output::impl
 
         std::map<int, std::future<bool>> futures;
 
+        // Frames mixed before a consumer that reads pixels was added may have been left on the GPU.
+        const auto has_image_data = static_cast<bool>(input_frame.image_data(0));
+
         for (auto it = consumers.begin(); it != consumers.end();) {
             try {
+                if (!has_image_data && it->second->needs_image_data()) {
+                    ++it;
+                    continue;
+                }
                 futures.emplace(it->first, it->second->send(input_frame));
                 ++it;
             } catch (...) {
@@ -148,16 +197,15 @@ struct output::impl
             }
         }
 
-        monitor::state state;
+        state_.clear();
         for (auto& p : consumers) {
-            state["port"][p.first] = p.second->state();
+            state_["port"][p.first] = p.second->state();
         }
-        state_ = std::move(state);
 
         const auto needs_sync = std::all_of(
             consumers.begin(), consumers.end(), [](auto& p) { return !p.second->has_synchronization_clock(); });
 
-        if (needs_sync) {
+        if (needs_sync && !offline_) {
             if (!time) {
                 time = std::chrono::high_resolution_clock::now();
             } else {
@@ -185,5 +233,9 @@ void output::operator()(const_frame frame, const video_format_desc& format_desc)
 {
     return (*impl_)(std::move(frame), format_desc);
 }
-core::monitor::state output::state() const { return impl_->state_; }
+std::vector<output_rendition> output::requested_renditions() const { return impl_->requested_renditions(); }
+bool                             output::needs_image_data() const { return impl_->needs_image_data(); }
+void                             output::offline(bool offline) { impl_->offline(offline); }
+bool                             output::offline() const { return impl_->offline_; }
+core::monitor::state             output::state() const { return impl_->state_; }
 }} // namespace caspar::core
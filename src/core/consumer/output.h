@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include "../frame/pixel_format.h"
 #include "../fwd.h"
 #include "../monitor/monitor.h"
 
@@ -28,6 +29,7 @@
 #include <common/memory.h>
 
 #include <memory>
+#include <vector>
 
 FORWARD2(caspar, diagnostics, class graph);
 
@@ -49,6 +51,16 @@ class output final
     bool remove(const spl::shared_ptr<frame_consumer>& consumer);
     bool remove(int index);
 
+    // The conversions requested by the consumers, without duplicates.
+    std::vector<output_rendition> requested_renditions() const;
+
+    // Whether any consumer reads the pixels of the mixed image.
+    bool needs_image_data() const;
+
+    // Whether frames are consumed as fast as the consumers accept them rather than at the channel frame rate.
+    void offline(bool offline);
+    bool offline() const;
+
     core::monitor::state state() const;
 
   private:
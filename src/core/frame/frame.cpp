@@ -94,13 +94,17 @@ struct const_frame::impl
     core::pixel_format_desc                desc_     = pixel_format::invalid;
     frame_geometry                         geometry_ = frame_geometry::get_default();
     boost::any                             opaque_;
+    const void*                            tag_ = nullptr;
+    const_frame::converted_t               converted_;
 
     impl(std::vector<array<const std::uint8_t>> image_data,
          array<const std::int32_t>              audio_data,
-         const core::pixel_format_desc&         desc)
+         const core::pixel_format_desc&         desc,
+         const_frame::converted_t               converted)
         : image_data_(std::move(image_data))
         , audio_data_(std::move(audio_data))
         , desc_(desc)
+        , converted_(std::move(converted))
     {
         if (desc_.planes.size() != image_data_.size()) {
             CASPAR_THROW_EXCEPTION(invalid_argument());
@@ -125,6 +129,7 @@ struct const_frame::impl
         , audio_data_(std::move(other.impl_->audio_data_))
         , desc_(std::move(other.impl_->desc_))
         , geometry_(std::move(other.impl_->geometry_))
+        , tag_(other.impl_->tag_)
     {
         if (desc_.planes.size() != image_data_.size() && !other.impl_->commit_) {
             CASPAR_THROW_EXCEPTION(invalid_argument());
@@ -136,6 +141,18 @@ struct const_frame::impl
 
     const array<const std::uint8_t>& image_data(std::size_t index) const { return image_data_.at(index); }
 
+    const array<const std::uint8_t>& image_data(const output_rendition& rendition) const
+    {
+        static const array<const std::uint8_t> empty;
+
+        for (auto& p : converted_) {
+            if (p.first == rendition) {
+                return p.second;
+            }
+        }
+        return empty;
+    }
+
     std::size_t width() const { return desc_.planes.at(0).width; }
 
     std::size_t height() const { return desc_.planes.at(0).height; }
@@ -146,8 +163,9 @@ struct const_frame::impl
 const_frame::const_frame() {}
 const_frame::const_frame(std::vector<array<const std::uint8_t>> image_data,
                          array<const std::int32_t>              audio_data,
-                         const core::pixel_format_desc&         desc)
-    : impl_(new impl(std::move(image_data), std::move(audio_data), desc))
+                         const core::pixel_format_desc&         desc,
+                         converted_t                            converted)
+    : impl_(new impl(std::move(image_data), std::move(audio_data), desc, std::move(converted)))
 {
 }
 const_frame::const_frame(mutable_frame&& other)
@@ -170,11 +188,20 @@ bool const_frame::operator<(const const_frame& other) const { return impl_ < oth
 bool const_frame::               operator>(const const_frame& other) const { return impl_ > other.impl_; }
 const pixel_format_desc&         const_frame::pixel_format_desc() const { return impl_->desc_; }
 const array<const std::uint8_t>& const_frame::image_data(std::size_t index) const { return impl_->image_data(index); }
+const array<const std::uint8_t>& const_frame::image_data(output_pixel_format format) const
+{
+    return impl_->image_data(output_rendition(format));
+}
+const array<const std::uint8_t>& const_frame::image_data(const output_rendition& rendition) const
+{
+    return impl_->image_data(rendition);
+}
 const array<const std::int32_t>& const_frame::audio_data() const { return impl_->audio_data_; }
 std::size_t                      const_frame::width() const { return impl_->width(); }
 std::size_t                      const_frame::height() const { return impl_->height(); }
 std::size_t                      const_frame::size() const { return impl_->size(); }
 const frame_geometry&            const_frame::geometry() const { return impl_->geometry_; }
 const boost::any&                const_frame::opaque() const { return impl_->opaque_; }
+const void*                      const_frame::stream_tag() const { return impl_->tag_; }
 const_frame::operator bool() const { return impl_ != nullptr && impl_->desc_.format != core::pixel_format::invalid; }
 }} // namespace caspar::core
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "pixel_format.h"
+
 #include <common/array.h>
 
 #include <boost/any.hpp>
@@ -8,6 +10,7 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace caspar { namespace core {
@@ -57,10 +60,13 @@ class mutable_frame final
 class const_frame final
 {
   public:
+    using converted_t = std::vector<std::pair<output_rendition, array<const std::uint8_t>>>;
+
     const_frame();
     explicit const_frame(std::vector<array<const std::uint8_t>> image_data,
                          array<const std::int32_t>              audio_data,
-                         const struct pixel_format_desc&        desc);
+                         const struct pixel_format_desc&        desc,
+                         converted_t                            converted = {});
     const_frame(const const_frame& other);
     const_frame(mutable_frame&& other);
 
@@ -72,6 +78,12 @@ class const_frame final
 
     const array<const std::uint8_t>& image_data(std::size_t index) const;
 
+    // The image converted to format by the mixer, empty unless a consumer requested it and the mixer supports it.
+    const array<const std::uint8_t>& image_data(output_pixel_format format) const;
+
+    // The image converted and scaled by the mixer, empty unless a consumer requested it and the mixer supports it.
+    const array<const std::uint8_t>& image_data(const output_rendition& rendition) const;
+
     const array<const std::int32_t>& audio_data() const;
 
     std::size_t width() const;
@@ -84,6 +96,9 @@ class const_frame final
 
     const class frame_geometry& geometry() const;
 
+    // Identifies the producer that created the frame, nullptr when unknown.
+    const void* stream_tag() const;
+
     bool operator==(const const_frame& other) const;
     bool operator!=(const const_frame& other) const;
     bool operator<(const const_frame& other) const;
@@ -21,6 +21,10 @@
 
 #pragma once
 
+#include <common/bit_depth.h>
+
+#include <vector>
+
 #ifdef WIN32
 #include <common/forward.h>
 #include <memory>
@@ -29,6 +33,15 @@ FORWARD3(caspar, accelerator, d3d, class d3d_texture2d);
 
 namespace caspar { namespace core {
 
+// A rectangle of the first image plane, in pixels.
+struct frame_region
+{
+    int x      = 0;
+    int y      = 0;
+    int width  = 0;
+    int height = 0;
+};
+
 class frame_factory
 {
   public:
@@ -40,11 +53,22 @@ class frame_factory
 
     virtual class mutable_frame create_frame(const void* video_stream_tag, const struct pixel_format_desc& desc) = 0;
 
+    // Creates a frame for producers that know which parts of their image changed since base, which must have the pixel
+    // format and size of desc. The image data of the returned frame still has to be written completely, as it can be
+    // read by the CPU, but accelerators may only upload the regions and reuse what they already uploaded for base.
+    virtual class mutable_frame create_frame(const void*                      video_stream_tag,
+                                             const struct pixel_format_desc&  desc,
+                                             const class const_frame&         base,
+                                             const std::vector<frame_region>& regions);
+
 #ifdef WIN32
     virtual class const_frame import_d3d_texture(const void* video_stream_tag,
                                                  const std::shared_ptr<accelerator::d3d::d3d_texture2d>& d3d_texture,
                                                  bool vflip = false) = 0;
 #endif
+
+    // Sample depth the mixer renders in, producers may upload planes up to this depth.
+    virtual bit_depth depth() const { return bit_depth::bit8; }
 };
 
 }} // namespace caspar::core
@@ -21,6 +21,8 @@
 
 #pragma once
 
+#include <common/bit_depth.h>
+
 #include <vector>
 
 namespace caspar { namespace core {
@@ -42,24 +44,62 @@ enum class pixel_format
     invalid,
 };
 
+// Formats the image mixer can convert its BGRA output to on behalf of consumers, see
+// frame_consumer::requested_pixel_formats. All use limited range BT.709 for HD and BT.601 for SD.
+enum class output_pixel_format
+{
+    uyvy = 0,  // 8-bit 4:2:2, U Y0 V Y1.
+    v210,      // 10-bit 4:2:2, 6 pixels in 4 little endian words, lines padded to 128 bytes.
+    yuv422p10, // 10-bit 4:2:2 planar, little endian 16-bit samples. Y, U and V planes are contiguous.
+    nv12,      // 8-bit 4:2:0, Y plane followed by interleaved UV plane.
+    bgra16,    // 16-bit BGRA, little endian samples. Only meaningful on channels mixing in more than 8 bits.
+    count,
+};
+
+// An output_pixel_format conversion of the mixer output scaled to width x height, see
+// frame_consumer::requested_renditions. A width and height of 0 keep the size of the channel.
+struct output_rendition final
+{
+    output_pixel_format format = output_pixel_format::uyvy;
+    int                 width  = 0;
+    int                 height = 0;
+
+    output_rendition() = default;
+    output_rendition(output_pixel_format format, int width = 0, int height = 0)
+        : format(format)
+        , width(width)
+        , height(height)
+    {
+    }
+};
+
+inline bool operator==(const output_rendition& lhs, const output_rendition& rhs)
+{
+    return lhs.format == rhs.format && lhs.width == rhs.width && lhs.height == rhs.height;
+}
+
+inline bool operator!=(const output_rendition& lhs, const output_rendition& rhs) { return !(lhs == rhs); }
+
 struct pixel_format_desc final
 {
     struct plane
     {
-        int linesize = 0;
-        int width    = 0;
-        int height   = 0;
-        int size     = 0;
-        int stride   = 0;
+        int       linesize = 0;
+        int       width    = 0;
+        int       height   = 0;
+        int       size     = 0;
+        int       stride   = 0; // Samples per pixel.
+        bit_depth depth    = bit_depth::bit8;
 
         plane() = default;
 
-        plane(int width, int height, int stride)
-            : linesize(width * stride)
+        plane(int width, int height, int stride, bit_depth depth = bit_depth::bit8)
+            : linesize(width * stride * bytes_per_sample(depth))
             , width(width)
             , height(height)
-            , size(width * height * stride)
+            , size(width * height * stride * bytes_per_sample(depth))
             , stride(stride)
+            , depth(depth)
         {
         }
     };
@@ -29,24 +29,69 @@
 
 #include <common/diagnostics/graph.h>
 
-#include <boost/container/flat_map.hpp>
 #include <boost/range/algorithm.hpp>
 
+#include <emmintrin.h>
+
+#include <algorithm>
 #include <atomic>
+#include <cmath>
 #include <stack>
 #include <vector>
 
 namespace caspar { namespace core {
 
-using namespace boost::container;
-
 struct audio_item
 {
-    audio_transform      transform;
+    const void*          tag;
+    float                volume;
     array<const int32_t> samples;
 };
 
-using audio_buffer_ps = std::vector<double>;
+struct item_volume
+{
+    const void* tag;
+    float       volume;
+    bool        matched;
+};
+
+// Largest float below 2^31, anything above does not convert to int32.
+static const float MAX_SAMPLE = 2147483520.0f;
+static const float MIN_SAMPLE = -2147483648.0f;
+
+static const int MAX_SIMD_PEAK_GROUPS = 16;
+
+// dst[n] += src[n] * volume
+static void mix_constant(float* dst, const int32_t* src, std::size_t count, float volume)
+{
+    const auto gain = _mm_set1_ps(volume);
+
+    std::size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        auto samples = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n)));
+        _mm_storeu_ps(dst + n, _mm_add_ps(_mm_loadu_ps(dst + n), _mm_mul_ps(samples, gain)));
+    }
+    for (; n < count; ++n) {
+        dst[n] += static_cast<float>(src[n]) * volume;
+    }
+}
+
+// dst[n] += src[n] * (from + delta * ramp[n])
+static void mix_ramp(float* dst, const int32_t* src, const float* ramp, std::size_t count, float from, float delta)
+{
+    const auto from4  = _mm_set1_ps(from);
+    const auto delta4 = _mm_set1_ps(delta);
+
+    std::size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        auto gain    = _mm_add_ps(from4, _mm_mul_ps(delta4, _mm_loadu_ps(ramp + n)));
+        auto samples = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n)));
+        _mm_storeu_ps(dst + n, _mm_add_ps(_mm_loadu_ps(dst + n), _mm_mul_ps(samples, gain)));
+    }
+    for (; n < count; ++n) {
+        dst[n] += static_cast<float>(src[n]) * (from + delta * ramp[n]);
+    }
+}
 
 struct audio_mixer::impl
 {
@@ -56,6 +101,16 @@ struct audio_mixer::impl
     std::atomic<float>                  master_volume_{1.0f};
     spl::shared_ptr<diagnostics::graph> graph_;
 
+    // Kept between frames so that mixing does not allocate once the format is known.
+    std::vector<float>       mixed_;
+    std::vector<float>       ramp_;
+    std::vector<float>       peaks_;
+    std::vector<int32_t>     max_;
+    std::vector<item_volume> volumes_;
+    std::vector<item_volume> next_volumes_;
+    int                      ramp_channels_      = 0;
+    float                    last_master_volume_ = 1.0f;
+
     impl(const impl&) = delete;
     impl& operator=(const impl&) = delete;
 
@@ -74,12 +129,21 @@ struct audio_mixer::impl
 
     void visit(const const_frame& frame)
     {
-        if (transform_stack_.top().volume < 0.002 || !frame.audio_data())
+        if (!frame.audio_data())
+            return;
+
+        auto volume = static_cast<float>(transform_stack_.top().volume);
+
+        // Inaudible items are still tracked so that they ramp in rather than start at full volume.
+        if (volume < 0.002f) {
+            next_volumes_.push_back(item_volume{frame.stream_tag(), 0.0f, false});
             return;
+        }
 
         audio_item item;
-        item.transform = transform_stack_.top();
-        item.samples   = frame.audio_data();
+        item.tag     = frame.stream_tag();
+        item.volume  = volume;
+        item.samples = frame.audio_data();
 
         items_.push_back(std::move(item));
     }
@@ -90,57 +154,138 @@ struct audio_mixer::impl
 
     float get_master_volume() { return master_volume_; }
 
+    // Volume the stream had in the previous frame, or the current volume if it is new.
+    float previous_volume(const void* tag, float volume)
+    {
+        for (auto& previous : volumes_) {
+            if (!previous.matched && previous.tag == tag) {
+                previous.matched = true;
+                return previous.volume;
+            }
+        }
+        return volume;
+    }
+
     array<const int32_t> mix(const video_format_desc& format_desc, int nb_samples)
     {
-        auto channels = format_desc.audio_channels;
-        auto items    = std::move(items_);
-        auto result   = std::vector<int32_t>(nb_samples * channels, 0);
-
-        auto mixed = std::vector<double>(nb_samples * channels, 0.0f);
-
-        for (auto& item : items) {
-            auto ptr  = item.samples.data();
-            auto size = result.size();
-            for (auto n = 0; n < size; ++n) {
-                if (n < item.samples.size()) {
-                    mixed[n] = static_cast<double>(ptr[n]) * item.transform.volume + mixed[n];
-                } else {
-                    auto offset = (item.samples.size()) - (channels - (n % channels));
-                    mixed[n]    = static_cast<double>(ptr[offset]) * item.transform.volume + mixed[n];
-                }
+        const auto channels = format_desc.audio_channels;
+        const auto size     = static_cast<std::size_t>(nb_samples * channels);
+
+        auto result = std::vector<int32_t>(size);
+
+        mixed_.assign(size, 0.0f);
+
+        // Volume changes are interpolated across the frame, ramp_[n] goes from 1/nb_samples to 1 for each sample.
+        if (ramp_.size() != size || ramp_channels_ != channels) {
+            ramp_channels_ = channels;
+            ramp_.resize(size);
+            for (std::size_t n = 0; n < size; ++n) {
+                ramp_[n] = static_cast<float>(n / channels + 1) / static_cast<float>(nb_samples);
             }
         }
 
-        auto master_volume = master_volume_.load();
-        for (auto n = 0; n < mixed.size(); ++n) {
-            auto sample = mixed[n] * master_volume;
-            if (sample > std::numeric_limits<int32_t>::max()) {
-                result[n] = std::numeric_limits<int32_t>::max();
-            } else if (sample < std::numeric_limits<int32_t>::min()) {
-                result[n] = std::numeric_limits<int32_t>::min();
+        for (auto& item : items_) {
+            auto from = previous_volume(item.tag, item.volume);
+            auto to   = item.volume;
+            next_volumes_.push_back(item_volume{item.tag, to, false});
+
+            auto ptr   = item.samples.data();
+            auto count = std::min(item.samples.size(), size);
+
+            if (std::abs(to - from) < 0.0001f) {
+                mix_constant(mixed_.data(), ptr, count, to);
             } else {
-                result[n] = static_cast<int32_t>(sample);
+                mix_ramp(mixed_.data(), ptr, ramp_.data(), count, from, to - from);
             }
-        }
 
-        auto max = std::vector<int32_t>(channels, std::numeric_limits<int32_t>::min());
-        for (size_t n = 0; n < result.size(); n += channels) {
-            for (int ch = 0; ch < channels; ++ch) {
-                max[ch] = std::max(max[ch], std::abs(result[n + ch]));
+            // Items that are short repeat their last sample.
+            for (auto n = count; n < size; ++n) {
+                auto offset = item.samples.size() - (channels - (n % channels));
+                mixed_[n] += static_cast<float>(ptr[offset]) * (from + (to - from) * ramp_[n]);
             }
         }
 
-        if (boost::range::count_if(max, [](auto val) { return val >= std::numeric_limits<int32_t>::max(); }) > 0) {
+        items_.clear();
+        std::swap(volumes_, next_volumes_);
+        next_volumes_.clear();
+
+        auto master_volume  = master_volume_.load();
+        auto master_from    = last_master_volume_;
+        last_master_volume_ = master_volume;
+
+        peaks_.assign(std::max(channels, 4), 0.0f);
+        finalize(result.data(), size, channels, master_from, master_volume - master_from);
+
+        max_.resize(channels);
+        bool clipping = false;
+        for (int ch = 0; ch < channels; ++ch) {
+            clipping |= peaks_[ch] > MAX_SAMPLE;
+            max_[ch] = static_cast<int32_t>(std::min(peaks_[ch], MAX_SAMPLE));
+        }
+
+        if (clipping) {
             graph_->set_tag(diagnostics::tag_severity::WARNING, "audio-clipping");
         }
 
-        state_["volume"] = std::move(max);
+        state_["volume"] = max_;
 
         graph_->set_value("volume",
-                          static_cast<double>(*boost::max_element(max)) / std::numeric_limits<int32_t>::max());
+                          static_cast<double>(*boost::max_element(max_)) / std::numeric_limits<int32_t>::max());
 
         return std::move(result);
     }
+
+    // Applies the master volume, clamps and converts to int32 while tracking the peak of every channel.
+    void finalize(int32_t* dst, std::size_t size, int channels, float from, float delta)
+    {
+        const auto src  = mixed_.data();
+        const auto ramp = ramp_.data();
+
+        std::size_t n = 0;
+
+        // The peak lanes line up with channels when four samples hold whole channel groups or whole frames.
+        if ((channels % 4 == 0 || 4 % channels == 0) && channels <= MAX_SIMD_PEAK_GROUPS * 4) {
+            const auto from4     = _mm_set1_ps(from);
+            const auto delta4    = _mm_set1_ps(delta);
+            const auto max4      = _mm_set1_ps(MAX_SAMPLE);
+            const auto min4      = _mm_set1_ps(MIN_SAMPLE);
+            const auto sign_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+            const auto groups    = static_cast<std::size_t>(std::max(channels / 4, 1));
+
+            __m128 peaks[MAX_SIMD_PEAK_GROUPS];
+            std::fill(peaks, peaks + groups, _mm_setzero_ps());
+
+            for (std::size_t group = 0; n + 4 <= size; n += 4) {
+                auto gain   = _mm_add_ps(from4, _mm_mul_ps(delta4, _mm_loadu_ps(ramp + n)));
+                auto sample = _mm_mul_ps(_mm_loadu_ps(src + n), gain);
+
+                peaks[group] = _mm_max_ps(peaks[group], _mm_and_ps(sample, sign_mask));
+
+                sample = _mm_min_ps(_mm_max_ps(sample, min4), max4);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + n), _mm_cvtps_epi32(sample));
+
+                if (++group == groups) {
+                    group = 0;
+                }
+            }
+
+            for (std::size_t group = 0; group < groups; ++group) {
+                alignas(16) float lanes[4];
+                _mm_store_ps(lanes, peaks[group]);
+                for (int lane = 0; lane < 4; ++lane) {
+                    auto& peak = peaks_[(group * 4 + lane) % channels];
+                    peak       = std::max(peak, lanes[lane]);
+                }
+            }
+        }
+
+        for (; n < size; ++n) {
+            auto sample = src[n] * (from + delta * ramp[n]);
+            auto& peak  = peaks_[n % channels];
+            peak        = std::max(peak, std::abs(sample));
+            dst[n]      = static_cast<int32_t>(std::lrint(std::min(std::max(sample, MIN_SAMPLE), MAX_SAMPLE)));
+        }
+    }
 };
 
 audio_mixer::audio_mixer(spl::shared_ptr<diagnostics::graph> graph)
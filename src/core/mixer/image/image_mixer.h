@@ -21,12 +21,19 @@
 
 #pragma once
 
+#include <common/forward.h>
+#include <common/memory.h>
+
 #include <core/frame/frame.h>
 #include <core/frame/frame_factory.h>
 #include <core/frame/frame_visitor.h>
+#include <core/frame/pixel_format.h>
 
 #include <cstdint>
 #include <future>
+#include <vector>
+
+FORWARD2(caspar, diagnostics, class graph);
 
 namespace caspar { namespace core {
 
@@ -45,9 +52,19 @@ class image_mixer
     void visit(const class const_frame& frame) override     = 0;
     void pop() override                                     = 0;
 
-    virtual std::future<array<const uint8_t>> operator()(const struct video_format_desc& format_desc) = 0;
+    // Renders the visited frames. The first image is BGRA, followed by one image per entry in renditions, which is left
+    // empty if the conversion is not supported. Without read_back, mixers that render on the GPU may leave the BGRA
+    // image empty, with the rendered texture as its storage.
+    virtual std::future<std::vector<array<const uint8_t>>>
+    operator()(const struct video_format_desc&      format_desc,
+               const std::vector<output_rendition>& renditions,
+               bool                                 read_back) = 0;
 
     class mutable_frame create_frame(const void* tag, const struct pixel_format_desc& desc) override = 0;
+    using frame_factory::create_frame;
+
+    // The channel graph, for mixers that report timings of their own.
+    virtual void set_graph(const spl::shared_ptr<caspar::diagnostics::graph>& graph) {}
 
 #ifdef WIN32
     class const_frame import_d3d_texture(const void*                                             tag,
@@ -57,9 +57,14 @@ struct mixer::impl
         , graph_(std::move(graph))
         , image_mixer_(std::move(image_mixer))
     {
+        image_mixer_->set_graph(graph_);
     }
 
-    const_frame operator()(std::vector<draw_frame> frames, const video_format_desc& format_desc, int nb_samples)
+    const_frame operator()(std::vector<draw_frame>              frames,
+                           const video_format_desc&             format_desc,
+                           int                                  nb_samples,
+                           const std::vector<output_rendition>& renditions,
+                           bool                                 read_back)
     {
         for (auto& frame : frames) {
             frame.accept(audio_mixer_);
@@ -67,20 +72,31 @@ struct mixer::impl
             frame.accept(*image_mixer_);
         }
 
-        auto image = (*image_mixer_)(format_desc);
+        auto image = (*image_mixer_)(format_desc, renditions, read_back);
         auto audio = audio_mixer_(format_desc, nb_samples);
 
         state_["audio"] = audio_mixer_.state();
 
-        buffer_.push(std::async(
-            std::launch::deferred,
-            [image = std::move(image), audio = std::move(audio), graph = graph_, format_desc, tag = this]() mutable {
-                auto desc = pixel_format_desc(pixel_format::bgra);
-                desc.planes.push_back(pixel_format_desc::plane(format_desc.width, format_desc.height, 4));
-                std::vector<array<const uint8_t>> image_data;
-                image_data.emplace_back(std::move(image.get()));
-                return const_frame(std::move(image_data), std::move(audio), desc);
-            }));
+        buffer_.push(
+            std::async(std::launch::deferred,
+                       [image = std::move(image), audio = std::move(audio), format_desc, renditions]() mutable {
+                           auto desc = pixel_format_desc(pixel_format::bgra);
+                           desc.planes.push_back(pixel_format_desc::plane(format_desc.width, format_desc.height, 4));
+
+                           auto images = image.get();
+
+                           std::vector<array<const uint8_t>> image_data;
+                           image_data.emplace_back(std::move(images.at(0)));
+
+                           const_frame::converted_t converted;
+                           for (std::size_t n = 0; n < renditions.size() && n + 1 < images.size(); ++n) {
+                               if (images[n + 1]) {
+                                   converted.emplace_back(renditions[n], std::move(images[n + 1]));
+                               }
+                           }
+
+                           return const_frame(std::move(image_data), std::move(audio), desc, std::move(converted));
+                       }));
 
         if (buffer_.size() < 2) {
             return const_frame{};
@@ -102,9 +118,13 @@ mixer::mixer(int channel_index, spl::shared_ptr<diagnostics::graph> graph, spl::
 }
 void        mixer::set_master_volume(float volume) { impl_->set_master_volume(volume); }
 float       mixer::get_master_volume() { return impl_->get_master_volume(); }
-const_frame mixer::operator()(std::vector<draw_frame> frames, const video_format_desc& format_desc, int nb_samples)
+const_frame mixer::operator()(std::vector<draw_frame>              frames,
+                              const video_format_desc&             format_desc,
+                              int                                  nb_samples,
+                              const std::vector<output_rendition>& renditions,
+                              bool                                 read_back)
 {
-    return (*impl_)(std::move(frames), format_desc, nb_samples);
+    return (*impl_)(std::move(frames), format_desc, nb_samples, renditions, read_back);
 }
 mutable_frame mixer::create_frame(const void* tag, const pixel_format_desc& desc)
 {
@@ -24,9 +24,12 @@
 #include <common/forward.h>
 #include <common/memory.h>
 
+#include <core/frame/pixel_format.h>
 #include <core/fwd.h>
 #include <core/monitor/monitor.h>
 
+#include <vector>
+
 FORWARD2(caspar, diagnostics, class graph);
 
 namespace caspar { namespace core {
@@ -41,7 +44,11 @@ class mixer final
                    spl::shared_ptr<caspar::diagnostics::graph> graph,
                    spl::shared_ptr<image_mixer>                image_mixer);
 
-    const_frame operator()(std::vector<draw_frame> frames, const video_format_desc& format_desc, int nb_samples);
+    const_frame operator()(std::vector<draw_frame>              frames,
+                           const video_format_desc&             format_desc,
+                           int                                  nb_samples,
+                           const std::vector<output_rendition>& renditions = {},
+                           bool                                 read_back  = true);
 
     void  set_master_volume(float volume);
     float get_master_volume();
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2013 Sveriges Television AB http://casparcg.com/
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+
+#include "../StdAfx.h"
+
+#include "monitor.h"
+
+#include <boost/functional/hash.hpp>
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace caspar { namespace core { namespace monitor {
+
+namespace {
+
+class path_registry
+{
+    std::mutex mutex_;
+
+    // Id 0 is the root which has no segments, unlike the path made of a single empty segment which prefixes joined
+    // paths with a slash. Strings are never moved or released once interned.
+    std::deque<std::string>                             paths_{std::string()};
+    std::unordered_multimap<std::size_t, std::uint32_t> ids_by_hash_;
+    std::unordered_map<std::uint64_t, std::uint32_t>    joins_;
+
+    std::uint32_t find_or_add(boost::string_view str)
+    {
+        const auto hash  = boost::hash_range(str.begin(), str.end());
+        const auto range = ids_by_hash_.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (paths_[it->second] == str) {
+                return it->second;
+            }
+        }
+
+        const auto id = static_cast<std::uint32_t>(paths_.size());
+        paths_.emplace_back(str.data(), str.size());
+        ids_by_hash_.emplace(hash, id);
+        return id;
+    }
+
+  public:
+    std::uint32_t intern(boost::string_view str)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return find_or_add(str);
+    }
+
+    std::uint32_t join(std::uint32_t parent, std::uint32_t child)
+    {
+        if (parent == 0) {
+            return child;
+        }
+        if (child == 0) {
+            return parent;
+        }
+
+        const auto key = static_cast<std::uint64_t>(parent) << 32 | child;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = joins_.find(key);
+        if (it != joins_.end()) {
+            return it->second;
+        }
+
+        const auto id = find_or_add(paths_[parent] + "/" + paths_[child]);
+        joins_.emplace(key, id);
+        return id;
+    }
+
+    const std::string& str(std::uint32_t id)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return paths_[id];
+    }
+};
+
+path_registry& registry()
+{
+    static path_registry instance;
+    return instance;
+}
+
+} // namespace
+
+path::path(boost::string_view str)
+    : id_(registry().intern(str))
+{
+}
+
+path path::operator/(const path& other) const { return path(registry().join(id_, other.id_)); }
+
+const std::string& path::str() const { return registry().str(id_); }
+
+}}} // namespace caspar::core::monitor
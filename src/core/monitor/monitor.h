@@ -21,10 +21,13 @@
 #pragma once
 
 #include <boost/lexical_cast.hpp>
+#include <boost/utility/string_view.hpp>
 #include <boost/variant.hpp>
 
 #include <cstdint>
+#include <functional>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include <boost/container/flat_map.hpp>
@@ -32,21 +35,73 @@
 
 namespace caspar { namespace core { namespace monitor {
 
+/**
+ * A monitor path such as "stage/layer/10/foreground/producer". Paths are interned in a process wide table the first
+ * time they are seen and afterwards only carried around as an id, so building, copying and comparing them neither
+ * allocates nor touches the path string.
+ */
+class path
+{
+    std::uint32_t id_ = 0;
+
+    explicit path(std::uint32_t id)
+        : id_(id)
+    {
+    }
+
+  public:
+    path() = default;
+    path(boost::string_view str);
+    path(const char* str)
+        : path(boost::string_view(str))
+    {
+    }
+    path(const std::string& str)
+        : path(boost::string_view(str))
+    {
+    }
+
+    path operator/(const path& other) const;
+
+    path operator/(boost::string_view segment) const { return *this / path(segment); }
+    path operator/(const char* segment) const { return *this / path(segment); }
+    path operator/(const std::string& segment) const { return *this / path(segment); }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, path>::type operator/(T index) const
+    {
+        return *this / path(std::to_string(index));
+    }
+
+    const std::string& str() const;
+    std::uint32_t      id() const { return id_; }
+    bool               empty() const { return id_ == 0; }
+
+    bool operator==(const path& other) const { return id_ == other.id_; }
+    bool operator!=(const path& other) const { return id_ != other.id_; }
+    bool operator<(const path& other) const { return id_ < other.id_; }
+};
+
 using data_t     = boost::variant<bool, std::int32_t, std::int64_t, float, double, std::string, std::wstring>;
 using vector_t   = boost::container::small_vector<data_t, 2>;
-using data_map_t = boost::container::flat_map<std::string, vector_t>;
+using data_map_t = boost::container::flat_map<path, vector_t>;
 
+/**
+ * Monitor values keyed by interned path and ordered by path id rather than alphabetically. Assigning to a path that
+ * already exists updates the value in place, and clear() keeps the storage so that a state which is rebuilt every
+ * frame settles without further allocations.
+ */
 class state
 {
     data_map_t data_;
 
     class state_proxy
     {
-        std::string key_;
+        path        key_;
         data_map_t& data_;
 
       public:
-        state_proxy(const std::string& key, data_map_t& data)
+        state_proxy(path key, data_map_t& data)
             : key_(key)
             , data_(data)
         {
@@ -54,39 +109,48 @@ class state
 
         state_proxy& operator=(data_t data)
         {
-            data_[key_] = {std::move(data)};
+            auto& value = data_[key_];
+            if (value.size() == 1) {
+                value.front() = std::move(data);
+            } else {
+                value.assign(1, std::move(data));
+            }
             return *this;
         }
 
-        state_proxy& operator=(vector_t data)
+        state_proxy& operator=(const vector_t& data)
         {
-            data_[key_] = std::move(data);
+            data_[key_] = data;
             return *this;
         }
 
         template <typename T>
         state_proxy operator[](const T& key)
         {
-            return state_proxy(key_ + "/" + boost::lexical_cast<std::string>(key), data_);
+            return state_proxy(key_ / key, data_);
         }
 
         template <typename T>
         state_proxy& operator=(const std::vector<T>& data)
         {
-            data_[key_] = vector_t(data.begin(), data.end());
+            data_[key_].assign(data.begin(), data.end());
             return *this;
         }
 
         state_proxy& operator=(std::initializer_list<data_t> data)
         {
-            data_[key_] = vector_t(std::move(data));
+            data_[key_].assign(data.begin(), data.end());
             return *this;
         }
 
         state_proxy& operator=(const state& other)
         {
+            // Paths are interned in the order they are first seen, so re-adding a subtree mostly appends.
+            if (data_.capacity() < data_.size() + other.data_.size()) {
+                data_.reserve(data_.size() + other.data_.size());
+            }
             for (auto& p : other) {
-                data_[key_ + "/" + p.first] = std::move(p.second);
+                data_[key_ / p.first] = p.second;
             }
             return *this;
         }
@@ -111,12 +175,30 @@ class state
     template <typename T>
     state_proxy operator[](const T& key)
     {
-        return state_proxy(boost::lexical_cast<std::string>(key), data_);
+        return state_proxy(path() / key, data_);
     }
 
+    /**
+     * Removes all values while keeping the allocated storage.
+     */
+    void clear() { data_.clear(); }
+
+    bool        empty() const { return data_.empty(); }
+    std::size_t size() const { return data_.size(); }
+
     data_map_t::const_iterator begin() const { return data_.begin(); }
 
     data_map_t::const_iterator end() const { return data_.end(); }
 };
 
 }}} // namespace caspar::core::monitor
+
+namespace std {
+
+template <>
+struct hash<caspar::core::monitor::path>
+{
+    std::size_t operator()(const caspar::core::monitor::path& path) const { return path.id(); }
+};
+
+} // namespace std
@@ -24,6 +24,7 @@
 #include "cg_proxy.h"
 #include "frame_producer.h"
 
+#include "../diagnostics/call_context.h"
 #include "../frame/draw_frame.h"
 
 #include "color/color_producer.h"
@@ -35,9 +36,17 @@
 #include <common/executor.h>
 #include <common/future.h>
 #include <common/memory.h>
+#include <common/scope_exit.h>
 
 #include <boost/algorithm/string/predicate.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+
 namespace caspar { namespace core {
 struct frame_producer_registry::impl
 {
@@ -177,6 +186,14 @@ class destroy_producer_proxy : public frame_producer
     draw_frame           last_frame() override { return producer_->last_frame(); }
     draw_frame           first_frame() override { return producer_->first_frame(); }
     core::monitor::state state() const override { return producer_->state(); }
+    bool                 is_ready() const override { return producer_->is_ready(); }
+    bool                 has_failed() const override { return producer_->has_failed(); }
+    void                 wait_until_ready() override { producer_->wait_until_ready(); }
+    void                 wait_for_first_frame(std::chrono::milliseconds timeout) override
+    {
+        producer_->wait_for_first_frame(timeout);
+    }
+    void offline(bool offline) override { producer_->offline(offline); }
 };
 
 spl::shared_ptr<core::frame_producer> create_destroy_proxy(spl::shared_ptr<core::frame_producer> producer)
@@ -222,12 +239,12 @@ spl::shared_ptr<core::frame_producer> do_create_producer(const frame_producer_de
 }
 
 spl::shared_ptr<core::frame_producer>
-frame_producer_registry::create_producer(const frame_producer_dependencies& dependencies,
-                                         const std::vector<std::wstring>&   params) const
+create_producer_with_key(const frame_producer_dependencies&     dependencies,
+                         const std::vector<std::wstring>&       params,
+                         const std::vector<producer_factory_t>& producer_factories)
 {
-    auto& producer_factories = impl_->producer_factories;
-    auto  producer           = do_create_producer(dependencies, params, producer_factories);
-    auto  key_producer       = frame_producer::empty();
+    auto producer     = do_create_producer(dependencies, params, producer_factories);
+    auto key_producer = frame_producer::empty();
 
     if (!params.empty() && !boost::contains(params.at(0), L"://")) {
         try // to find a key file.
@@ -257,6 +274,13 @@ frame_producer_registry::create_producer(const frame_producer_dependencies& depe
     return producer;
 }
 
+spl::shared_ptr<core::frame_producer>
+frame_producer_registry::create_producer(const frame_producer_dependencies& dependencies,
+                                         const std::vector<std::wstring>&   params) const
+{
+    return create_producer_with_key(dependencies, params, impl_->producer_factories);
+}
+
 spl::shared_ptr<core::frame_producer>
 frame_producer_registry::create_producer(const frame_producer_dependencies& dependencies,
                                          const std::wstring&                params) const
@@ -267,4 +291,192 @@ frame_producer_registry::create_producer(const frame_producer_dependencies& depe
     std::copy(iterator(iss), iterator(), std::back_inserter(tokens));
     return create_producer(dependencies, tokens);
 }
+
+class producer_loader
+{
+    // Several workers so that one slow or unresponsive input does not hold up every other load.
+    static const int NB_WORKERS = 4;
+
+    struct worker
+    {
+        std::unique_ptr<caspar::executor> executor;
+        std::atomic<int>                  pending{0};
+    };
+
+    std::array<worker, NB_WORKERS> workers_;
+
+  public:
+    producer_loader()
+    {
+        for (int n = 0; n < NB_WORKERS; ++n) {
+            workers_[n].executor = std::make_unique<caspar::executor>(L"producer-loader-" + std::to_wstring(n));
+            workers_[n].executor->set_capacity(std::numeric_limits<unsigned int>::max());
+        }
+    }
+
+    template <typename Func>
+    auto begin_invoke(Func&& func)
+    {
+        auto& worker = *std::min_element(workers_.begin(), workers_.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.pending < rhs.pending;
+        });
+
+        ++worker.pending;
+        return worker.executor->begin_invoke([&worker, func = std::forward<Func>(func)]() mutable {
+            CASPAR_SCOPE_EXIT { --worker.pending; };
+            return func();
+        });
+    }
+};
+
+producer_loader& loader()
+{
+    static producer_loader instance;
+    return instance;
+}
+
+class pending_producer : public frame_producer
+{
+    const std::wstring                                  description_;
+    std::shared_future<spl::shared_ptr<frame_producer>> future_;
+
+    // Used from the channel and from AMCP threads. producer_ is only replaced under the lock, and not at all once
+    // loaded_ is set. A failed load is loaded_ and failed_, and keeps the empty producer.
+    mutable std::mutex                      mutex_;
+    mutable spl::shared_ptr<frame_producer> producer_ = frame_producer::empty();
+    mutable std::atomic<bool>               loaded_{false};
+    mutable std::atomic<bool>               failed_{false};
+    std::shared_ptr<frame_producer>         leading_producer_;
+
+    spl::shared_ptr<frame_producer> producer() const
+    {
+        if (loaded_) {
+            return producer_;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!loaded_ && future_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            try {
+                producer_ = future_.get();
+            } catch (...) {
+                // Already logged by the loader, rethrown by wait_until_ready.
+                failed_ = true;
+            }
+            loaded_ = true;
+        }
+        return producer_;
+    }
+
+  public:
+    pending_producer(std::wstring description, std::shared_future<spl::shared_ptr<frame_producer>> future)
+        : description_(std::move(description))
+        , future_(std::move(future))
+    {
+    }
+
+    draw_frame receive_impl(int nb_samples) override
+    {
+        auto producer = this->producer();
+        if (loaded_) {
+            std::shared_ptr<frame_producer> leading_producer;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                leading_producer = std::move(leading_producer_);
+            }
+            if (leading_producer) {
+                producer->leading_producer(spl::make_shared_ptr(std::move(leading_producer)));
+            }
+        }
+        return producer->receive(nb_samples);
+    }
+
+    std::wstring print() const override
+    {
+        return is_ready() ? producer()->print() : L"pending[" + description_ + L"]";
+    }
+    std::wstring              name() const override { return is_ready() ? producer()->name() : L"pending"; }
+    std::future<std::wstring> call(const std::vector<std::wstring>& params) override
+    {
+        if (!is_ready()) {
+            CASPAR_THROW_EXCEPTION(invalid_operation() << msg_info(L"Producer is still loading: " + description_));
+        }
+        return producer()->call(params);
+    }
+    void leading_producer(const spl::shared_ptr<frame_producer>& producer) override
+    {
+        {
+            // Handed over by receive_impl once loaded.
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!loaded_) {
+                leading_producer_ = producer;
+                return;
+            }
+        }
+        this->producer()->leading_producer(producer);
+    }
+    spl::shared_ptr<frame_producer> following_producer() const override { return producer()->following_producer(); }
+    boost::optional<int64_t>        auto_play_delta() const override { return producer()->auto_play_delta(); }
+    uint32_t                        frame_number() const override { return producer()->frame_number(); }
+    uint32_t                        nb_frames() const override
+    {
+        return is_ready() ? producer()->nb_frames() : std::numeric_limits<uint32_t>::max();
+    }
+    draw_frame           last_frame() override { return producer()->last_frame(); }
+    draw_frame           first_frame() override { return producer()->first_frame(); }
+    core::monitor::state state() const override { return producer()->state(); }
+
+    bool is_ready() const override
+    {
+        producer();
+        return loaded_ && !failed_;
+    }
+
+    bool has_failed() const override
+    {
+        producer();
+        return failed_;
+    }
+
+    void wait_until_ready() override { future_.get(); }
+
+    void offline(bool offline) override
+    {
+        if (is_ready()) {
+            producer()->offline(offline);
+        }
+    }
+};
+
+spl::shared_ptr<core::frame_producer>
+frame_producer_registry::create_producer_async(const frame_producer_dependencies& dependencies,
+                                               const std::vector<std::wstring>&   params) const
+{
+    if (params.empty()) {
+        CASPAR_THROW_EXCEPTION(invalid_argument() << msg_info("params cannot be empty"));
+    }
+
+    auto context = diagnostics::call_context::for_thread();
+
+    auto future = loader().begin_invoke([=, impl = impl_] {
+        diagnostics::scoped_call_context save;
+        diagnostics::call_context::for_thread() = context;
+
+        try {
+            auto producer = create_producer_with_key(dependencies, params, impl->producer_factories);
+            if (producer == frame_producer::empty()) {
+                CASPAR_THROW_EXCEPTION(file_not_found() << msg_info(params.at(0) + L" not found"));
+            }
+
+            // Decode ahead so that the first frame is available as soon as the producer is played.
+            producer->wait_for_first_frame(std::chrono::seconds(2));
+
+            return producer;
+        } catch (...) {
+            CASPAR_LOG_CURRENT_EXCEPTION();
+            throw;
+        }
+    });
+
+    return spl::make_shared<pending_producer>(params.at(0), future.share());
+}
 }} // namespace caspar::core
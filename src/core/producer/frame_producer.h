@@ -32,6 +32,7 @@
 
 #include <boost/optional.hpp>
 
+#include <chrono>
 #include <cstdint>
 #include <functional>
 #include <future>
@@ -114,6 +115,34 @@ class frame_producer
     virtual void                            leading_producer(const spl::shared_ptr<frame_producer>&) {}
     virtual spl::shared_ptr<frame_producer> following_producer() const { return core::frame_producer::empty(); }
     virtual boost::optional<int64_t>        auto_play_delta() const { return boost::none; }
+
+    /**
+     * Producers that are created asynchronously are not ready until their input has been opened and their first
+     * frame decoded. Until then they produce empty frames.
+     */
+    virtual bool is_ready() const { return true; }
+
+    /**
+     * Producers that failed to load asynchronously never become ready and should be discarded.
+     */
+    virtual bool has_failed() const { return false; }
+
+    /**
+     * Blocks until the producer is ready, rethrowing the error if it failed to load.
+     */
+    virtual void wait_until_ready() {}
+
+    /**
+     * Blocks until the first frame can be received without waiting on decoding, or until the timeout. Producers that
+     * don't decode ahead return immediately.
+     */
+    virtual void wait_for_first_frame(std::chrono::milliseconds timeout) {}
+
+    /**
+     * Set before every frame is received. Producers that decode ahead should wait in receive on an offline channel
+     * rather than return an empty frame, which would repeat the last frame in the render.
+     */
+    virtual void offline(bool offline) {}
 };
 
 class frame_producer_registry;
@@ -146,6 +175,13 @@ class frame_producer_registry
     spl::shared_ptr<core::frame_producer> create_producer(const frame_producer_dependencies&,
                                                           const std::wstring& params) const;
 
+    /**
+     * Returns immediately with a producer that is created, and has its first frame decoded, on a loader thread so
+     * that slow inputs do not hold up the caller. Errors are logged and rethrown from wait_until_ready().
+     */
+    spl::shared_ptr<core::frame_producer> create_producer_async(const frame_producer_dependencies&,
+                                                                const std::vector<std::wstring>& params) const;
+
   private:
     struct impl;
     spl::shared_ptr<impl> impl_;
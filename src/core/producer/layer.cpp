@@ -59,8 +59,22 @@ struct layer::impl
         }
     }
 
+    // Asynchronously loaded producers that failed are dropped rather than played, the error is already logged.
+    void drop_failed_producers()
+    {
+        if (background_->has_failed()) {
+            background_ = frame_producer::empty();
+            auto_play_  = false;
+        }
+        if (foreground_->has_failed()) {
+            foreground_ = frame_producer::empty();
+        }
+    }
+
     void play()
     {
+        drop_failed_producers();
+
         if (background_ != frame_producer::empty()) {
             if (!paused_) {
                 background_->leading_producer(foreground_);
@@ -83,13 +97,15 @@ struct layer::impl
         auto_play_  = false;
     }
 
-    draw_frame receive(const video_format_desc& format_desc, int nb_samples)
+    draw_frame receive(const video_format_desc& format_desc, int nb_samples, bool offline)
     {
         try {
             if (foreground_->following_producer() != core::frame_producer::empty()) {
                 foreground_ = foreground_->following_producer();
             }
 
+            drop_failed_producers();
+
             int64_t frames_left = 0;
             if (auto_play_) {
                 auto auto_play_delta = background_->auto_play_delta();
@@ -97,18 +113,21 @@ struct layer::impl
                     auto time     = static_cast<std::int64_t>(foreground_->frame_number());
                     auto duration = static_cast<std::int64_t>(foreground_->nb_frames());
                     frames_left   = duration - time - *auto_play_delta;
-                    if (frames_left < 1) {
+                    // Keep showing the foreground until an asynchronously loaded background is ready.
+                    if (frames_left < 1 && background_->is_ready()) {
                         play();
                     }
                 }
             }
 
+            foreground_->offline(offline);
+
             auto frame = paused_ ? core::draw_frame{} : foreground_->receive(nb_samples);
             if (!frame) {
                 frame = foreground_->last_frame();
             }
 
-            state_                           = {};
+            state_.clear();
             state_["foreground"]             = foreground_->state();
             state_["foreground"]["producer"] = foreground_->name();
             state_["foreground"]["paused"]   = paused_;
@@ -119,6 +138,7 @@ struct layer::impl
 
             state_["background"]             = background_->state();
             state_["background"]["producer"] = background_->name();
+            state_["background"]["ready"]    = background_->is_ready();
 
             return frame;
         } catch (...) {
@@ -163,9 +183,9 @@ void       layer::play() { impl_->play(); }
 void       layer::pause() { impl_->pause(); }
 void       layer::resume() { impl_->resume(); }
 void       layer::stop() { impl_->stop(); }
-draw_frame layer::receive(const video_format_desc& format_desc, int nb_samples)
+draw_frame layer::receive(const video_format_desc& format_desc, int nb_samples, bool offline)
 {
-    return impl_->receive(format_desc, nb_samples);
+    return impl_->receive(format_desc, nb_samples, offline);
 }
 draw_frame layer::receive_background(const video_format_desc& format_desc, int nb_samples)
 {
@@ -49,7 +49,7 @@ class layer final
     void resume();
     void stop();
 
-    draw_frame receive(const video_format_desc& format_desc, int nb_samples);
+    draw_frame receive(const video_format_desc& format_desc, int nb_samples, bool offline = false);
     draw_frame receive_background(const video_format_desc& format_desc, int nb_samples);
 
     core::monitor::state state() const;
@@ -0,0 +1,625 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../../StdAfx.h"
+
+#include "media_index.h"
+
+#include "../cg_proxy.h"
+
+#include <common/env.h>
+#include <common/executor.h>
+#include <common/log.h>
+#include <common/os/filesystem_monitor.h>
+#include <common/timer.h>
+#include <common/utf.h>
+
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <tbb/parallel_for_each.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+
+namespace caspar { namespace core {
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+const std::string CACHE_HEADER = "casparcg-media-index 1";
+
+enum class folder_kind
+{
+    media,
+    templates,
+    fonts
+};
+
+struct folder
+{
+    folder_kind                                kind;
+    std::wstring                               root;
+    std::map<std::wstring, media_index::entry> entries; // By path.
+};
+
+std::wstring generic_root(const std::wstring& folder)
+{
+    auto root = fs::path(folder).generic_wstring();
+    if (root.empty() || root.back() != L'/')
+        root += L'/';
+    return root;
+}
+
+std::wstring make_id(const std::wstring& root, const std::wstring& path)
+{
+    auto relative = boost::starts_with(path, root) ? path.substr(root.size()) : fs::path(path).filename().wstring();
+    auto extension = fs::path(relative).extension().wstring();
+    return boost::to_upper_copy(relative.substr(0, relative.size() - extension.size()));
+}
+
+bool in_scope(const std::wstring& path, const std::wstring& scope)
+{
+    return path == scope || boost::starts_with(path, scope.back() == L'/' ? scope : scope + L'/');
+}
+
+bool is_hidden(const fs::path& path) { return boost::starts_with(path.filename().wstring(), L"."); }
+
+} // namespace
+
+struct media_index::impl
+{
+    spl::shared_ptr<const cg_producer_registry> cg_registry_;
+    std::vector<media_info_extractor>           extractors_;
+    thumbnail_generator                         thumbnail_generator_;
+
+    mutable std::mutex                  mutex_;
+    folder                              media_{folder_kind::media};
+    folder                              templates_{folder_kind::templates};
+    folder                              fonts_{folder_kind::fonts};
+    std::map<std::wstring, entry>       thumbnails_;         // By id.
+    std::map<std::wstring, std::time_t> thumbnail_failures_; // By path.
+
+    fs::path          cache_file_;
+    fs::path          thumbnail_folder_;
+    bool              save_pending_ = false;
+    std::atomic<bool> abort_request_{false};
+
+    executor                                         executor_{L"media-index"};
+    std::vector<std::unique_ptr<filesystem_monitor>> monitors_;
+
+    impl(spl::shared_ptr<const cg_producer_registry> cg_registry)
+        : cg_registry_(std::move(cg_registry))
+    {
+    }
+
+    ~impl()
+    {
+        abort_request_ = true;
+        monitors_.clear();
+    }
+
+    void start()
+    {
+        media_.root     = generic_root(env::media_folder());
+        templates_.root = generic_root(env::template_folder());
+        fonts_.root     = generic_root(env::font_folder());
+
+        auto index_folder = fs::path(env::data_folder()) / L"media-index";
+        cache_file_       = index_folder / L"media.cache";
+        thumbnail_folder_ = index_folder / L"thumbnails";
+
+        boost::system::error_code ec;
+        fs::create_directories(thumbnail_folder_, ec);
+        if (ec)
+            CASPAR_LOG(warning) << L"[media_index] Unable to create " << thumbnail_folder_.wstring();
+
+        for (auto f : {&media_, &templates_, &fonts_}) {
+            try {
+                monitors_.push_back(std::make_unique<filesystem_monitor>(f->root, [this, f](const fs::path& path) {
+                    executor_.begin_invoke([=] { update(*f, path.generic_wstring()); });
+                }));
+            } catch (...) {
+                CASPAR_LOG_CURRENT_EXCEPTION();
+                CASPAR_LOG(warning) << L"[media_index] Changes in " << f->root << L" will not be picked up.";
+            }
+        }
+
+        executor_.begin_invoke([=] {
+            caspar::timer timer;
+
+            load_cache();
+            load_thumbnails();
+
+            for (auto f : {&media_, &templates_, &fonts_}) {
+                scan(*f, f->root);
+            }
+
+            save_cache();
+
+            CASPAR_LOG(info) << L"[media_index] Indexed " << media().size() << L" media files, "
+                             << templates().size() << L" templates and " << fonts().size() << L" fonts in "
+                             << timer.elapsed() << L"s.";
+
+            generate_missing_thumbnails();
+        });
+    }
+
+    // Crawling
+
+    bool accepts(const folder& f, const fs::path& path) const
+    {
+        if (is_hidden(path))
+            return false;
+
+        if (f.kind == folder_kind::templates)
+            return cg_registry_->is_cg_extension(path.extension().wstring());
+
+        return true;
+    }
+
+    bool stat(const folder& f, const fs::path& path, entry& e) const
+    {
+        boost::system::error_code ec;
+
+        e.path       = path.generic_wstring();
+        e.id         = make_id(f.root, e.path);
+        e.size       = fs::file_size(path, ec);
+        e.last_write = fs::last_write_time(path, ec);
+
+        return !ec;
+    }
+
+    void probe(entry& e) const
+    {
+        e.info = media_info();
+
+        for (auto& extractor : extractors_) {
+            try {
+                if (extractor(e.path, e.info))
+                    return;
+            } catch (...) {
+                CASPAR_LOG_CURRENT_EXCEPTION();
+            }
+            e.info = media_info();
+        }
+    }
+
+    // Returns the entries that were new or changed.
+    std::vector<entry> scan(folder& f, const std::wstring& scope)
+    {
+        std::vector<entry> found;
+
+        boost::system::error_code ec;
+        if (fs::is_regular_file(scope, ec)) {
+            entry e;
+            if (accepts(f, scope) && stat(f, scope, e))
+                found.push_back(std::move(e));
+        } else {
+            for (fs::recursive_directory_iterator it(scope, ec), end; !ec && it != end && !abort_request_;
+                 it.increment(ec)) {
+                if (is_hidden(it->path())) {
+                    if (fs::is_directory(it->status()))
+                        it.no_push();
+                    continue;
+                }
+
+                entry e;
+                if (fs::is_regular_file(it->status()) && accepts(f, it->path()) && stat(f, it->path(), e))
+                    found.push_back(std::move(e));
+            }
+        }
+
+        if (abort_request_)
+            return {};
+
+        // Only probe what is new or has changed since it was last indexed.
+        std::vector<entry*> changed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& e : found) {
+                auto it = f.entries.find(e.path);
+                if (it != f.entries.end() && it->second.size == e.size && it->second.last_write == e.last_write)
+                    e.info = it->second.info;
+                else if (f.kind == folder_kind::media)
+                    changed.push_back(&e);
+            }
+        }
+
+        tbb::parallel_for_each(changed.begin(), changed.end(), [&](entry* e) {
+            if (!abort_request_)
+                probe(*e);
+        });
+
+        std::vector<entry> result;
+        for (auto e : changed)
+            result.push_back(*e);
+
+        std::vector<std::wstring> removed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            std::set<std::wstring> found_paths;
+            for (auto& e : found)
+                found_paths.insert(e.path);
+
+            auto it = f.entries.lower_bound(scope);
+            while (it != f.entries.end() && boost::starts_with(it->first, scope)) {
+                if (in_scope(it->first, scope) && found_paths.find(it->first) == found_paths.end()) {
+                    removed.push_back(it->second.id);
+                    it = f.entries.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+            for (auto& e : found)
+                f.entries[e.path] = std::move(e);
+        }
+
+        if (f.kind == folder_kind::media) {
+            for (auto& id : removed)
+                remove_thumbnail(id);
+        }
+
+        if (!changed.empty() || !removed.empty())
+            schedule_save();
+
+        return result;
+    }
+
+    void update(folder& f, const std::wstring& path)
+    {
+        if (abort_request_)
+            return;
+
+        auto changed = scan(f, path);
+
+        if (f.kind == folder_kind::media)
+            generate_missing_thumbnails(changed);
+    }
+
+    // Cache
+
+    void load_cache()
+    {
+        boost::filesystem::ifstream file(cache_file_);
+        if (!file)
+            return;
+
+        std::string line;
+        if (!std::getline(file, line) || line != CACHE_HEADER) {
+            CASPAR_LOG(warning) << L"[media_index] Ignoring unknown cache " << cache_file_.wstring();
+            return;
+        }
+
+        std::map<std::wstring, entry> entries;
+
+        while (std::getline(file, line)) {
+            std::vector<std::string> fields;
+            boost::split(fields, line, boost::is_any_of("\t"));
+            if (fields.size() != 7)
+                continue;
+
+            try {
+                entry e;
+                e.path           = u16(fields[0]);
+                e.id             = make_id(media_.root, e.path);
+                e.size           = boost::lexical_cast<std::uintmax_t>(fields[1]);
+                e.last_write     = boost::lexical_cast<std::time_t>(fields[2]);
+                e.info.clip_type = u16(fields[3]);
+                e.info.duration  = boost::lexical_cast<std::int64_t>(fields[4]);
+                e.info.time_base = boost::rational<std::int64_t>(boost::lexical_cast<std::int64_t>(fields[5]),
+                                                                 boost::lexical_cast<std::int64_t>(fields[6]));
+                entries[e.path] = std::move(e);
+            } catch (...) {
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        media_.entries = std::move(entries);
+    }
+
+    void save_cache()
+    {
+        std::vector<entry> entries;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& p : media_.entries)
+                entries.push_back(p.second);
+        }
+
+        auto tmp_file = fs::path(cache_file_.wstring() + L".tmp");
+        {
+            boost::filesystem::ofstream file(tmp_file, std::ios::trunc);
+            if (!file) {
+                CASPAR_LOG(warning) << L"[media_index] Unable to write " << tmp_file.wstring();
+                return;
+            }
+
+            file << CACHE_HEADER << "\n";
+            for (auto& e : entries) {
+                file << u8(e.path) << "\t" << e.size << "\t" << e.last_write << "\t" << u8(e.info.clip_type) << "\t"
+                     << e.info.duration << "\t" << e.info.time_base.numerator() << "\t"
+                     << e.info.time_base.denominator() << "\n";
+            }
+        }
+
+        boost::system::error_code ec;
+        fs::rename(tmp_file, cache_file_, ec);
+        if (ec)
+            CASPAR_LOG(warning) << L"[media_index] Unable to write " << cache_file_.wstring();
+    }
+
+    void schedule_save()
+    {
+        if (save_pending_)
+            return;
+
+        save_pending_ = true;
+        executor_.begin_invoke([=] {
+            save_pending_ = false;
+            save_cache();
+        });
+    }
+
+    // Thumbnails
+
+    fs::path thumbnail_path(const std::wstring& id) const { return thumbnail_folder_ / (id + L".png"); }
+
+    void load_thumbnails()
+    {
+        auto root = generic_root(thumbnail_folder_.wstring());
+
+        std::map<std::wstring, entry> thumbnails;
+
+        boost::system::error_code ec;
+        for (fs::recursive_directory_iterator it(thumbnail_folder_, ec), end; !ec && it != end; it.increment(ec)) {
+            entry e;
+            if (fs::is_regular_file(it->status()) && stat(folder{folder_kind::media, root}, it->path(), e))
+                thumbnails[e.id] = std::move(e);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        thumbnails_ = std::move(thumbnails);
+    }
+
+    bool generate_thumbnail(const entry& media)
+    {
+        if (!thumbnail_generator_ || media.info.clip_type.empty() || media.info.clip_type == L"AUDIO")
+            return false;
+
+        std::vector<std::uint8_t> png;
+        try {
+            png = thumbnail_generator_(media.path);
+        } catch (...) {
+            CASPAR_LOG_CURRENT_EXCEPTION();
+        }
+
+        if (png.empty()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            thumbnail_failures_[media.path] = media.last_write;
+            return false;
+        }
+
+        auto path = thumbnail_path(media.id);
+
+        boost::system::error_code ec;
+        fs::create_directories(path.parent_path(), ec);
+
+        {
+            boost::filesystem::ofstream file(path, std::ios::binary | std::ios::trunc);
+            if (!file)
+                return false;
+            file.write(reinterpret_cast<const char*>(png.data()), png.size());
+        }
+
+        entry thumbnail;
+        thumbnail.id         = media.id;
+        thumbnail.path       = path.generic_wstring();
+        thumbnail.size       = png.size();
+        thumbnail.last_write = fs::last_write_time(path, ec);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        thumbnails_[media.id] = std::move(thumbnail);
+        return true;
+    }
+
+    void remove_thumbnail(const std::wstring& id)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (thumbnails_.erase(id) == 0)
+                return;
+        }
+
+        boost::system::error_code ec;
+        fs::remove(thumbnail_path(id), ec);
+    }
+
+    // Expects mutex_ to be held.
+    bool is_thumbnail_missing(const entry& e) const
+    {
+        if (e.info.clip_type.empty() || e.info.clip_type == L"AUDIO")
+            return false;
+
+        auto failure = thumbnail_failures_.find(e.path);
+        if (failure != thumbnail_failures_.end() && failure->second == e.last_write)
+            return false;
+
+        auto it = thumbnails_.find(e.id);
+        return it == thumbnails_.end() || it->second.last_write < e.last_write;
+    }
+
+    void generate_thumbnails(const std::vector<entry>& missing)
+    {
+        tbb::parallel_for_each(missing.begin(), missing.end(), [&](const entry& e) {
+            if (!abort_request_)
+                generate_thumbnail(e);
+        });
+    }
+
+    // Only looks at the given entries, e.g. the ones a folder event changed.
+    void generate_missing_thumbnails(const std::vector<entry>& candidates)
+    {
+        if (!thumbnail_generator_ || candidates.empty())
+            return;
+
+        std::vector<entry> missing;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& e : candidates) {
+                if (is_thumbnail_missing(e))
+                    missing.push_back(e);
+            }
+        }
+
+        generate_thumbnails(missing);
+    }
+
+    // Sweeps the whole media folder, on start and when all thumbnails are regenerated.
+    void generate_missing_thumbnails()
+    {
+        if (!thumbnail_generator_)
+            return;
+
+        std::vector<entry> missing;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& p : media_.entries) {
+                if (is_thumbnail_missing(p.second))
+                    missing.push_back(p.second);
+            }
+        }
+
+        generate_thumbnails(missing);
+    }
+
+    // Queries
+
+    std::vector<entry> list(const folder& f) const
+    {
+        std::vector<entry> result;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& p : f.entries) {
+                if (f.kind != folder_kind::media || !p.second.info.clip_type.empty())
+                    result.push_back(p.second);
+            }
+        }
+
+        std::sort(result.begin(), result.end(), [](const entry& a, const entry& b) { return a.id < b.id; });
+        return result;
+    }
+
+    std::vector<entry> media() const { return list(media_); }
+
+    std::vector<entry> media(const std::wstring& id) const
+    {
+        auto upper_id = boost::to_upper_copy(id);
+
+        std::vector<entry> result;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& p : media_.entries) {
+            if (p.second.id == upper_id && !p.second.info.clip_type.empty())
+                result.push_back(p.second);
+        }
+        return result;
+    }
+
+    std::vector<entry> templates() const { return list(templates_); }
+
+    std::vector<entry> fonts() const { return list(fonts_); }
+
+    std::vector<entry> thumbnails() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        std::vector<entry> result;
+        for (auto& p : thumbnails_)
+            result.push_back(p.second);
+        return result;
+    }
+
+    std::vector<std::uint8_t> thumbnail(const std::wstring& id) const
+    {
+        fs::path path;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto                        it = thumbnails_.find(boost::to_upper_copy(id));
+            if (it == thumbnails_.end())
+                return {};
+            path = it->second.path;
+        }
+
+        boost::filesystem::ifstream file(path, std::ios::binary);
+        return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+};
+
+media_index::media_index(spl::shared_ptr<const cg_producer_registry> cg_registry)
+    : impl_(new impl(std::move(cg_registry)))
+{
+}
+media_index::~media_index() {}
+void media_index::register_extractor(media_info_extractor extractor)
+{
+    impl_->extractors_.push_back(std::move(extractor));
+}
+void media_index::register_thumbnail_generator(thumbnail_generator generator)
+{
+    impl_->thumbnail_generator_ = std::move(generator);
+}
+void                             media_index::start() { impl_->start(); }
+std::vector<media_index::entry>  media_index::media() const { return impl_->media(); }
+std::vector<media_index::entry>  media_index::media(const std::wstring& id) const { return impl_->media(id); }
+std::vector<media_index::entry>  media_index::templates() const { return impl_->templates(); }
+std::vector<media_index::entry>  media_index::fonts() const { return impl_->fonts(); }
+std::vector<media_index::entry>  media_index::thumbnails() const { return impl_->thumbnails(); }
+std::vector<std::uint8_t>        media_index::thumbnail(const std::wstring& id) const { return impl_->thumbnail(id); }
+bool                             media_index::generate_thumbnail(const std::wstring& id)
+{
+    bool result = false;
+    for (auto& e : impl_->media(id))
+        result = impl_->generate_thumbnail(e) || result;
+    return result;
+}
+void media_index::generate_all_thumbnails()
+{
+    impl_->executor_.begin_invoke([=] {
+        {
+            std::lock_guard<std::mutex> lock(impl_->mutex_);
+            impl_->thumbnails_.clear();
+            impl_->thumbnail_failures_.clear();
+        }
+        impl_->generate_missing_thumbnails();
+    });
+}
+
+}} // namespace caspar::core
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "media_info.h"
+
+#include "../../fwd.h"
+
+#include <common/memory.h>
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace caspar { namespace core {
+
+/**
+ * In-process index of the media, template and font folders. The folders are crawled once on start, kept up to date
+ * through filesystem notifications and the probed media information is persisted in the data folder so that
+ * unchanged files are not probed again on restart.
+ */
+class media_index
+{
+  public:
+    struct entry
+    {
+        std::wstring   id; // Path relative to its folder, without extension, in upper case.
+        std::wstring   path;
+        std::uintmax_t size       = 0;
+        std::time_t    last_write = 0;
+        media_info     info;
+    };
+
+    explicit media_index(spl::shared_ptr<const cg_producer_registry> cg_registry);
+    ~media_index();
+
+    void register_extractor(media_info_extractor extractor);
+    void register_thumbnail_generator(thumbnail_generator generator);
+
+    void start();
+
+    std::vector<entry> media() const;
+    std::vector<entry> media(const std::wstring& id) const;
+    std::vector<entry> templates() const;
+    std::vector<entry> fonts() const;
+
+    std::vector<entry>        thumbnails() const;
+    std::vector<std::uint8_t> thumbnail(const std::wstring& id) const;
+    bool                      generate_thumbnail(const std::wstring& id);
+    void                      generate_all_thumbnails();
+
+  private:
+    struct impl;
+    spl::shared_ptr<impl> impl_;
+
+    media_index(const media_index&) = delete;
+    media_index& operator=(const media_index&) = delete;
+};
+
+}} // namespace caspar::core
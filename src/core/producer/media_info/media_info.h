@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <boost/rational.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace caspar { namespace core {
+
+struct media_info
+{
+    std::wstring                  clip_type; // MOVIE, STILL or AUDIO
+    std::int64_t                  duration = 0;
+    boost::rational<std::int64_t> time_base;
+};
+
+/**
+ * Fills in info for the file at path. Returns false if the file is not recognized.
+ */
+using media_info_extractor = std::function<bool(const std::wstring& path, media_info& info)>;
+
+/**
+ * Returns a PNG encoded thumbnail for the file at path, or an empty vector if none could be generated.
+ */
+using thumbnail_generator = std::function<std::vector<std::uint8_t>(const std::wstring& path)>;
+
+}} // namespace caspar::core
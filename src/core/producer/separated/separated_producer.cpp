@@ -107,6 +107,28 @@ class separated_producer : public frame_producer
     std::wstring name() const override { return L"separated"; }
 
     core::monitor::state state() const override { return state_; }
+
+    bool is_ready() const override { return fill_producer_->is_ready() && key_producer_->is_ready(); }
+
+    bool has_failed() const override { return fill_producer_->has_failed() || key_producer_->has_failed(); }
+
+    void wait_until_ready() override
+    {
+        fill_producer_->wait_until_ready();
+        key_producer_->wait_until_ready();
+    }
+
+    void wait_for_first_frame(std::chrono::milliseconds timeout) override
+    {
+        fill_producer_->wait_for_first_frame(timeout);
+        key_producer_->wait_for_first_frame(timeout);
+    }
+
+    void offline(bool offline) override
+    {
+        fill_producer_->offline(offline);
+        key_producer_->offline(offline);
+    }
 };
 
 spl::shared_ptr<frame_producer> create_separated_producer(const spl::shared_ptr<frame_producer>& fill,
@@ -36,6 +36,7 @@
 
 #include <boost/range/adaptors.hpp>
 
+#include <atomic>
 #include <functional>
 #include <future>
 #include <map>
@@ -51,6 +52,7 @@ struct stage::impl : public std::enable_shared_from_this<impl>
     std::map<int, layer>                layers_;
     std::map<int, tweened_transform>    tweens_;
     std::set<int>                       routeSources;
+    std::atomic<bool>                   offline_{false};
 
     executor executor_{L"stage " + std::to_wstring(channel_index_)};
 
@@ -134,8 +136,10 @@ struct stage::impl : public std::enable_shared_from_this<impl>
                     auto& layer = p->second;
                     auto& tween = tweens_[p->first];
 
+                    auto frame = layer.receive(format_desc, nb_samples, offline_);
+
                     layer_frame res    = {};
-                    res.foreground     = draw_frame::push(layer.receive(format_desc, nb_samples), tween.fetch());
+                    res.foreground     = draw_frame::push(std::move(frame), tween.fetch());
                     res.has_background = layer.has_background();
                     if (std::find(fetch_background.begin(), fetch_background.end(), p->first) !=
                         fetch_background.end()) {
@@ -156,11 +160,10 @@ struct stage::impl : public std::enable_shared_from_this<impl>
                 chan_lf.foreground  = draw_frame(stage_frames);
                 routesCb(-1, chan_lf);
 
-                monitor::state state;
+                state_.clear();
                 for (auto& p : layers_) {
-                    state["layer"][p.first] = p.second.state();
+                    state_["layer"][p.first] = p.second.state();
                 }
-                state_ = std::move(state);
             } catch (...) {
                 layers_.clear();
                 CASPAR_LOG_CURRENT_EXCEPTION();
@@ -391,4 +394,5 @@ std::vector<draw_frame> stage::operator()(const video_format_desc&
     return (*impl_)(format_desc, nb_samples, fetch_background, routesCb);
 }
 core::monitor::state stage::state() const { return impl_->state_; }
+void                 stage::offline(bool offline) { impl_->offline_ = offline; }
 }} // namespace caspar::core
@@ -84,6 +84,9 @@ class stage final
 
     core::monitor::state state() const;
 
+    // Passed on to the producers, see frame_producer::offline.
+    void offline(bool offline);
+
     std::future<std::shared_ptr<frame_producer>> foreground(int index);
     std::future<std::shared_ptr<frame_producer>> background(int index);
 
@@ -207,6 +207,31 @@ class sting_producer : public frame_producer
     }
 
     monitor::state state() const override { return state_; }
+
+    bool is_ready() const override
+    {
+        return dst_producer_->is_ready() && mask_producer_->is_ready() && overlay_producer_->is_ready();
+    }
+
+    bool has_failed() const override
+    {
+        return dst_producer_->has_failed() || mask_producer_->has_failed() || overlay_producer_->has_failed();
+    }
+
+    void wait_until_ready() override
+    {
+        dst_producer_->wait_until_ready();
+        mask_producer_->wait_until_ready();
+        overlay_producer_->wait_until_ready();
+    }
+
+    void offline(bool offline) override
+    {
+        src_producer_->offline(offline);
+        dst_producer_->offline(offline);
+        mask_producer_->offline(offline);
+        overlay_producer_->offline(offline);
+    }
 };
 
 spl::shared_ptr<frame_producer> create_sting_producer(const frame_producer_dependencies&     dependencies,
@@ -174,6 +174,18 @@ class transition_producer : public frame_producer
     }
 
     core::monitor::state state() const override { return state_; }
+
+    bool is_ready() const override { return dst_producer_->is_ready(); }
+
+    bool has_failed() const override { return dst_producer_->has_failed(); }
+
+    void wait_until_ready() override { dst_producer_->wait_until_ready(); }
+
+    void offline(bool offline) override
+    {
+        src_producer_->offline(offline);
+        dst_producer_->offline(offline);
+    }
 };
 
 spl::shared_ptr<frame_producer> create_transition_producer(const spl::shared_ptr<frame_producer>& destination,
@@ -39,6 +39,8 @@
 #include <core/diagnostics/call_context.h>
 #include <core/mixer/image/image_mixer.h>
 
+#include <deque>
+#include <future>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -51,6 +53,7 @@ bool operator<(const route_id& a, const route_id& b) { return a.mode + (a.index
 struct video_channel::impl final
 {
     monitor::state state_;
+    monitor::state next_state_;
 
     const int index_;
 
@@ -68,8 +71,18 @@ struct video_channel::impl final
     caspar::core::mixer          mixer_;
     caspar::core::stage          stage_;
 
+    const int                                  pipeline_depth_;
+    std::unique_ptr<executor>                  mix_executor_;
+    std::unique_ptr<executor>                  consume_executor_;
+    std::deque<std::future<std::future<void>>> pipeline_;
+
     uint64_t frame_counter_ = 0;
 
+    // The frame rate actually achieved, which exceeds the channel frame rate when offline.
+    caspar::timer fps_timer_;
+    int           fps_frames_ = 0;
+    double        fps_        = 0.0;
+
     std::function<void(core::monitor::state)> tick_;
 
     std::map<route_id, std::weak_ptr<core::route>> routes_;
@@ -103,6 +116,7 @@ struct video_channel::impl final
     impl(int                                       index,
          const core::video_format_desc&            format_desc,
          std::unique_ptr<image_mixer>              image_mixer,
+         int                                       pipeline_depth,
          std::function<void(core::monitor::state)> tick)
         : index_(index)
         , format_desc_(format_desc)
@@ -110,8 +124,14 @@ struct video_channel::impl final
         , image_mixer_(std::move(image_mixer))
         , mixer_(index, graph_, image_mixer_)
         , stage_(index, graph_)
+        , pipeline_depth_(std::max(1, std::min(pipeline_depth, 3)))
         , tick_(std::move(tick))
     {
+        if (pipeline_depth_ > 1) {
+            mix_executor_     = std::make_unique<executor>(L"channel-mix-" + std::to_wstring(index_));
+            consume_executor_ = std::make_unique<executor>(L"channel-consume-" + std::to_wstring(index_));
+        }
+
         graph_->set_color("produce-time", caspar::diagnostics::color(0.0f, 1.0f, 0.0f));
         graph_->set_color("mix-time", caspar::diagnostics::color(1.0f, 0.0f, 0.9f, 0.8f));
         graph_->set_color("consume-time", caspar::diagnostics::color(1.0f, 0.4f, 0.0f, 0.8f));
@@ -120,7 +140,7 @@ struct video_channel::impl final
         graph_->set_text(print());
         caspar::diagnostics::register_graph(graph_);
 
-        CASPAR_LOG(info) << print() << " Successfully Initialized.";
+        CASPAR_LOG(info) << print() << " Successfully Initialized (pipeline depth " << pipeline_depth_ << ").";
 
         thread_ = std::thread([=] {
 #ifdef WIN32
@@ -163,28 +183,31 @@ struct video_channel::impl final
                     auto          stage_frames = stage_(format_desc, nb_samples, background_routes, routesCb);
                     graph_->set_value("produce-time", produce_timer.elapsed() * format_desc.fps * 0.5);
 
-                    // Mix
-                    caspar::timer mix_timer;
-                    auto          mixed_frame = mixer_(stage_frames, format_desc, nb_samples);
-                    graph_->set_value("mix-time", mix_timer.elapsed() * format_desc.fps * 0.5);
+                    auto stage_state = stage_.state();
 
-                    // Consume
-                    caspar::timer consume_timer;
-                    output_(std::move(mixed_frame), format_desc);
-                    graph_->set_value("consume-time", consume_timer.elapsed() * format_desc.fps * 0.5);
+                    if (!mix_executor_) {
+                        auto mixed_frame = mix(std::move(stage_frames), format_desc, nb_samples);
+                        consume(
+                            std::move(mixed_frame), format_desc, std::move(stage_state), mixer_.state(), frame_timer);
+                    } else {
+                        // Mix and consume of previous frames overlap with producing the next one.
+                        pipeline_.push_back(schedule(
+                            std::move(stage_frames), format_desc, nb_samples, std::move(stage_state), frame_timer));
 
-                    graph_->set_value("frame-time", frame_timer.elapsed() * format_desc.fps * 0.5);
+                        while (pipeline_.size() >= static_cast<std::size_t>(pipeline_depth_)) {
+                            wait_pipeline_front();
+                        }
+                    }
 
-                    monitor::state state = {};
-                    state["stage"]       = stage_.state();
-                    state["mixer"]       = mixer_.state();
-                    state["output"]      = output_.state();
-                    state["framerate"]   = {format_desc_.framerate.numerator(), format_desc_.framerate.denominator()};
-                    state_               = state;
+                    graph_->set_value("frame-time", frame_timer.elapsed() * format_desc.fps * 0.5);
+                } catch (...) {
+                    CASPAR_LOG_CURRENT_EXCEPTION();
+                }
+            }
 
-                    caspar::timer osc_timer;
-                    tick_(state_);
-                    graph_->set_value("osc-time", osc_timer.elapsed() * format_desc.fps * 0.5);
+            while (!pipeline_.empty()) {
+                try {
+                    wait_pipeline_front();
                 } catch (...) {
                     CASPAR_LOG_CURRENT_EXCEPTION();
                 }
@@ -192,6 +215,74 @@ struct video_channel::impl final
         });
     }
 
+    const_frame mix(std::vector<draw_frame> stage_frames, const core::video_format_desc& format_desc, int nb_samples)
+    {
+        auto renditions = output_.requested_renditions();
+        auto read_back  = output_.needs_image_data();
+
+        caspar::timer mix_timer;
+        auto          mixed_frame = mixer_(std::move(stage_frames), format_desc, nb_samples, renditions, read_back);
+        graph_->set_value("mix-time", mix_timer.elapsed() * format_desc.fps * 0.5);
+        return mixed_frame;
+    }
+
+    void consume(const_frame                    mixed_frame,
+                 const core::video_format_desc& format_desc,
+                 monitor::state                 stage_state,
+                 monitor::state                 mixer_state,
+                 const caspar::timer&           frame_timer)
+    {
+        caspar::timer consume_timer;
+        output_(std::move(mixed_frame), format_desc);
+        graph_->set_value("consume-time", consume_timer.elapsed() * format_desc.fps * 0.5);
+
+        fps_frames_ += 1;
+        if (fps_timer_.elapsed() >= 1.0) {
+            fps_        = fps_frames_ / fps_timer_.elapsed();
+            fps_frames_ = 0;
+            fps_timer_.restart();
+        }
+
+        // Only touched from the consume thread, rebuilding it and copying into state_ reuses their storage.
+        auto& state = next_state_;
+        state.clear();
+        state["stage"]               = stage_state;
+        state["mixer"]               = mixer_state;
+        state["output"]              = output_.state();
+        state["framerate"]           = {format_desc.framerate.numerator(), format_desc.framerate.denominator()};
+        state["fps"]                 = fps_;
+        state["offline"]             = output_.offline();
+        state["pipeline"]["depth"]   = pipeline_depth_;
+        state["pipeline"]["latency"] = frame_timer.elapsed();
+        state_                       = state;
+
+        caspar::timer osc_timer;
+        tick_(state_);
+        graph_->set_value("osc-time", osc_timer.elapsed() * format_desc.fps * 0.5);
+    }
+
+    std::future<std::future<void>> schedule(std::vector<draw_frame>        stage_frames,
+                                            const core::video_format_desc& format_desc,
+                                            int                            nb_samples,
+                                            monitor::state                 stage_state,
+                                            const caspar::timer&           frame_timer)
+    {
+        return mix_executor_->begin_invoke([=, stage_frames = std::move(stage_frames)]() mutable {
+            auto mixed_frame = mix(std::move(stage_frames), format_desc, nb_samples);
+            auto mixer_state = mixer_.state();
+            return consume_executor_->begin_invoke([=, mixed_frame = std::move(mixed_frame)]() mutable {
+                consume(std::move(mixed_frame), format_desc, stage_state, mixer_state, frame_timer);
+            });
+        });
+    }
+
+    void wait_pipeline_front()
+    {
+        auto mixed = std::move(pipeline_.front());
+        pipeline_.pop_front();
+        mixed.get().get();
+    }
+
     ~impl()
     {
         CASPAR_LOG(info) << print() << " Uninitializing.";
@@ -242,6 +333,17 @@ struct video_channel::impl final
         graph_->set_text(print());
     }
 
+    bool offline() const { return output_.offline(); }
+
+    void offline(bool offline)
+    {
+        if (offline != output_.offline()) {
+            output_.offline(offline);
+            stage_.offline(offline);
+            CASPAR_LOG(info) << print() << (offline ? L" Rendering offline." : L" Rendering in real time.");
+        }
+    }
+
     std::wstring print() const
     {
         return L"video_channel[" + std::to_wstring(index_) + L"|" + video_format_desc().name + L"]";
@@ -253,8 +355,9 @@ struct video_channel::impl final
 video_channel::video_channel(int                                       index,
                              const core::video_format_desc&            format_desc,
                              std::unique_ptr<image_mixer>              image_mixer,
+                             int                                       pipeline_depth,
                              std::function<void(core::monitor::state)> tick)
-    : impl_(new impl(index, format_desc, std::move(image_mixer), std::move(tick)))
+    : impl_(new impl(index, format_desc, std::move(image_mixer), pipeline_depth, std::move(tick)))
 {
 }
 video_channel::~video_channel() {}
@@ -270,6 +373,8 @@ void                           core::video_channel::video_format_desc(const core
 {
     impl_->video_format_desc(format_desc);
 }
+bool                 video_channel::offline() const { return impl_->offline(); }
+void                 video_channel::offline(bool offline) { impl_->offline(offline); }
 int                  video_channel::index() const { return impl_->index(); }
 core::monitor::state video_channel::state() const { return impl_->state_; }
 
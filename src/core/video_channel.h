@@ -72,6 +72,7 @@ class video_channel final
     explicit video_channel(int                                       index,
                            const video_format_desc&                  format_desc,
                            std::unique_ptr<image_mixer>              image_mixer,
+                           int                                       pipeline_depth,
                            std::function<void(core::monitor::state)> on_tick);
     ~video_channel();
 
@@ -87,6 +88,12 @@ class video_channel final
     core::video_format_desc video_format_desc() const;
     void                    video_format_desc(const core::video_format_desc& format_desc);
 
+    // Offline channels aren't paced by the wall clock and render as fast as their consumers accept frames, e.g. to
+    // render to file. Only producers that support it, see frame_producer::offline, wait rather than drop or repeat
+    // frames. Producers driven by the wall clock, such as HTML templates and live inputs, keep running in real time.
+    bool offline() const;
+    void offline(bool offline);
+
     spl::shared_ptr<core::frame_factory> frame_factory();
 
     int index() const;
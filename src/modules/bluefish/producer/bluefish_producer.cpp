@@ -515,7 +515,7 @@ struct bluefish_producer
                 }
 
                 // pass to caspar
-                auto frame = core::draw_frame(make_frame(this, *frame_factory_, src_video, src_audio));
+                auto frame = make_frame(this, *frame_factory_, src_video, src_audio);
                 if (!frame_buffer_.try_push(frame)) {
                     core::draw_frame dummy;
                     frame_buffer_.try_pop(dummy);
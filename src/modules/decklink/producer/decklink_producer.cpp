@@ -612,7 +612,7 @@ class decklink_producer : public IDeckLinkInputCallback
                 graph_->set_value("in-sync", in_sync * 2.0 + 0.5);
                 graph_->set_value("out-sync", out_sync * 2.0 + 0.5);
 
-                auto frame = core::draw_frame(make_frame(this, *frame_factory_, av_video, av_audio));
+                auto frame = make_frame(this, *frame_factory_, av_video, av_audio);
                 if (!frame_buffer_.try_push(frame)) {
                     core::draw_frame dummy;
                     frame_buffer_.try_pop(dummy);
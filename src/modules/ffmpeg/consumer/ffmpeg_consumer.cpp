@@ -29,6 +29,7 @@
 #include <common/executor.h>
 #include <common/future.h>
 #include <common/memory.h>
+#include <common/param.h>
 #include <common/scope_exit.h>
 #include <common/timer.h>
 
@@ -58,6 +59,7 @@ extern "C" {
 #include <libavfilter/buffersrc.h>
 #include <libavformat/avformat.h>
 #include <libavutil/opt.h>
+#include <libavutil/pixdesc.h>
 #include <libavutil/pixfmt.h>
 #include <libavutil/samplefmt.h>
 #include <libswscale/swscale.h>
@@ -68,18 +70,40 @@ extern "C" {
 
 #include <tbb/concurrent_queue.h>
 #include <tbb/parallel_for.h>
-#include <tbb/parallel_invoke.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 namespace caspar { namespace ffmpeg {
 
 // TODO multiple output streams
-// TODO multiple output files
-// TODO run video filter, video encoder, audio filter, audio encoder in separate threads.
 // TODO realtime with smaller buffer?
 
+// Whether the encoder only accepts formats of 10 bits or more without alpha, in which case the mixer's 10-bit 4:2:2
+// conversion can be encoded without losing anything compared to converting BGRA here.
+static bool prefers_yuv422p10(const AVCodec* codec)
+{
+    if (!codec->pix_fmts || codec->pix_fmts[0] == AV_PIX_FMT_NONE) {
+        return false;
+    }
+
+    for (auto fmt = codec->pix_fmts; *fmt != AV_PIX_FMT_NONE; ++fmt) {
+        const auto desc = av_pix_fmt_desc_get(*fmt);
+        if (!desc || (desc->flags & AV_PIX_FMT_FLAG_ALPHA) || desc->comp[0].depth < 10) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 struct Stream
 {
     std::shared_ptr<AVFilterGraph> graph  = nullptr;
@@ -87,18 +111,25 @@ struct Stream
     AVFilterContext*               source = nullptr;
 
     std::shared_ptr<AVCodecContext> enc = nullptr;
-    AVStream*                       st  = nullptr;
 
     tbb::concurrent_bounded_queue<std::shared_ptr<SwsContext>> sws_;
+    std::shared_ptr<SwsContext>                                scale_sws_;
+
+    AVPixelFormat input_format = AV_PIX_FMT_YUVA422P;
+
+    // Encodes the rendition converted by the mixer rather than the channel.
+    boost::optional<core::output_rendition> rendition;
 
     int64_t pts = 0;
 
-    Stream(AVFormatContext*                    oc,
-           std::string                         suffix,
+    Stream(std::string                         suffix,
            AVCodecID                           codec_id,
            const core::video_format_desc&      format_desc,
            bool                                realtime,
-           std::map<std::string, std::string>& options)
+           bool                                global_header,
+           std::map<std::string, std::string>& options,
+           boost::optional<core::output_rendition> rendition_ = boost::none)
+        : rendition(std::move(rendition_))
     {
         std::map<std::string, std::string> stream_options;
 
@@ -176,11 +207,20 @@ struct Stream
             }
 
             if (codec->type == AVMEDIA_TYPE_VIDEO) {
+                if (rendition) {
+                    input_format = AV_PIX_FMT_NV12;
+                } else if (prefers_yuv422p10(codec)) {
+                    input_format = AV_PIX_FMT_YUV422P10;
+                }
+
+                const auto width  = rendition ? rendition->width : format_desc.width;
+                const auto height = rendition ? rendition->height : format_desc.height;
+
                 const auto sar = boost::rational<int>(format_desc.square_width, format_desc.square_height) /
-                                 boost::rational<int>(format_desc.width, format_desc.height);
+                                 boost::rational<int>(width, height);
 
                 auto args = (boost::format("video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:sar=%d/%d:frame_rate=%d/%d") %
-                             format_desc.width % format_desc.height % AV_PIX_FMT_YUVA422P % format_desc.duration %
+                             width % height % input_format % format_desc.duration %
                              format_desc.time_scale % sar.numerator() % sar.denominator() %
                              format_desc.framerate.numerator() % format_desc.framerate.denominator())
                                 .str();
@@ -257,11 +297,6 @@ struct Stream
 
         FF(avfilter_graph_config(graph.get(), nullptr));
 
-        st = avformat_new_stream(oc, nullptr);
-        if (!st) {
-            FF_RET(AVERROR(ENOMEM), "avformat_new_stream");
-        }
-
         enc = std::shared_ptr<AVCodecContext>(avcodec_alloc_context3(codec),
                                               [](AVCodecContext* ptr) { avcodec_free_context(&ptr); });
 
@@ -270,22 +305,18 @@ struct Stream
         }
 
         if (codec->type == AVMEDIA_TYPE_VIDEO) {
-            st->time_base = av_inv_q(av_buffersink_get_frame_rate(sink));
-
             enc->width               = av_buffersink_get_w(sink);
             enc->height              = av_buffersink_get_h(sink);
             enc->framerate           = av_buffersink_get_frame_rate(sink);
             enc->sample_aspect_ratio = av_buffersink_get_sample_aspect_ratio(sink);
-            enc->time_base           = st->time_base;
+            enc->time_base           = av_inv_q(av_buffersink_get_frame_rate(sink));
             enc->pix_fmt             = static_cast<AVPixelFormat>(av_buffersink_get_format(sink));
         } else if (codec->type == AVMEDIA_TYPE_AUDIO) {
-            st->time_base = {1, av_buffersink_get_sample_rate(sink)};
-
             enc->sample_fmt     = static_cast<AVSampleFormat>(av_buffersink_get_format(sink));
             enc->sample_rate    = av_buffersink_get_sample_rate(sink);
             enc->channels       = av_buffersink_get_channels(sink);
             enc->channel_layout = av_buffersink_get_channel_layout(sink);
-            enc->time_base      = st->time_base;
+            enc->time_base      = {1, av_buffersink_get_sample_rate(sink)};
 
             if (!enc->channels) {
                 enc->channels = av_get_channel_layout_nb_channels(enc->channel_layout);
@@ -300,22 +331,20 @@ struct Stream
             enc->thread_type = FF_THREAD_SLICE;
         }
 
+        if (global_header) {
+            enc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+        }
+
         auto dict = to_dict(std::move(stream_options));
         CASPAR_SCOPE_EXIT { av_dict_free(&dict); };
         FF(avcodec_open2(enc.get(), codec, &dict));
         for (auto& p : to_map(&dict)) {
-            options[p.first] = p.second + suffix;
+            options[p.first + suffix] = p.second;
         }
 
-        FF(avcodec_parameters_from_context(st->codecpar, enc.get()));
-
         if (codec->type == AVMEDIA_TYPE_AUDIO && !(codec->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE)) {
             av_buffersink_set_frame_size(sink, enc->frame_size);
         }
-
-        if (oc->oformat->flags & AVFMT_GLOBALHEADER) {
-            enc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
-        }
     }
 
     std::shared_ptr<SwsContext> get_sws(int width, int height)
@@ -326,9 +355,17 @@ struct Stream
             return sws;
         }
 
-        sws.reset(sws_getContext(
-                      width, height, AV_PIX_FMT_BGRA, width, height, AV_PIX_FMT_YUVA422P, 0, nullptr, nullptr, nullptr),
-                  [](SwsContext* ptr) { sws_freeContext(ptr); });
+        sws = make_sws(width, height, width, height, 0);
+
+        return std::shared_ptr<SwsContext>(sws.get(), [this, sws](SwsContext*) { sws_.push(sws); });
+    }
+
+    std::shared_ptr<SwsContext> make_sws(int width, int height, int dst_width, int dst_height, int flags)
+    {
+        std::shared_ptr<SwsContext> sws(
+            sws_getContext(
+                width, height, AV_PIX_FMT_BGRA, dst_width, dst_height, input_format, flags, nullptr, nullptr, nullptr),
+            [](SwsContext* ptr) { sws_freeContext(ptr); });
 
         if (!sws) {
             CASPAR_THROW_EXCEPTION(caspar_exception());
@@ -353,26 +390,110 @@ struct Stream
 
         sws_setColorspaceDetails(sws.get(), inv_table, in_full, table, out_full, brigthness, contrast, saturation);
 
-        return std::shared_ptr<SwsContext>(sws.get(), [this, sws](SwsContext*) { sws_.push(sws); });
+        return sws;
     }
 
-    void send(core::const_frame&                             in_frame,
-              const core::video_format_desc&                 format_desc,
-              std::function<void(std::shared_ptr<AVPacket>)> cb)
+    // Wraps the mixer's conversion to input_format without copying, the frame is kept alive by the AVFrame.
+    std::shared_ptr<AVFrame> make_converted_frame(const core::const_frame&         in_frame,
+                                                  const array<const std::uint8_t>& image,
+                                                  const core::video_format_desc&   format_desc)
     {
-        std::shared_ptr<AVFrame>  frame;
-        std::shared_ptr<AVPacket> pkt;
+        const auto width  = rendition ? rendition->width : format_desc.width;
+        const auto height = rendition ? rendition->height : format_desc.height;
+        const auto hd     = format_desc.height > 700;
+        const auto sar    = boost::rational<int>(format_desc.square_width, format_desc.square_height) /
+                            boost::rational<int>(width, height);
+
+        auto frame                 = alloc_frame();
+        frame->sample_aspect_ratio = {sar.numerator(), sar.denominator()};
+        frame->width               = width;
+        frame->height              = height;
+        frame->format              = input_format;
+        frame->colorspace          = hd ? AVCOL_SPC_BT709 : AVCOL_SPC_SMPTE170M;
+        frame->color_primaries     = hd ? AVCOL_PRI_BT709 : AVCOL_PRI_SMPTE170M;
+        frame->color_range         = AVCOL_RANGE_MPEG;
+        frame->color_trc           = hd ? AVCOL_TRC_BT709 : AVCOL_TRC_SMPTE170M;
+
+        auto data   = const_cast<std::uint8_t*>(image.data());
+        auto opaque = new core::const_frame(in_frame);
+
+        frame->buf[0] = av_buffer_create(
+            data,
+            static_cast<int>(image.size()),
+            [](void* opaque, std::uint8_t*) { delete static_cast<core::const_frame*>(opaque); },
+            opaque,
+            AV_BUFFER_FLAG_READONLY);
+
+        if (!frame->buf[0]) {
+            delete opaque;
+            FF_RET(AVERROR(ENOMEM), "av_buffer_create");
+        }
+
+        if (input_format == AV_PIX_FMT_NV12) {
+            frame->data[0]     = data;
+            frame->linesize[0] = frame->width;
+            frame->data[1]     = frame->data[0] + frame->linesize[0] * frame->height;
+            frame->linesize[1] = frame->width;
+        } else {
+            frame->data[0]     = data;
+            frame->linesize[0] = frame->width * 2;
+            frame->data[1]     = frame->data[0] + frame->linesize[0] * frame->height;
+            frame->linesize[1] = frame->width;
+            frame->data[2]     = frame->data[1] + frame->linesize[1] * frame->height;
+            frame->linesize[2] = frame->width;
+        }
+
+        return frame;
+    }
+
+    // Returns the frame to encode, nullptr at the end of the stream.
+    std::shared_ptr<AVFrame> convert(const core::const_frame& in_frame, const core::video_format_desc& format_desc)
+    {
+        std::shared_ptr<AVFrame> frame;
 
         if (in_frame) {
             if (enc->codec_type == AVMEDIA_TYPE_VIDEO) {
-                frame = make_av_video_frame(in_frame, format_desc);
+                const auto& converted = rendition ? in_frame.image_data(*rendition)
+                                                  : in_frame.image_data(core::output_pixel_format::yuv422p10);
+
+                if ((rendition || input_format == AV_PIX_FMT_YUV422P10) && converted) {
+                    frame = make_converted_frame(in_frame, converted, format_desc);
+                } else if (rendition) {
+                    // The mixer doesn't scale, e.g. the CPU mixer.
+                    frame = make_av_video_frame(in_frame, format_desc);
+
+                    auto frame2                 = alloc_frame();
+                    frame2->sample_aspect_ratio = frame->sample_aspect_ratio;
+                    frame2->width               = rendition->width;
+                    frame2->height              = rendition->height;
+                    frame2->format              = input_format;
+                    frame2->colorspace          = AVCOL_SPC_BT709;
+                    frame2->color_primaries     = AVCOL_PRI_BT709;
+                    frame2->color_range         = AVCOL_RANGE_MPEG;
+                    frame2->color_trc           = AVCOL_TRC_BT709;
+                    av_frame_get_buffer(frame2.get(), 64);
+
+                    if (!scale_sws_) {
+                        scale_sws_ =
+                            make_sws(frame->width, frame->height, frame2->width, frame2->height, SWS_BILINEAR);
+                    }
+                    sws_scale(scale_sws_.get(),
+                              frame->data,
+                              frame->linesize,
+                              0,
+                              frame->height,
+                              frame2->data,
+                              frame2->linesize);
+
+                    frame = std::move(frame2);
+                } else {
+                    frame = make_av_video_frame(in_frame, format_desc);
 
-                {
                     auto frame2                 = alloc_frame();
                     frame2->sample_aspect_ratio = frame->sample_aspect_ratio;
                     frame2->width               = frame->width;
                     frame2->height              = frame->height;
-                    frame2->format              = AV_PIX_FMT_YUVA422P;
+                    frame2->format              = input_format;
                     frame2->colorspace          = AVCOL_SPC_BT709;
                     frame2->color_primaries     = AVCOL_PRI_BT709;
                     frame2->color_range         = AVCOL_RANGE_MPEG;
@@ -387,10 +508,9 @@ struct Stream
                         src[0]          = frame->data[0] + frame->linesize[0] * (i * h);
 
                         uint8_t* dst[4] = {};
-                        dst[0]          = frame2->data[0] + frame2->linesize[0] * (i * h);
-                        dst[1]          = frame2->data[1] + frame2->linesize[1] * (i * h);
-                        dst[2]          = frame2->data[2] + frame2->linesize[2] * (i * h);
-                        dst[3]          = frame2->data[3] + frame2->linesize[3] * (i * h);
+                        for (int n = 0; n < 4 && frame2->data[n]; ++n) {
+                            dst[n] = frame2->data[n] + frame2->linesize[n] * (i * h);
+                        }
 
                         sws_scale(sws.get(), src, frame->linesize, 0, h, dst, frame2->linesize);
                     });
@@ -412,8 +532,22 @@ struct Stream
             } else {
                 // TODO
             }
-            FF(av_buffersrc_write_frame(source, frame.get()));
+        }
+
+        return frame;
+    }
+
+    // Called in order with the frames returned by convert, possibly on another thread. Packets are in the time base
+    // of the encoder.
+    void encode(const std::shared_ptr<AVFrame>& in_frame, std::function<void(std::shared_ptr<AVPacket>)> cb)
+    {
+        std::shared_ptr<AVFrame>  frame;
+        std::shared_ptr<AVPacket> pkt;
+
+        if (in_frame) {
+            FF(av_buffersrc_write_frame(source, in_frame.get()));
         } else {
+            // pts is no longer touched by convert once it returned the end of the stream.
             FF(av_buffersrc_close(source, pts, 0));
         }
 
@@ -437,291 +571,1231 @@ struct Stream
                 return;
             } else {
                 FF_RET(ret, "avcodec_receive_packet");
-                pkt->stream_index = st->index;
-                av_packet_rescale_ts(pkt.get(), enc->time_base, st->time_base);
                 cb(std::move(pkt));
             }
         }
     }
 };
 
-struct ffmpeg_consumer : public core::frame_consumer
+// Parses "-name value" pairs, the value being empty for flags.
+static std::map<std::string, std::string> parse_options(const std::string& args)
 {
-    core::monitor::state    state_;
-    mutable std::mutex      state_mutex_;
-    int                     channel_index_ = -1;
-    core::video_format_desc format_desc_;
-    bool                    realtime_ = false;
+    std::map<std::string, std::string> options;
 
-    spl::shared_ptr<diagnostics::graph> graph_;
+    static boost::regex opt_exp("-(?<NAME>[^-\\s]+)(\\s+(?<VALUE>[^\\s]+))?");
+    for (auto it = boost::sregex_iterator(args.begin(), args.end(), opt_exp); it != boost::sregex_iterator(); ++it) {
+        options[(*it)["NAME"].str().c_str()] = (*it)["VALUE"].matched ? (*it)["VALUE"].str().c_str() : "";
+    }
 
-    std::string path_;
-    std::string args_;
+    return options;
+}
 
-    std::exception_ptr exception_;
-    std::mutex         exception_mutex_;
+// Processes the items pushed to it in order on a thread of its own. The thread ends after processing an empty item,
+// which also marks the end of the stream for the next stage.
+template <typename T>
+class pipeline_stage
+{
+    tbb::concurrent_bounded_queue<T> queue_;
+    std::thread                      thread_;
+    bool                             closed_ = false;
 
-    tbb::concurrent_bounded_queue<core::const_frame> frame_buffer_;
-    std::thread                                      frame_thread_;
+    std::mutex         exception_mutex_;
+    std::exception_ptr exception_;
 
   public:
-    ffmpeg_consumer(std::string path, std::string args, bool realtime)
-        : channel_index_([&] {
-            boost::crc_16_type result;
-            result.process_bytes(path.data(), path.length());
-            return result.checksum();
-        }())
-        , realtime_(realtime)
-        , path_(std::move(path))
-        , args_(std::move(args))
+    template <typename Func>
+    pipeline_stage(int capacity, Func func)
     {
-        state_["file/path"] = u8(path_);
+        queue_.set_capacity(capacity);
+        thread_ = std::thread([this, func]() mutable {
+            T    item;
+            bool last = false;
+            try {
+                while (!last) {
+                    queue_.pop(item);
+                    last = !item;
+                    func(item);
+                }
+            } catch (...) {
+                {
+                    std::lock_guard<std::mutex> lock(exception_mutex_);
+                    exception_ = std::current_exception();
+                }
+                // Keeps taking items so that earlier stages never block on a failed one.
+                while (!last) {
+                    queue_.pop(item);
+                    last = !item;
+                }
+            }
+        });
+    }
 
-        frame_buffer_.set_capacity(realtime_ ? 1 : 64);
+    pipeline_stage(const pipeline_stage&) = delete;
+    pipeline_stage& operator=(const pipeline_stage&) = delete;
 
-        diagnostics::register_graph(graph_);
-        graph_->set_color("frame-time", diagnostics::color(0.1f, 1.0f, 0.1f));
-        graph_->set_color("dropped-frame", diagnostics::color(0.3f, 0.6f, 0.3f));
-        graph_->set_color("input", diagnostics::color(0.7f, 0.4f, 0.4f));
+    ~pipeline_stage()
+    {
+        if (thread_.joinable()) {
+            if (!closed_) {
+                queue_.push(T{});
+            }
+            thread_.join();
+        }
     }
 
-    ~ffmpeg_consumer()
+    void push(T item)
     {
-        if (frame_thread_.joinable()) {
-            frame_buffer_.push(core::const_frame{});
-            frame_thread_.join();
-        }
+        closed_ = !item;
+        queue_.push(std::move(item));
     }
 
-    // frame consumer
+    // Rethrows the failure of the stage, if any.
+    void check()
+    {
+        std::lock_guard<std::mutex> lock(exception_mutex_);
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+    }
 
-    void initialize(const core::video_format_desc& format_desc, int channel_index) override
+    // Waits for the stage to process the end of the stream.
+    void join()
     {
-        if (frame_thread_.joinable()) {
-            CASPAR_THROW_EXCEPTION(invalid_operation() << msg_info("Cannot reinitialize ffmpeg-consumer."));
+        if (!closed_) {
+            push(T{});
         }
+        thread_.join();
+        check();
+    }
+};
 
-        format_desc_   = format_desc;
-        channel_index_ = channel_index;
+// Writes the packets of an encoder_session to a file or a network stream on a thread of its own. Realtime outputs never
+// hold up the encoders: a full queue drops packets until the next video keyframe and a failed output reconnects.
+class muxer
+{
+    const std::wstring                           name_;
+    const std::string                            path_;
+    AVOutputFormat* const                        oformat_;
+    const std::map<std::string, std::string>     options_;
+    std::vector<std::shared_ptr<AVCodecContext>> encoders_; // By packet stream index.
+    const int                                    video_index_;
+    const bool                                   realtime_;
 
-        graph_->set_text(print());
+    spl::shared_ptr<diagnostics::graph> graph_;
 
-        frame_thread_ = std::thread([=] {
-            try {
-                std::map<std::string, std::string> options;
-                {
-                    static boost::regex opt_exp("-(?<NAME>[^-\\s]+)(\\s+(?<VALUE>[^\\s]+))?");
-                    for (auto it = boost::sregex_iterator(args_.begin(), args_.end(), opt_exp);
-                         it != boost::sregex_iterator();
-                         ++it) {
-                        options[(*it)["NAME"].str().c_str()] =
-                            (*it)["VALUE"].matched ? (*it)["VALUE"].str().c_str() : "";
-                    }
-                }
+    tbb::concurrent_bounded_queue<std::shared_ptr<AVPacket>> packet_buffer_;
+    std::thread                                              thread_;
+    bool                                                     resync_ = false;
+    bool                                                     closed_ = false;
+    std::atomic<bool>                                        abort_request_{false};
+
+    std::mutex         exception_mutex_;
+    std::exception_ptr exception_;
+
+  public:
+    muxer(std::wstring                                 name,
+          std::string                                  path,
+          AVOutputFormat*                              oformat,
+          std::map<std::string, std::string>           options,
+          std::vector<std::shared_ptr<AVCodecContext>> encoders,
+          int                                          video_index,
+          bool                                         realtime,
+          spl::shared_ptr<diagnostics::graph>          graph)
+        : name_(std::move(name))
+        , path_(std::move(path))
+        , oformat_(oformat)
+        , options_(std::move(options))
+        , encoders_(std::move(encoders))
+        , video_index_(video_index)
+        , realtime_(realtime)
+        , graph_(std::move(graph))
+    {
+        packet_buffer_.set_capacity(realtime_ ? 8 : 128);
+    }
 
-                boost::filesystem::path full_path = path_;
+    muxer(const muxer&) = delete;
+    muxer& operator=(const muxer&) = delete;
 
-                static boost::regex prot_exp("^.+:.*");
-                if (!boost::regex_match(path_, prot_exp)) {
-                    if (!full_path.is_complete()) {
-                        full_path = u8(env::media_folder()) + path_;
-                    }
+    ~muxer() { close(); }
 
-                    // TODO -y?
-                    if (boost::filesystem::exists(full_path)) {
-                        boost::filesystem::remove(full_path);
+    void start()
+    {
+        thread_ = std::thread([this] {
+            while (true) {
+                try {
+                    run();
+                    return;
+                } catch (...) {
+                    if (abort_request_) {
+                        return;
                     }
 
-                    boost::filesystem::create_directories(full_path.parent_path());
-                }
+                    CASPAR_LOG_CURRENT_EXCEPTION();
 
-                AVFormatContext* oc = nullptr;
+                    if (realtime_ && !closed_) {
+                        CASPAR_LOG(warning) << name_ << L" Reconnecting.";
+                        if (wait(std::chrono::seconds(1))) {
+                            continue;
+                        }
+                        return;
+                    }
 
-                {
-                    std::string format;
                     {
-                        const auto format_it = options.find("format");
-                        if (format_it != options.end()) {
-                            format = std::move(format_it->second);
-                            options.erase(format_it);
-                        }
+                        std::lock_guard<std::mutex> lock(exception_mutex_);
+                        exception_ = std::current_exception();
                     }
 
-                    FF(avformat_alloc_output_context2(
-                        &oc, nullptr, !format.empty() ? format.c_str() : nullptr, path_.c_str()));
+                    // Keeps taking packets so that the encoders never block on a failed output.
+                    while (!closed_ && wait(std::chrono::seconds(1))) {
+                    }
+                    return;
                 }
+            }
+        });
+    }
 
-                CASPAR_SCOPE_EXIT { avformat_free_context(oc); };
+    // Called by one encoder at a time with packets of the encoder time base.
+    void push(const std::shared_ptr<AVPacket>& pkt)
+    {
+        if (resync_) {
+            if (video_index_ >= 0 && (pkt->stream_index != video_index_ || !(pkt->flags & AV_PKT_FLAG_KEY))) {
+                return;
+            }
+            resync_ = false;
+        }
 
-                boost::optional<Stream> video_stream;
-                if (oc->oformat->video_codec != AV_CODEC_ID_NONE) {
-                    if (oc->oformat->video_codec == AV_CODEC_ID_H264 && options.find("preset:v") == options.end()) {
-                        options["preset:v"] = "veryfast";
-                    }
-                    video_stream.emplace(oc, ":v", oc->oformat->video_codec, format_desc, realtime_, options);
+        if (!realtime_) {
+            packet_buffer_.push(pkt);
+        } else if (!packet_buffer_.try_push(pkt)) {
+            graph_->set_tag(diagnostics::tag_severity::WARNING, "dropped-packet");
+            resync_ = true;
+        }
+        graph_->set_value("output", static_cast<double>(packet_buffer_.size() + 0.001) / packet_buffer_.capacity());
+    }
 
-                    {
-                        std::lock_guard<std::mutex> lock(state_mutex_);
-                        state_["file/fps"] = av_q2d(av_buffersink_get_frame_rate(video_stream->sink));
-                    }
+    // Writes the remaining packets, a realtime output only finishes the packet it is writing.
+    void close()
+    {
+        if (thread_.joinable()) {
+            if (realtime_) {
+                // A stalled output doesn't drain the queue, the packets that don't fit are dropped instead.
+                abort_request_ = true;
+                std::shared_ptr<AVPacket> pkt;
+                while (!packet_buffer_.try_push(nullptr)) {
+                    packet_buffer_.try_pop(pkt);
                 }
+            } else {
+                packet_buffer_.push(nullptr);
+            }
+            thread_.join();
+        }
+    }
 
-                boost::optional<Stream> audio_stream;
-                if (oc->oformat->audio_codec != AV_CODEC_ID_NONE) {
-                    audio_stream.emplace(oc, ":a", oc->oformat->audio_codec, format_desc, realtime_, options);
-                }
+    // Rethrows the failure of the output, if any.
+    void check()
+    {
+        std::lock_guard<std::mutex> lock(exception_mutex_);
+        if (exception_) {
+            std::rethrow_exception(exception_);
+        }
+    }
 
-                if (!(oc->oformat->flags & AVFMT_NOFILE)) {
-                    // TODO (fix) interrupt_cb
-                    auto dict = to_dict(std::move(options));
-                    CASPAR_SCOPE_EXIT { av_dict_free(&dict); };
-                    FF(avio_open2(&oc->pb, full_path.string().c_str(), AVIO_FLAG_WRITE, nullptr, &dict));
-                    options = to_map(&dict);
-                }
+  private:
+    static int interrupt_cb(void* ctx) { return reinterpret_cast<muxer*>(ctx)->abort_request_ ? 1 : 0; }
 
-                {
-                    auto dict = to_dict(std::move(options));
-                    CASPAR_SCOPE_EXIT { av_dict_free(&dict); };
-                    FF(avformat_write_header(oc, &dict));
-                    options = to_map(&dict);
-                }
+    // Discards packets for the given duration, returns false if the output was closed meanwhile.
+    bool wait(std::chrono::milliseconds duration)
+    {
+        const auto end = std::chrono::steady_clock::now() + duration;
 
-                {
-                    for (auto& p : options) {
-                        CASPAR_LOG(warning) << print() << " Unused option " << p.first << "=" << p.second;
-                    }
+        std::shared_ptr<AVPacket> pkt;
+        while (std::chrono::steady_clock::now() < end) {
+            while (packet_buffer_.try_pop(pkt)) {
+                if (!pkt) {
+                    closed_ = true;
+                    return false;
                 }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        return true;
+    }
 
-                tbb::concurrent_bounded_queue<std::shared_ptr<AVPacket>> packet_buffer;
-                packet_buffer.set_capacity(realtime_ ? 1 : 128);
-                auto packet_thread = std::thread([&] {
-                    try {
-                        CASPAR_SCOPE_EXIT
-                        {
-                            if (!(oc->oformat->flags & AVFMT_NOFILE)) {
-                                FF(avio_closep(&oc->pb));
-                            }
-                        };
-
-                        std::map<int, int64_t> count;
-
-                        std::shared_ptr<AVPacket> pkt;
-                        while (true) {
-                            packet_buffer.pop(pkt);
-                            if (!pkt) {
-                                break;
-                            }
-                            count[pkt->stream_index] += 1;
-                            FF(av_interleaved_write_frame(oc, pkt.get()));
-                        }
+    void run()
+    {
+        AVFormatContext* oc = nullptr;
+        FF(avformat_alloc_output_context2(&oc, oformat_, nullptr, path_.c_str()));
+        CASPAR_SCOPE_EXIT { avformat_free_context(oc); };
+
+        oc->interrupt_callback.callback = interrupt_cb;
+        oc->interrupt_callback.opaque   = this;
+
+        std::vector<AVStream*> streams;
+        for (auto& enc : encoders_) {
+            auto st = avformat_new_stream(oc, nullptr);
+            if (!st) {
+                FF_RET(AVERROR(ENOMEM), "avformat_new_stream");
+            }
+            st->time_base = enc->time_base;
+            FF(avcodec_parameters_from_context(st->codecpar, enc.get()));
+            streams.push_back(st);
+        }
 
-                        auto video_st = video_stream ? video_stream->st : nullptr;
-                        auto audio_st = audio_stream ? audio_stream->st : nullptr;
+        auto options = options_;
 
-                        if ((!video_st || count[video_st->index]) && (!audio_st || count[audio_st->index])) {
-                            FF(av_write_trailer(oc));
-                        }
+        if (!(oc->oformat->flags & AVFMT_NOFILE)) {
+            auto dict = to_dict(std::move(options));
+            CASPAR_SCOPE_EXIT { av_dict_free(&dict); };
+            FF(avio_open2(&oc->pb, path_.c_str(), AVIO_FLAG_WRITE, &oc->interrupt_callback, &dict));
+            options = to_map(&dict);
+        }
 
-                    } catch (...) {
-                        CASPAR_LOG_CURRENT_EXCEPTION();
-                        // TODO
-                        packet_buffer.abort();
-                    }
-                });
-                CASPAR_SCOPE_EXIT
-                {
-                    if (packet_thread.joinable()) {
-                        // TODO Is nullptr needed?
-                        packet_buffer.push(nullptr);
-                        packet_buffer.abort();
-                        packet_thread.join();
-                    }
-                };
+        CASPAR_SCOPE_EXIT
+        {
+            if (!(oc->oformat->flags & AVFMT_NOFILE)) {
+                avio_closep(&oc->pb);
+            }
+        };
+
+        {
+            auto dict = to_dict(std::move(options));
+            CASPAR_SCOPE_EXIT { av_dict_free(&dict); };
+            FF(avformat_write_header(oc, &dict));
+            options = to_map(&dict);
+        }
 
-                auto packet_cb = [&](std::shared_ptr<AVPacket>&& pkt) { packet_buffer.push(std::move(pkt)); };
+        for (auto& p : options) {
+            CASPAR_LOG(warning) << name_ << " Unused option " << p.first << "=" << p.second;
+        }
 
-                std::int32_t frame_number = 0;
-                while (true) {
-                    {
-                        std::lock_guard<std::mutex> lock(state_mutex_);
-                        state_["file/frame"] = frame_number++;
-                    }
+        // The output starts at the first video keyframe, from where its timestamps start at zero.
+        boost::optional<int64_t> offset;
+        std::vector<int64_t>     count(streams.size());
 
-                    core::const_frame frame;
-                    frame_buffer_.pop(frame);
-                    graph_->set_value("input",
-                                      static_cast<double>(frame_buffer_.size() + 0.001) / frame_buffer_.capacity());
-
-                    caspar::timer frame_timer;
-                    tbb::parallel_invoke(
-                        [&] {
-                            if (video_stream) {
-                                video_stream->send(frame, format_desc, packet_cb);
-                            }
-                        },
-                        [&] {
-                            if (audio_stream) {
-                                audio_stream->send(frame, format_desc, packet_cb);
-                            }
-                        });
-                    graph_->set_value("frame-time", frame_timer.elapsed() * format_desc.fps * 0.5);
-
-                    if (!frame) {
-                        packet_buffer.push(nullptr);
-                        break;
-                    }
+        std::shared_ptr<AVPacket> pkt;
+        while (true) {
+            packet_buffer_.pop(pkt);
+            if (!pkt) {
+                closed_ = true;
+                break;
+            }
+
+            const auto& enc = encoders_.at(pkt->stream_index);
+            const auto  st  = streams.at(pkt->stream_index);
+
+            if (!offset) {
+                if (video_index_ >= 0 && (pkt->stream_index != video_index_ || !(pkt->flags & AV_PKT_FLAG_KEY))) {
+                    continue;
                 }
+                offset = av_rescale_q(pkt->dts, enc->time_base, AVRational{1, AV_TIME_BASE});
+            }
 
-                packet_thread.join();
-            } catch (...) {
-                std::lock_guard<std::mutex> lock(exception_mutex_);
-                exception_ = std::current_exception();
+            const auto start = av_rescale_q(*offset, AVRational{1, AV_TIME_BASE}, enc->time_base);
+            if (pkt->dts != AV_NOPTS_VALUE && pkt->dts < start) {
+                continue;
             }
-        });
-    }
 
-    std::future<bool> send(core::const_frame frame) override
-    {
-        {
-            std::lock_guard<std::mutex> lock(exception_mutex_);
-            if (exception_ != nullptr) {
-                std::rethrow_exception(exception_);
+            auto out = alloc_packet();
+            FF(av_packet_ref(out.get(), pkt.get()));
+            if (out->pts != AV_NOPTS_VALUE) {
+                out->pts -= start;
             }
-        }
+            if (out->dts != AV_NOPTS_VALUE) {
+                out->dts -= start;
+            }
+            av_packet_rescale_ts(out.get(), enc->time_base, st->time_base);
 
-        if (!frame_buffer_.try_push(frame)) {
-            graph_->set_tag(diagnostics::tag_severity::WARNING, "dropped-frame");
+            count[pkt->stream_index] += 1;
+            FF(av_interleaved_write_frame(oc, out.get()));
         }
-        graph_->set_value("input", static_cast<double>(frame_buffer_.size() + 0.001) / frame_buffer_.capacity());
 
-        return make_ready_future(true);
+        if (std::all_of(count.begin(), count.end(), [](int64_t n) { return n > 0; })) {
+            FF(av_write_trailer(oc));
+        }
     }
+};
 
-    std::wstring print() const override { return L"ffmpeg[" + u16(path_) + L"]"; }
+// Converts and encodes the frames of a channel once for all the ffmpeg consumers of the channel with the same encoding
+// options, each of which muxes the packets to an output of its own.
+class encoder_session
+{
+    const std::string       key_;
+    const std::wstring      name_;
+    core::video_format_desc format_desc_;
 
-    std::wstring name() const override { return L"ffmpeg"; }
+    spl::shared_ptr<diagnostics::graph> graph_;
 
-    bool has_synchronization_clock() const override { return false; }
+    boost::optional<Stream>                      video_stream_;
+    boost::optional<Stream>                      audio_stream_;
+    std::vector<std::shared_ptr<AVCodecContext>> encoders_; // By packet stream index.
 
-    int index() const override { return 100000 + channel_index_; }
+    std::mutex                          muxers_mutex_;
+    std::vector<std::shared_ptr<muxer>> muxers_;
+    bool                                stopped_ = false;
 
-    core::monitor::state state() const override
+    std::mutex        last_frame_mutex_;
+    core::const_frame last_frame_;
+
+    tbb::concurrent_bounded_queue<core::const_frame> frame_buffer_;
+    std::thread                                      frame_thread_;
+    std::atomic<std::int32_t>                        frame_number_{0};
+
+    std::exception_ptr exception_;
+    std::mutex         exception_mutex_;
+
+    struct registry
     {
-        std::lock_guard<std::mutex> lock(state_mutex_);
-        return state_;
+        std::mutex                                            mutex;
+        std::map<std::string, std::weak_ptr<encoder_session>> sessions;
+    };
+
+    static registry& get_registry()
+    {
+        static registry instance;
+        return instance;
     }
-};
 
-spl::shared_ptr<core::frame_consumer> create_consumer(const std::vector<std::wstring>&                  params,
-                                                      std::vector<spl::shared_ptr<core::video_channel>> channels)
-{
-    if (params.size() < 2 || (!boost::iequals(params.at(0), L"STREAM") && !boost::iequals(params.at(0), L"FILE")))
-        return core::frame_consumer::empty();
+  public:
+    encoder_session(std::string                         key,
+                    const core::video_format_desc&      format_desc,
+                    bool                                realtime,
+                    AVCodecID                           video_codec,
+                    AVCodecID                           audio_codec,
+                    bool                                global_header,
+                    std::map<std::string, std::string>& options,
+                    int                                 channel_index)
+        : key_(std::move(key))
+        , name_(L"ffmpeg-encoder[" + std::to_wstring(channel_index) + L"]")
+        , format_desc_(format_desc)
+    {
+        if (video_codec != AV_CODEC_ID_NONE) {
+            video_stream_.emplace(":v", video_codec, format_desc, realtime, global_header, options);
+            encoders_.push_back(video_stream_->enc);
+        }
 
-    auto                     path = u8(params.at(1));
+        if (audio_codec != AV_CODEC_ID_NONE) {
+            audio_stream_.emplace(":a", audio_codec, format_desc, realtime, global_header, options);
+            encoders_.push_back(audio_stream_->enc);
+        }
+
+        frame_buffer_.set_capacity(realtime ? 1 : 64);
+
+        graph_->set_text(name_);
+        graph_->set_color("frame-time", diagnostics::color(0.1f, 1.0f, 0.1f));
+        graph_->set_color("video-convert-time", diagnostics::color(0.9f, 0.9f, 0.1f));
+        graph_->set_color("video-encode-time", diagnostics::color(0.1f, 0.7f, 1.0f));
+        graph_->set_color("audio-encode-time", diagnostics::color(1.0f, 0.5f, 0.1f));
+        graph_->set_color("input", diagnostics::color(0.7f, 0.4f, 0.4f));
+        diagnostics::register_graph(graph_);
+
+        frame_thread_ = std::thread([this, realtime] {
+            try {
+                run(realtime);
+            } catch (...) {
+                {
+                    std::lock_guard<std::mutex> lock(exception_mutex_);
+                    exception_ = std::current_exception();
+                }
+
+                // Releases a send that waits for room while offline, the next one rethrows.
+                core::const_frame frame;
+                while (frame_buffer_.try_pop(frame)) {
+                }
+            }
+        });
+    }
+
+    encoder_session(const encoder_session&) = delete;
+    encoder_session& operator=(const encoder_session&) = delete;
+
+    ~encoder_session()
+    {
+        stop();
+
+        for (auto& m : muxers_) {
+            m->close();
+        }
+    }
+
+    // Returns the session of the key, created by make_session if there is none.
+    template <typename Func>
+    static std::shared_ptr<encoder_session> get(const std::string& key, Func&& make_session)
+    {
+        auto& registry = get_registry();
+
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        auto session = registry.sessions[key].lock();
+        if (!session) {
+            session                = make_session();
+            registry.sessions[key] = session;
+        } else {
+            CASPAR_LOG(info) << L"[ffmpeg] Sharing the encoders of " << session->name_;
+        }
+        return session;
+    }
+
+    // Starts feeding the muxer, returns false if the session was stopped meanwhile.
+    bool attach(const std::shared_ptr<muxer>& m)
+    {
+        std::lock_guard<std::mutex> lock(muxers_mutex_);
+        if (stopped_) {
+            return false;
+        }
+        m->start();
+        muxers_.push_back(m);
+        return true;
+    }
+
+    // Stops feeding the muxer and closes it. The last muxer also receives the packets that the encoders flush.
+    void detach(const std::shared_ptr<muxer>& m)
+    {
+        bool last = false;
+        {
+            auto& registry = get_registry();
+
+            std::lock_guard<std::mutex> registry_lock(registry.mutex);
+            std::lock_guard<std::mutex> lock(muxers_mutex_);
+
+            muxers_.erase(std::remove(muxers_.begin(), muxers_.end(), m), muxers_.end());
+            if (muxers_.empty()) {
+                last     = true;
+                stopped_ = true;
+                muxers_.push_back(m);
+
+                auto it = registry.sessions.find(key_);
+                if (it != registry.sessions.end() && it->second.lock().get() == this) {
+                    registry.sessions.erase(it);
+                }
+            }
+        }
+
+        if (last) {
+            stop();
+        }
+        m->close();
+    }
+
+    // Returns false if the frame was dropped. Every consumer of the channel sends the same frame, which is only encoded
+    // once.
+    bool send(const core::const_frame& frame, bool blocking)
+    {
+        {
+            std::lock_guard<std::mutex> lock(exception_mutex_);
+            if (exception_ != nullptr) {
+                std::rethrow_exception(exception_);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(last_frame_mutex_);
+            if (frame == last_frame_) {
+                return true;
+            }
+            last_frame_ = frame;
+        }
+
+        auto result = true;
+        if (blocking) {
+            frame_buffer_.push(frame);
+        } else {
+            result = frame_buffer_.try_push(frame);
+        }
+        graph_->set_value("input", static_cast<double>(frame_buffer_.size() + 0.001) / frame_buffer_.capacity());
+
+        return result;
+    }
+
+    bool requests_yuv422p10() const { return video_stream_ && video_stream_->input_format == AV_PIX_FMT_YUV422P10; }
+
+    boost::optional<double> fps() const
+    {
+        if (!video_stream_) {
+            return boost::none;
+        }
+        return av_q2d(av_buffersink_get_frame_rate(video_stream_->sink));
+    }
+
+    std::int32_t frame_number() const { return frame_number_; }
+
+    const std::vector<std::shared_ptr<AVCodecContext>>& encoders() const { return encoders_; }
+
+    int video_index() const { return video_stream_ ? 0 : -1; }
+
+  private:
+    void stop()
+    {
+        if (frame_thread_.joinable()) {
+            frame_buffer_.push(core::const_frame{});
+            frame_thread_.join();
+        }
+    }
+
+    void run(bool realtime)
+    {
+        auto dispatch = [this](int index) {
+            return [this, index](std::shared_ptr<AVPacket>&& pkt) {
+                pkt->stream_index = index;
+
+                std::lock_guard<std::mutex> lock(muxers_mutex_);
+                for (auto& m : muxers_) {
+                    m->push(pkt);
+                }
+            };
+        };
+        const auto video_cb = dispatch(0);
+        const auto audio_cb = dispatch(video_stream_ ? 1 : 0);
+
+        // Video conversion, video encoding and audio encoding run on threads of their own, so that neither the
+        // conversion of the next frame nor the audio holds up the video encoder.
+        const auto capacity = realtime ? 2 : 8;
+        const auto scale    = format_desc_.fps * 0.5;
+
+        std::unique_ptr<pipeline_stage<std::shared_ptr<AVFrame>>> video_encoder;
+        std::unique_ptr<pipeline_stage<core::const_frame>>        video_converter;
+        std::unique_ptr<pipeline_stage<core::const_frame>>        audio_encoder;
+
+        if (video_stream_) {
+            video_encoder = std::make_unique<pipeline_stage<std::shared_ptr<AVFrame>>>(
+                capacity, [&](const std::shared_ptr<AVFrame>& frame) {
+                    caspar::timer encode_timer;
+                    video_stream_->encode(frame, video_cb);
+                    graph_->set_value("video-encode-time", encode_timer.elapsed() * scale);
+                });
+            video_converter =
+                std::make_unique<pipeline_stage<core::const_frame>>(capacity, [&](const core::const_frame& frame) {
+                    caspar::timer convert_timer;
+                    auto          av_frame = video_stream_->convert(frame, format_desc_);
+                    graph_->set_value("video-convert-time", convert_timer.elapsed() * scale);
+                    video_encoder->push(std::move(av_frame));
+                });
+        }
+
+        if (audio_stream_) {
+            audio_encoder =
+                std::make_unique<pipeline_stage<core::const_frame>>(capacity, [&](const core::const_frame& frame) {
+                    caspar::timer encode_timer;
+                    audio_stream_->encode(audio_stream_->convert(frame, format_desc_), audio_cb);
+                    graph_->set_value("audio-encode-time", encode_timer.elapsed() * scale);
+                });
+        }
+
+        while (true) {
+            core::const_frame frame;
+            frame_buffer_.pop(frame);
+            graph_->set_value("input", static_cast<double>(frame_buffer_.size() + 0.001) / frame_buffer_.capacity());
+
+            caspar::timer frame_timer;
+            for (auto stage : {video_converter.get(), audio_encoder.get()}) {
+                if (stage) {
+                    stage->check();
+                    stage->push(frame);
+                }
+            }
+            if (video_encoder) {
+                video_encoder->check();
+            }
+            graph_->set_value("frame-time", frame_timer.elapsed() * scale);
+
+            if (!frame) {
+                break;
+            }
+            frame_number_++;
+        }
+
+        for (auto stage : {video_converter.get(), audio_encoder.get()}) {
+            if (stage) {
+                stage->join();
+            }
+        }
+        if (video_encoder) {
+            video_encoder->join();
+        }
+    }
+};
+
+struct ffmpeg_consumer : public core::frame_consumer
+{
+    core::monitor::state    state_;
+    mutable std::mutex      state_mutex_;
+    int                     channel_index_ = -1;
+    core::video_format_desc format_desc_;
+    bool                    realtime_ = false;
+
+    spl::shared_ptr<diagnostics::graph> graph_;
+
+    std::string path_;
+    std::string args_;
+
+    std::shared_ptr<encoder_session> session_;
+    std::shared_ptr<muxer>           muxer_;
+
+    std::atomic<bool> offline_{false};
+
+  public:
+    ffmpeg_consumer(std::string path, std::string args, bool realtime)
+        : channel_index_([&] {
+            boost::crc_16_type result;
+            result.process_bytes(path.data(), path.length());
+            return result.checksum();
+        }())
+        , realtime_(realtime)
+        , path_(std::move(path))
+        , args_(std::move(args))
+    {
+        state_["file/path"] = u8(path_);
+
+        diagnostics::register_graph(graph_);
+        graph_->set_color("dropped-frame", diagnostics::color(0.3f, 0.6f, 0.3f));
+        graph_->set_color("dropped-packet", diagnostics::color(0.6f, 0.3f, 0.3f));
+        graph_->set_color("output", diagnostics::color(0.4f, 0.4f, 0.7f));
+    }
+
+    ~ffmpeg_consumer()
+    {
+        if (session_) {
+            session_->detach(muxer_);
+        }
+    }
+
+    // frame consumer
+
+    void initialize(const core::video_format_desc& format_desc, int channel_index) override
+    {
+        if (session_) {
+            CASPAR_THROW_EXCEPTION(invalid_operation() << msg_info("Cannot reinitialize ffmpeg-consumer."));
+        }
+
+        format_desc_   = format_desc;
+        channel_index_ = channel_index;
+
+        graph_->set_text(print());
+
+        auto options = parse_options(args_);
+
+        boost::filesystem::path full_path = path_;
+
+        static boost::regex prot_exp("^.+:.*");
+        if (!boost::regex_match(path_, prot_exp)) {
+            if (!full_path.is_complete()) {
+                full_path = u8(env::media_folder()) + path_;
+            }
+
+            // TODO -y?
+            if (boost::filesystem::exists(full_path)) {
+                boost::filesystem::remove(full_path);
+            }
+
+            boost::filesystem::create_directories(full_path.parent_path());
+        }
+
+        AVOutputFormat* oformat = nullptr;
+        {
+            const auto format_it = options.find("format");
+            if (format_it != options.end()) {
+                oformat = av_guess_format(format_it->second.c_str(), nullptr, nullptr);
+                options.erase(format_it);
+            } else {
+                oformat = av_guess_format(nullptr, path_.c_str(), nullptr);
+            }
+        }
+
+        if (!oformat) {
+            FF_RET(AVERROR(EINVAL), "av_guess_format");
+        }
+
+        if (oformat->video_codec == AV_CODEC_ID_H264 && options.find("preset:v") == options.end()) {
+            options["preset:v"] = "veryfast";
+        }
+
+        // Consumers of the channel that encode with the same options share the encoders, only the options of the
+        // output itself may differ. Realtime outputs are kept apart since they thread and buffer differently.
+        std::map<std::string, std::string> stream_options;
+        for (auto it = options.begin(); it != options.end();) {
+            if (boost::algorithm::ends_with(it->first, ":v") || boost::algorithm::ends_with(it->first, ":a")) {
+                stream_options.insert(*it);
+                it = options.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        const auto global_header = (oformat->flags & AVFMT_GLOBALHEADER) != 0;
+
+        auto key = (boost::format("%d|%s|%d|%d|%d|%d") % channel_index % u8(format_desc.name) % oformat->video_codec %
+                    oformat->audio_codec % global_header % realtime_)
+                       .str();
+        for (auto& p : stream_options) {
+            key += "|" + p.first + "=" + p.second;
+        }
+
+        do {
+            session_ = encoder_session::get(key, [&] {
+                auto session = std::make_shared<encoder_session>(key,
+                                                                 format_desc,
+                                                                 realtime_,
+                                                                 oformat->video_codec,
+                                                                 oformat->audio_codec,
+                                                                 global_header,
+                                                                 stream_options,
+                                                                 channel_index);
+                for (auto& p : stream_options) {
+                    CASPAR_LOG(warning) << print() << " Unused option " << p.first << "=" << p.second;
+                }
+                return session;
+            });
+
+            muxer_ = std::make_shared<muxer>(print(),
+                                             full_path.string(),
+                                             oformat,
+                                             options,
+                                             session_->encoders(),
+                                             session_->video_index(),
+                                             realtime_,
+                                             graph_);
+        } while (!session_->attach(muxer_));
+
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        if (auto fps = session_->fps()) {
+            state_["file/fps"] = *fps;
+        }
+    }
+
+    std::future<bool> send(core::const_frame frame) override
+    {
+        muxer_->check();
+
+        if (!session_->send(frame, offline_)) {
+            graph_->set_tag(diagnostics::tag_severity::WARNING, "dropped-frame");
+        }
+
+        return make_ready_future(true);
+    }
+
+    std::wstring print() const override { return L"ffmpeg[" + u16(path_) + L"]"; }
+
+    std::wstring name() const override { return L"ffmpeg"; }
+
+    bool has_synchronization_clock() const override { return false; }
+
+    int index() const override { return 100000 + channel_index_; }
+
+    void offline(bool offline) override { offline_ = offline; }
+
+    std::vector<core::output_pixel_format> requested_pixel_formats() const override
+    {
+        if (session_ && session_->requests_yuv422p10()) {
+            return {core::output_pixel_format::yuv422p10};
+        }
+        return {};
+    }
+
+    core::monitor::state state() const override
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        auto                        state = state_;
+        if (session_) {
+            state["file/frame"] = session_->frame_number();
+        }
+        return state;
+    }
+};
+
+// A rendition of an adaptive bitrate ladder.
+struct ladder_rung
+{
+    int         width  = 0;
+    int         height = 0;
+    std::string bitrate;
+};
+
+// Parses WIDTHxHEIGHT:BITRATE[,...]. The default ladder holds the common sizes up to the size of the channel. Rungs
+// are ordered from the largest to the smallest.
+static std::vector<ladder_rung> parse_ladder(const std::string& spec, const core::video_format_desc& format_desc)
+{
+    std::vector<ladder_rung> ladder;
+
+    if (spec.empty()) {
+        const std::vector<std::pair<int, std::string>> defaults = {
+            {1080, "5000k"}, {720, "3000k"}, {480, "1400k"}, {360, "800k"}};
+        for (auto& p : defaults) {
+            if (p.first <= format_desc.height) {
+                ladder.push_back({p.first * format_desc.square_width / format_desc.square_height, p.first, p.second});
+            }
+        }
+    } else {
+        static boost::regex rung_exp("(?<WIDTH>\\d+)x(?<HEIGHT>\\d+):(?<BITRATE>\\w+)");
+
+        std::vector<std::string> rungs;
+        boost::split(rungs, spec, boost::is_any_of(","));
+        for (auto& rung : rungs) {
+            boost::smatch what;
+            if (!boost::regex_match(rung, what, rung_exp)) {
+                CASPAR_THROW_EXCEPTION(user_error() << msg_info("Invalid ladder rung " + rung));
+            }
+            ladder.push_back({std::stoi(what["WIDTH"].str()), std::stoi(what["HEIGHT"].str()), what["BITRATE"].str()});
+        }
+    }
+
+    // The mixer converts to NV12, which needs a width divisible by 4 and an even height.
+    for (auto& rung : ladder) {
+        rung.width  = rung.width / 4 * 4;
+        rung.height = rung.height / 2 * 2;
+        if (rung.width <= 0 || rung.height <= 0) {
+            CASPAR_THROW_EXCEPTION(user_error() << msg_info("Invalid ladder rung size"));
+        }
+    }
+
+    if (ladder.empty()) {
+        CASPAR_THROW_EXCEPTION(user_error() << msg_info("Empty ladder"));
+    }
+
+    std::stable_sort(
+        ladder.begin(), ladder.end(), [](const auto& lhs, const auto& rhs) { return lhs.height > rhs.height; });
+
+    return ladder;
+}
+
+// Encodes renditions of the channel, which the mixer scales and converts to NV12 on the GPU, in parallel and writes
+// them with one shared audio rendition as an HLS or DASH ladder.
+struct abr_consumer : public core::frame_consumer
+{
+    core::monitor::state    state_;
+    mutable std::mutex      state_mutex_;
+    int                     channel_index_ = -1;
+    core::video_format_desc format_desc_;
+    bool                    realtime_ = false;
+
+    spl::shared_ptr<diagnostics::graph> graph_;
+
+    std::string path_;
+    std::string args_;
+
+    std::vector<core::output_rendition> renditions_;
+
+    std::exception_ptr exception_;
+    std::mutex         exception_mutex_;
+
+    tbb::concurrent_bounded_queue<core::const_frame> frame_buffer_;
+    std::thread                                      frame_thread_;
+
+    std::atomic<bool> offline_{false};
+
+  public:
+    abr_consumer(std::string path, std::string args, bool realtime)
+        : channel_index_([&] {
+            boost::crc_16_type result;
+            result.process_bytes(path.data(), path.length());
+            return result.checksum();
+        }())
+        , realtime_(realtime)
+        , path_(std::move(path))
+        , args_(std::move(args))
+    {
+        state_["file/path"] = u8(path_);
+
+        frame_buffer_.set_capacity(realtime_ ? 1 : 64);
+
+        diagnostics::register_graph(graph_);
+        graph_->set_color("frame-time", diagnostics::color(0.1f, 1.0f, 0.1f));
+        graph_->set_color("video-encode-time", diagnostics::color(0.1f, 0.7f, 1.0f));
+        graph_->set_color("audio-encode-time", diagnostics::color(1.0f, 0.5f, 0.1f));
+        graph_->set_color("dropped-frame", diagnostics::color(0.3f, 0.6f, 0.3f));
+        graph_->set_color("input", diagnostics::color(0.7f, 0.4f, 0.4f));
+        graph_->set_color("output", diagnostics::color(0.4f, 0.4f, 0.7f));
+    }
+
+    ~abr_consumer()
+    {
+        if (frame_thread_.joinable()) {
+            frame_buffer_.push(core::const_frame{});
+            frame_thread_.join();
+        }
+    }
+
+    // frame consumer
+
+    void initialize(const core::video_format_desc& format_desc, int channel_index) override
+    {
+        if (frame_thread_.joinable()) {
+            CASPAR_THROW_EXCEPTION(invalid_operation() << msg_info("Cannot reinitialize ffmpeg-abr-consumer."));
+        }
+
+        format_desc_   = format_desc;
+        channel_index_ = channel_index;
+
+        graph_->set_text(print());
+
+        auto options = parse_options(args_);
+
+        std::string ladder_spec;
+        {
+            const auto it = options.find("ladder");
+            if (it != options.end()) {
+                ladder_spec = std::move(it->second);
+                options.erase(it);
+            }
+        }
+
+        auto ladder = parse_ladder(ladder_spec, format_desc);
+        for (auto& rung : ladder) {
+            renditions_.emplace_back(core::output_pixel_format::nv12, rung.width, rung.height);
+        }
+
+        frame_thread_ = std::thread([=] {
+            try {
+                run(options, ladder);
+            } catch (...) {
+                {
+                    std::lock_guard<std::mutex> lock(exception_mutex_);
+                    exception_ = std::current_exception();
+                }
+
+                // Releases a send that waits for room while offline, the next one rethrows.
+                core::const_frame frame;
+                while (frame_buffer_.try_pop(frame)) {
+                }
+            }
+        });
+    }
+
+    std::future<bool> send(core::const_frame frame) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(exception_mutex_);
+            if (exception_ != nullptr) {
+                std::rethrow_exception(exception_);
+            }
+        }
+
+        if (offline_) {
+            frame_buffer_.push(frame);
+        } else if (!frame_buffer_.try_push(frame)) {
+            graph_->set_tag(diagnostics::tag_severity::WARNING, "dropped-frame");
+        }
+        graph_->set_value("input", static_cast<double>(frame_buffer_.size() + 0.001) / frame_buffer_.capacity());
+
+        return make_ready_future(true);
+    }
+
+    std::wstring print() const override { return L"ffmpeg-abr[" + u16(path_) + L"]"; }
+
+    std::wstring name() const override { return L"ffmpeg-abr"; }
+
+    bool has_synchronization_clock() const override { return false; }
+
+    int index() const override { return 100000 + channel_index_; }
+
+    void offline(bool offline) override { offline_ = offline; }
+
+    std::vector<core::output_rendition> requested_renditions() const override { return renditions_; }
+
+    core::monitor::state state() const override
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        return state_;
+    }
+
+  private:
+    void run(std::map<std::string, std::string> options, const std::vector<ladder_rung>& ladder)
+    {
+        boost::filesystem::path full_path = path_;
+        if (!full_path.is_complete()) {
+            full_path = u8(env::media_folder()) + path_;
+        }
+        boost::filesystem::create_directories(full_path.parent_path());
+
+        AVOutputFormat* oformat = nullptr;
+        {
+            const auto format_it = options.find("format");
+            if (format_it != options.end()) {
+                oformat = av_guess_format(format_it->second.c_str(), nullptr, nullptr);
+                options.erase(format_it);
+            } else {
+                oformat = av_guess_format(nullptr, path_.c_str(), nullptr);
+            }
+        }
+
+        if (!oformat || oformat->video_codec == AV_CODEC_ID_NONE) {
+            FF_RET(AVERROR(EINVAL), "av_guess_format");
+        }
+
+        if (oformat->video_codec == AV_CODEC_ID_H264 && options.find("preset:v") == options.end()) {
+            options["preset:v"] = "veryfast";
+        }
+
+        // Segments can only be switched between if every rendition has keyframes at the same frames.
+        if (options.find("g:v") == options.end()) {
+            options["g:v"] = std::to_string(static_cast<int>(std::round(format_desc_.fps * 2)));
+        }
+        if (options.find("sc_threshold:v") == options.end()) {
+            options["sc_threshold:v"] = "0";
+        }
+
+        const auto global_header = (oformat->flags & AVFMT_GLOBALHEADER) != 0;
+
+        std::map<std::string, std::string> video_options;
+        for (auto it = options.begin(); it != options.end();) {
+            if (boost::algorithm::ends_with(it->first, ":v")) {
+                video_options.insert(*it);
+                it = options.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        std::vector<std::unique_ptr<Stream>>         video_streams;
+        std::vector<std::shared_ptr<AVCodecContext>> encoders;
+        for (auto& rung : ladder) {
+            auto stream_options    = video_options;
+            stream_options["b:v"] = rung.bitrate;
+
+            video_streams.push_back(std::make_unique<Stream>(":v",
+                                                             oformat->video_codec,
+                                                             format_desc_,
+                                                             realtime_,
+                                                             global_header,
+                                                             stream_options,
+                                                             renditions_.at(video_streams.size())));
+            encoders.push_back(video_streams.back()->enc);
+
+            if (video_streams.size() == 1) {
+                options.insert(stream_options.begin(), stream_options.end());
+            }
+        }
+
+        std::unique_ptr<Stream> audio_stream;
+        if (oformat->audio_codec != AV_CODEC_ID_NONE) {
+            audio_stream = std::make_unique<Stream>(
+                ":a", oformat->audio_codec, format_desc_, realtime_, global_header, options);
+            encoders.push_back(audio_stream->enc);
+        }
+
+        for (auto it = options.begin(); it != options.end();) {
+            if (boost::algorithm::ends_with(it->first, ":v") || boost::algorithm::ends_with(it->first, ":a")) {
+                CASPAR_LOG(warning) << print() << " Unused option " << it->first << "=" << it->second;
+                it = options.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        auto path = full_path.string();
+        if (std::string(oformat->name) == "hls") {
+            // One media playlist per rendition, the master playlist takes the name of the consumer.
+            if (options.find("var_stream_map") == options.end()) {
+                std::string map;
+                for (std::size_t n = 0; n < video_streams.size(); ++n) {
+                    map += "v:" + std::to_string(n) + (audio_stream ? ",agroup:audio " : " ");
+                }
+                map += audio_stream ? "a:0,agroup:audio" : "";
+                options["var_stream_map"] = boost::algorithm::trim_copy(map);
+            }
+            if (options.find("master_pl_name") == options.end()) {
+                options["master_pl_name"] = full_path.filename().string();
+            }
+            path = (full_path.parent_path() / (full_path.stem().string() + "_%v" + full_path.extension().string()))
+                       .string();
+        } else if (std::string(oformat->name) == "dash") {
+            if (options.find("adaptation_sets") == options.end()) {
+                options["adaptation_sets"] = audio_stream ? "id=0,streams=v id=1,streams=a" : "id=0,streams=v";
+            }
+        }
+
+        muxer output(print(), path, oformat, options, encoders, 0, false, graph_);
+        output.start();
+
+        std::mutex packet_mutex;
+        auto       dispatch = [&](int index) {
+            return [&, index](std::shared_ptr<AVPacket>&& pkt) {
+                pkt->stream_index = index;
+
+                std::lock_guard<std::mutex> lock(packet_mutex);
+                output.push(pkt);
+            };
+        };
+
+        // Every rendition is encoded on a thread of its own. The mixer already scaled and converted them, so only
+        // the largest one, which is the slowest to encode, is plotted.
+        const auto capacity = realtime_ ? 2 : 8;
+        const auto scale    = format_desc_.fps * 0.5;
+
+        std::vector<std::unique_ptr<pipeline_stage<core::const_frame>>> stages;
+        for (std::size_t n = 0; n < video_streams.size(); ++n) {
+            auto cb = dispatch(static_cast<int>(n));
+            stages.push_back(std::make_unique<pipeline_stage<core::const_frame>>(
+                capacity, [&, n, cb, stream = video_streams[n].get()](const core::const_frame& frame) {
+                    caspar::timer encode_timer;
+                    stream->encode(stream->convert(frame, format_desc_), cb);
+                    if (n == 0) {
+                        graph_->set_value("video-encode-time", encode_timer.elapsed() * scale);
+                    }
+                }));
+        }
+
+        if (audio_stream) {
+            stages.push_back(std::make_unique<pipeline_stage<core::const_frame>>(
+                capacity,
+                [&, cb = dispatch(static_cast<int>(video_streams.size()))](const core::const_frame& frame) {
+                    caspar::timer encode_timer;
+                    audio_stream->encode(audio_stream->convert(frame, format_desc_), cb);
+                    graph_->set_value("audio-encode-time", encode_timer.elapsed() * scale);
+                }));
+        }
+
+        std::int32_t frame_number = 0;
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(state_mutex_);
+                state_["file/frame"] = frame_number++;
+            }
+
+            core::const_frame frame;
+            frame_buffer_.pop(frame);
+            graph_->set_value("input", static_cast<double>(frame_buffer_.size() + 0.001) / frame_buffer_.capacity());
+
+            caspar::timer frame_timer;
+            for (auto& stage : stages) {
+                stage->check();
+                stage->push(frame);
+            }
+            output.check();
+            graph_->set_value("frame-time", frame_timer.elapsed() * scale);
+
+            if (!frame) {
+                break;
+            }
+        }
+
+        for (auto& stage : stages) {
+            stage->join();
+        }
+
+        output.close();
+        output.check();
+    }
+};
+
+spl::shared_ptr<core::frame_consumer> create_consumer(const std::vector<std::wstring>&                  params,
+                                                      std::vector<spl::shared_ptr<core::video_channel>> channels)
+{
+    if (params.size() < 2 || (!boost::iequals(params.at(0), L"STREAM") && !boost::iequals(params.at(0), L"FILE") &&
+                              !boost::iequals(params.at(0), L"ABR")))
+        return core::frame_consumer::empty();
+
+    const auto abr = boost::iequals(params.at(0), L"ABR");
+
+    // Like <realtime> in the config, ABR outputs are only realtime when asked for.
+    auto       extra_params = std::vector<std::wstring>(params.begin() + 2, params.end());
+    const auto realtime     = abr && get_and_consume_flag(L"REALTIME", extra_params);
+
+    auto                     path = u8(params.at(1));
     std::vector<std::string> args;
-    for (auto n = 2; n < params.size(); ++n) {
-        args.emplace_back(u8(params[n]));
+    for (auto& param : extra_params) {
+        args.emplace_back(u8(param));
+    }
+    if (abr) {
+        return spl::make_shared<abr_consumer>(path, boost::join(args, " "), realtime);
     }
     return spl::make_shared<ffmpeg_consumer>(path, boost::join(args, " "), boost::iequals(params.at(0), L"STREAM"));
 }
@@ -730,6 +1804,12 @@ spl::shared_ptr<core::frame_consumer>
 create_preconfigured_consumer(const boost::property_tree::wptree&               ptree,
                               std::vector<spl::shared_ptr<core::video_channel>> channels)
 {
+    auto ladder = ptree.get_optional<std::wstring>(L"ladder");
+    if (ladder) {
+        return spl::make_shared<abr_consumer>(u8(ptree.get<std::wstring>(L"path", L"")),
+                                              u8(ptree.get<std::wstring>(L"args", L"") + L" -ladder " + *ladder),
+                                              ptree.get(L"realtime", false));
+    }
     return spl::make_shared<ffmpeg_consumer>(u8(ptree.get<std::wstring>(L"path", L"")),
                                              u8(ptree.get<std::wstring>(L"args", L"")),
                                              ptree.get(L"realtime", false));
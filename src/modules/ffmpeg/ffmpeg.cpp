@@ -25,11 +25,13 @@
 
 #include "consumer/ffmpeg_consumer.h"
 #include "producer/ffmpeg_producer.h"
+#include "util/media_probe.h"
 
 #include <common/log.h>
 
 #include <core/consumer/frame_consumer.h>
 #include <core/producer/frame_producer.h>
+#include <core/producer/media_info/media_index.h>
 
 #include <mutex>
 
@@ -156,6 +158,9 @@ void init(core::module_dependencies dependencies)
     dependencies.consumer_registry->register_preconfigured_consumer_factory(L"ffmpeg", create_preconfigured_consumer);
 
     dependencies.producer_registry->register_producer_factory(L"FFmpeg Producer", create_producer);
+
+    dependencies.media_index->register_extractor(probe_media_info);
+    dependencies.media_index->register_thumbnail_generator(generate_thumbnail);
 }
 
 void uninit()
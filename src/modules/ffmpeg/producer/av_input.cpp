@@ -2,12 +2,15 @@
 
 #include "../util/av_assert.h"
 #include "../util/av_util.h"
+#include "../util/keyframe_index.h"
 
 #include <common/except.h>
 #include <common/os/thread.h>
 #include <common/param.h>
 #include <common/scope_exit.h>
 
+#include <algorithm>
+#include <cstring>
 #include <set>
 
 #ifdef _MSC_VER
@@ -23,44 +26,94 @@ extern "C" {
 
 namespace caspar { namespace ffmpeg {
 
-Input::Input(const std::string& filename, std::shared_ptr<diagnostics::graph> graph)
+namespace {
+
+const int64_t BUFFER_DURATION    = 2 * AV_TIME_BASE;
+const size_t  BUFFER_MAX_PACKETS = 1024; // For streams without packet durations.
+
+} // namespace
+
+Input::Input(const std::string& filename, std::shared_ptr<diagnostics::graph> graph, std::function<void()> on_packet)
     : filename_(filename)
     , graph_(graph)
+    , on_packet_(std::move(on_packet))
 {
     graph_->set_color("seek", diagnostics::color(1.0f, 0.5f, 0.0f));
     graph_->set_color("input", diagnostics::color(0.7f, 0.4f, 0.4f));
 
-    buffer_.set_capacity(256);
     thread_ = std::thread([=] {
         try {
             set_thread_name(L"[ffmpeg::av_producer::Input]");
 
             while (true) {
-                auto packet = alloc_packet();
+                auto    packet     = alloc_packet();
+                int64_t duration   = 0;
+                int64_t generation = 0;
 
                 {
                     std::unique_lock<std::mutex> lock(ic_mutex_);
-                    ic_cond_.wait(lock, [&] { return ic_ || abort_request_; });
+                    // Nothing more is read after the end of file until the input is sought.
+                    ic_cond_.wait(lock, [&] { return (ic_ && !eof_) || abort_request_; });
 
                     if (abort_request_) {
                         break;
                     }
 
+                    {
+                        std::lock_guard<std::mutex> buffer_lock(buffer_mutex_);
+                        generation = buffer_generation_;
+                    }
+
                     // TODO (perf) Non blocking av_read_frame when possible.
                     auto ret = av_read_frame(ic_.get(), packet.get());
 
                     if (ret == AVERROR_EXIT) {
                         break;
                     } else if (ret == AVERROR_EOF) {
-                        eof_   = true;
                         packet = nullptr;
+
+                        // Read the start of the next loop while the end of this one is still being decoded.
+                        const auto loop = loop_.load();
+                        if (loop != AV_NOPTS_VALUE && internal_seek(loop)) {
+                            rewound_ = loop;
+                        } else {
+                            eof_     = true;
+                            rewound_ = AV_NOPTS_VALUE;
+                        }
                     } else {
                         FF_RET(ret, "av_read_frame");
+
+                        if (packet->duration > 0) {
+                            const auto st = ic_->streams[packet->stream_index];
+                            duration      = av_rescale_q(packet->duration, st->time_base, {1, AV_TIME_BASE});
+                        }
                     }
                 }
 
-                buffer_.push(std::move(packet));
-                graph_->set_value("input", (static_cast<double>(buffer_.size()) / buffer_.capacity()));
+                {
+                    std::unique_lock<std::mutex> lock(buffer_mutex_);
+                    buffer_cond_.wait(
+                        lock, [&] { return !full() || abort_request_ || generation != buffer_generation_; });
+
+                    if (abort_request_) {
+                        break;
+                    }
+
+                    // Read before a seek flushed the buffer.
+                    if (generation != buffer_generation_) {
+                        continue;
+                    }
+
+                    if (packet) {
+                        buffer_duration_[packet->stream_index] += duration;
+                    }
+                    buffer_.push_back(buffered_packet{std::move(packet), duration});
+                    update_graph();
+                }
+
+                if (on_packet_) {
+                    on_packet_();
+                }
             }
         } catch (...) {
             CASPAR_LOG_CURRENT_EXCEPTION();
@@ -70,14 +123,7 @@ Input::Input(const std::string& filename, std::shared_ptr<diagnostics::graph> gr
 
 Input::~Input()
 {
-    graph_         = spl::shared_ptr<diagnostics::graph>();
-    abort_request_ = true;
-    ic_cond_.notify_all();
-
-    std::shared_ptr<AVPacket> packet;
-    while (buffer_.try_pop(packet))
-        ;
-
+    abort();
     thread_.join();
 }
 
@@ -89,9 +135,44 @@ int Input::interrupt_cb(void* ctx)
 
 bool Input::try_pop(std::shared_ptr<AVPacket>& packet)
 {
-    auto result = buffer_.try_pop(packet);
-    graph_->set_value("input", (static_cast<double>(buffer_.size()) / buffer_.capacity()));
-    return result;
+    {
+        std::lock_guard<std::mutex> lock(buffer_mutex_);
+
+        if (buffer_.empty()) {
+            return false;
+        }
+
+        auto& front = buffer_.front();
+        if (front.packet) {
+            buffer_duration_[front.packet->stream_index] -= front.duration;
+        }
+        packet = std::move(front.packet);
+        buffer_.pop_front();
+        update_graph();
+    }
+    buffer_cond_.notify_all();
+
+    return true;
+}
+
+bool Input::full() const
+{
+    if (buffer_.size() >= BUFFER_MAX_PACKETS) {
+        return true;
+    }
+    return std::any_of(
+        buffer_duration_.begin(), buffer_duration_.end(), [](auto& p) { return p.second >= BUFFER_DURATION; });
+}
+
+void Input::update_graph()
+{
+    auto duration = int64_t(0);
+    for (auto& p : buffer_duration_) {
+        duration = std::max(duration, p.second);
+    }
+    graph_->set_value("input",
+                      std::max(static_cast<double>(duration) / BUFFER_DURATION,
+                               static_cast<double>(buffer_.size()) / BUFFER_MAX_PACKETS));
 }
 
 AVFormatContext* Input::operator->() { return ic_.get(); }
@@ -99,8 +180,16 @@ AVFormatContext* const Input::operator->() const { return ic_.get(); }
 
 void Input::abort()
 {
+    // Set first so that interrupt_cb aborts a blocking read that holds ic_mutex_.
     abort_request_ = true;
+    {
+        std::lock_guard<std::mutex> lock(ic_mutex_);
+    }
     ic_cond_.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(buffer_mutex_);
+    }
+    buffer_cond_.notify_all();
 }
 
 void Input::reset()
@@ -149,29 +238,67 @@ void Input::internal_reset()
 
     FF(avformat_find_stream_info(ic2.get(), nullptr));
     ic_ = std::move(ic2);
+
+    // Builds the index of a local file in the background on first open, seeks fall back to the demuxer until then.
+    if (!index_) {
+        index_ = get_keyframe_index(u16(filename_));
+    }
     ic_cond_.notify_all();
 }
 
 bool Input::eof() const { return eof_; }
 
-void Input::seek(int64_t ts, bool flush)
+bool Input::seek(int64_t ts, bool flush)
 {
     std::unique_lock<std::mutex> lock(ic_mutex_);
 
-    if (ic_ && ts != ic_->start_time && ts != AV_NOPTS_VALUE) {
-        FF(avformat_seek_file(ic_.get(), -1, INT64_MIN, ts, ts, 0));
-    } else {
+    // Seeking is much cheaper than reopening, which is only needed when the input cannot seek at all.
+    auto reopen = !ic_ || ts == AV_NOPTS_VALUE || !internal_seek(ts);
+    if (reopen) {
         internal_reset();
     }
 
     if (flush) {
-        std::shared_ptr<AVPacket> packet;
-        while (buffer_.try_pop(packet))
-            ;
+        std::lock_guard<std::mutex> buffer_lock(buffer_mutex_);
+        buffer_.clear();
+        buffer_duration_.clear();
+        buffer_generation_ += 1;
+        update_graph();
     }
-    eof_ = false;
+    buffer_cond_.notify_all();
 
+    eof_     = false;
+    rewound_ = AV_NOPTS_VALUE;
+    ic_cond_.notify_all();
     graph_->set_tag(diagnostics::tag_severity::INFO, "seek");
+
+    return reopen;
 }
 
+bool Input::internal_seek(int64_t ts)
+{
+    if (!index_) {
+        index_ = get_keyframe_index(u16(filename_));
+    }
+
+    const auto keyframe = index_ ? index_->find(ts) : nullptr;
+    if (keyframe && index_->stream_index < static_cast<int>(ic_->nb_streams)) {
+        // Same as ffplay, formats with timestamp discontinuities have no index of their own and are otherwise bisected.
+        const auto by_bytes = (ic_->iformat->flags & AVFMT_TS_DISCONT) != 0 && std::strcmp(ic_->iformat->name, "ogg");
+        if (by_bytes && keyframe->pos >= 0 &&
+            avformat_seek_file(ic_.get(), -1, keyframe->pos, keyframe->pos, keyframe->pos, AVSEEK_FLAG_BYTE) >= 0) {
+            return true;
+        }
+        if (avformat_seek_file(ic_.get(), index_->stream_index, keyframe->pts, keyframe->pts, keyframe->pts, 0) >= 0) {
+            return true;
+        }
+    }
+
+    return avformat_seek_file(ic_.get(), -1, INT64_MIN, ts, ts, 0) >= 0;
+}
+
+void Input::loop(int64_t ts) { loop_ = ts; }
+
+int64_t Input::rewound() const { return rewound_; }
+
 }} // namespace caspar::ffmpeg
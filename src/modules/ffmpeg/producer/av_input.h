@@ -5,24 +5,28 @@
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
 #include <thread>
 
-#include <tbb/concurrent_queue.h>
-
 struct AVPacket;
 struct AVFormatContext;
 
 namespace caspar { namespace ffmpeg {
 
+struct keyframe_index;
+
 class Input
 {
   public:
-    Input(const std::string& filename, std::shared_ptr<diagnostics::graph> graph);
+    // on_packet is called from the reader thread whenever a packet, or the end of file, becomes available.
+    Input(const std::string&                  filename,
+          std::shared_ptr<diagnostics::graph> graph,
+          std::function<void()>               on_packet = nullptr);
     ~Input();
 
     static int interrupt_cb(void* ctx);
@@ -36,21 +40,48 @@ class Input
     void reset();
     void abort();
     bool eof() const;
-    void seek(int64_t ts, bool flush = true);
+
+    // Returns true if the input had to be reopened, which invalidates its streams.
+    bool seek(int64_t ts, bool flush = true);
+
+    // While set, reading rewinds to ts at the end of file so that the packets of the next loop follow the end of file
+    // marker without a flush. AV_NOPTS_VALUE disables it.
+    void    loop(int64_t ts);
+    int64_t rewound() const;
 
   private:
     void internal_reset();
+    bool internal_seek(int64_t ts);
+    bool full() const;
+    void update_graph();
 
     std::string                         filename_;
     std::shared_ptr<diagnostics::graph> graph_;
+    std::function<void()>               on_packet_;
 
     mutable std::mutex               ic_mutex_;
     std::shared_ptr<AVFormatContext> ic_;
     std::condition_variable          ic_cond_;
 
-    tbb::concurrent_bounded_queue<std::shared_ptr<AVPacket>> buffer_;
-
-    std::atomic<bool> eof_{false};
+    std::shared_ptr<const keyframe_index> index_; // nullptr until built.
+
+    struct buffered_packet
+    {
+        std::shared_ptr<AVPacket> packet;
+        int64_t                   duration; // AV_TIME_BASE
+    };
+
+    // The buffer is bounded by the time it covers rather than by its packet count, streams are buffered equally far
+    // regardless of their packet rates.
+    mutable std::mutex          buffer_mutex_;
+    std::condition_variable     buffer_cond_;
+    std::deque<buffered_packet> buffer_;
+    std::map<int, int64_t>      buffer_duration_; // By stream.
+    int64_t                     buffer_generation_ = 0;
+
+    std::atomic<bool>    eof_{false};
+    std::atomic<int64_t> loop_{INT64_MIN};    // AV_NOPTS_VALUE
+    std::atomic<int64_t> rewound_{INT64_MIN}; // AV_NOPTS_VALUE
 
     std::atomic<bool> abort_request_{false};
     std::thread       thread_;
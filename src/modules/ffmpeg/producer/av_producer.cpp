@@ -77,11 +77,13 @@ struct Frame
 struct Decoder
 {
     AVStream*                             st = nullptr;
+    std::shared_ptr<void>                 direct_buffers; // Declared before ctx, which refers to it until freed.
     std::shared_ptr<AVCodecContext>       ctx;
     int64_t                               next_pts = AV_NOPTS_VALUE;
     std::queue<std::shared_ptr<AVPacket>> input;
     std::shared_ptr<AVFrame>              frame;
-    bool                                  eof = false;
+    bool                                  eof        = false;
+    int64_t                               skip_until = AV_NOPTS_VALUE;
 
     Decoder() = default;
 
@@ -129,6 +131,27 @@ struct Decoder
         FF(avcodec_open2(ctx.get(), codec, nullptr));
     }
 
+    // Drops everything in flight so that the decoder can be reused after a seek. When the input has rewound for a loop,
+    // the packets queued after the end of file marker start the next iteration and are kept.
+    void flush(bool rewound = false)
+    {
+        avcodec_flush_buffers(ctx.get());
+        if (!rewound) {
+            input = {};
+        } else if (!eof) {
+            while (!input.empty()) {
+                const auto packet = std::move(input.front());
+                input.pop();
+                if (!packet) {
+                    break;
+                }
+            }
+        }
+        frame    = nullptr;
+        eof      = false;
+        next_pts = AV_NOPTS_VALUE;
+    }
+
     bool operator()()
     {
         if (frame || eof || !st) {
@@ -142,7 +165,15 @@ struct Decoder
             if (input.empty()) {
                 return false;
             }
-            FF(avcodec_send_packet(ctx.get(), input.front().get()));
+            const auto& packet = input.front();
+            if (packet && ctx->codec_type == AVMEDIA_TYPE_VIDEO && skip_until != AV_NOPTS_VALUE) {
+                // The fps filter drops everything before the seek target, so frames that nothing references are not
+                // decoded up to the one before the target, which deinterlacing still needs.
+                const auto skip = packet->pts != AV_NOPTS_VALUE && packet->duration > 0 &&
+                                  packet->pts + 2 * packet->duration <= skip_until;
+                ctx->skip_frame = skip ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+            }
+            FF(avcodec_send_packet(ctx.get(), packet.get()));
             input.pop();
         } else if (ret == AVERROR_EOF) {
             avcodec_flush_buffers(ctx.get());
@@ -202,7 +233,8 @@ struct Filter
            std::map<int, Decoder>&        streams,
            int64_t                        start_time,
            AVMediaType                    media_type,
-           const core::video_format_desc& format_desc)
+           const core::video_format_desc& format_desc,
+           bit_depth                      depth = bit_depth::bit8)
     {
         if (media_type == AVMEDIA_TYPE_VIDEO) {
             if (filter_spec.empty()) {
@@ -412,22 +444,41 @@ struct Filter
 #pragma warning(push)
 #pragma warning(disable : 4245)
 #endif
-            const AVPixelFormat pix_fmts[] = {AV_PIX_FMT_RGB24,
-                                              AV_PIX_FMT_BGR24,
-                                              AV_PIX_FMT_BGRA,
-                                              AV_PIX_FMT_ARGB,
-                                              AV_PIX_FMT_RGBA,
-                                              AV_PIX_FMT_ABGR,
-                                              AV_PIX_FMT_YUV444P,
-                                              AV_PIX_FMT_YUV422P,
-                                              AV_PIX_FMT_YUV420P,
-                                              AV_PIX_FMT_YUV410P,
-                                              AV_PIX_FMT_YUVA444P,
-                                              AV_PIX_FMT_YUVA422P,
-                                              AV_PIX_FMT_YUVA420P,
-                                              AV_PIX_FMT_UYVY422,
-                                              AV_PIX_FMT_NONE};
-            FF(av_opt_set_int_list(sink, "pix_fmts", pix_fmts, -1, AV_OPT_SEARCH_CHILDREN));
+            std::vector<AVPixelFormat> pix_fmts = {AV_PIX_FMT_RGB24,
+                                                   AV_PIX_FMT_BGR24,
+                                                   AV_PIX_FMT_BGRA,
+                                                   AV_PIX_FMT_ARGB,
+                                                   AV_PIX_FMT_RGBA,
+                                                   AV_PIX_FMT_ABGR,
+                                                   AV_PIX_FMT_YUV444P,
+                                                   AV_PIX_FMT_YUV422P,
+                                                   AV_PIX_FMT_YUV420P,
+                                                   AV_PIX_FMT_YUV410P,
+                                                   AV_PIX_FMT_YUVA444P,
+                                                   AV_PIX_FMT_YUVA422P,
+                                                   AV_PIX_FMT_YUVA420P,
+                                                   AV_PIX_FMT_UYVY422};
+            // Deep sources are only kept deep when the mixer renders in more than 8 bits.
+            if (depth != bit_depth::bit8) {
+                pix_fmts.insert(pix_fmts.end(),
+                                {AV_PIX_FMT_YUV444P10,
+                                 AV_PIX_FMT_YUV422P10,
+                                 AV_PIX_FMT_YUV420P10,
+                                 AV_PIX_FMT_YUV444P12,
+                                 AV_PIX_FMT_YUV422P12,
+                                 AV_PIX_FMT_YUV420P12,
+                                 AV_PIX_FMT_YUV444P16,
+                                 AV_PIX_FMT_YUV422P16,
+                                 AV_PIX_FMT_YUV420P16,
+                                 AV_PIX_FMT_YUVA444P10,
+                                 AV_PIX_FMT_YUVA422P10,
+                                 AV_PIX_FMT_YUVA420P10,
+                                 AV_PIX_FMT_YUVA444P16,
+                                 AV_PIX_FMT_YUVA422P16,
+                                 AV_PIX_FMT_YUVA420P16});
+            }
+            pix_fmts.push_back(AV_PIX_FMT_NONE);
+            FF(av_opt_set_int_list(sink, "pix_fmts", pix_fmts.data(), -1, AV_OPT_SEARCH_CHILDREN));
 #ifdef _MSC_VER
 #pragma warning(pop)
 #endif
@@ -518,6 +569,11 @@ struct AVProducer::Impl
     const std::string                          name_;
     const std::string                          path_;
 
+    // Signalled on new packets and on changes of the playback state, the producer thread sleeps on it otherwise.
+    boost::mutex              wake_mutex_;
+    boost::condition_variable wake_cond_;
+    bool                      wake_ = false;
+
     Input                  input_;
     std::map<int, Decoder> decoders_;
     Filter                 video_filter_;
@@ -530,6 +586,7 @@ struct AVProducer::Impl
     std::atomic<int64_t> input_duration_{AV_NOPTS_VALUE};
     std::atomic<int64_t> seek_{AV_NOPTS_VALUE};
     std::atomic<bool>    loop_{false};
+    std::atomic<bool>    offline_{false};
 
     std::string afilter_;
     std::string vfilter_;
@@ -565,7 +622,7 @@ struct AVProducer::Impl
         , format_tb_({format_desc.duration, format_desc.time_scale})
         , name_(name)
         , path_(path)
-        , input_(path, graph_)
+        , input_(path, graph_, [this] { wake(); })
         , start_(start ? av_rescale_q(*start, format_tb_, TIME_BASE_Q) : AV_NOPTS_VALUE)
         , duration_(duration ? av_rescale_q(*duration, format_tb_, TIME_BASE_Q) : AV_NOPTS_VALUE)
         , loop_(loop)
@@ -598,6 +655,7 @@ struct AVProducer::Impl
         abort_request_ = true;
         input_.abort();
         buffer_cond_.notify_all();
+        wake();
         thread_.join();
     }
 
@@ -647,7 +705,8 @@ struct AVProducer::Impl
 
         Frame frame;
 
-        int warning_debounce = 0;
+        double stalled      = 0.0;
+        double next_warning = 1.0;
 
         while (!abort_request_) {
             {
@@ -673,16 +732,24 @@ struct AVProducer::Impl
                 // check whether the next frame will last beyond the end time
                 auto time = next_pts ? next_pts + frame.duration : 0;
 
-                buffer_eof_ = (video_filter_.eof && audio_filter_.eof) || time > end;
+                const auto input_eof = video_filter_.eof && audio_filter_.eof;
+
+                input_.loop(loop_ ? start + input_start_time() : AV_NOPTS_VALUE);
+
+                const auto eof = input_eof || time > end;
+                if (eof != buffer_eof_) {
+                    boost::lock_guard<boost::mutex> lock(buffer_mutex_);
+                    buffer_eof_ = eof;
+                    buffer_cond_.notify_all();
+                }
 
                 if (buffer_eof_) {
-                    if (loop_ && frame_count_ > 2) {
+                    if (loop_ && frame_count_ > 0) {
                         frame = Frame{};
-                        seek_internal(start);
+                        seek_internal(start, input_eof);
                     } else {
-                        boost::this_thread::sleep_for(boost::chrono::milliseconds(10));
+                        wait();
                     }
-                    // TODO (fix) Limit live polling due to bugs.
                     continue;
                 }
             }
@@ -696,7 +763,8 @@ struct AVProducer::Impl
 
             if ((!video_filter_.frame && !video_filter_.eof) || (!audio_filter_.frame && !audio_filter_.eof)) {
                 if (!progress) {
-                    if (warning_debounce++ % 500 == 100) {
+                    if (stalled >= next_warning) {
+                        next_warning += 5.0;
                         if (!video_filter_.frame && !video_filter_.eof) {
                             CASPAR_LOG(warning) << print() << " Waiting for video frame...";
                         } else if (!audio_filter_.frame && !audio_filter_.eof) {
@@ -706,13 +774,16 @@ struct AVProducer::Impl
                         }
                     }
 
-                    boost::this_thread::sleep_for(boost::chrono::milliseconds(warning_debounce > 25 ? 10 : 1));
+                    timer wait_timer;
+                    wait();
+                    stalled += wait_timer.elapsed();
                     frame_timer.restart();
                 }
                 continue;
             }
 
-            warning_debounce = 0;
+            stalled      = 0.0;
+            next_warning = 1.0;
 
             // TODO (fix)
             // if (start_ != AV_NOPTS_VALUE && frame.pts < start_) {
@@ -740,7 +811,7 @@ struct AVProducer::Impl
                 frame.duration   = av_rescale_q(frame.audio->nb_samples, {1, sr}, TIME_BASE_Q);
             }
 
-            frame.frame = core::draw_frame(make_frame(this, *frame_factory_, frame.video, frame.audio));
+            frame.frame = make_frame(this, *frame_factory_, frame.video, frame.audio);
 
             graph_->set_value("frame-time", frame_timer.elapsed() * format_desc_.fps * 0.5);
             frame_timer.restart();
@@ -750,6 +821,7 @@ struct AVProducer::Impl
                 buffer_cond_.wait(buffer_lock, [&] { return buffer_.size() < buffer_capacity_ || abort_request_; });
                 if (seek_ == AV_NOPTS_VALUE) {
                     buffer_.push_back(frame);
+                    buffer_cond_.notify_all();
                 }
             }
 
@@ -787,13 +859,29 @@ struct AVProducer::Impl
         return core::draw_frame::still(frame_);
     }
 
+    // A few frames are buffered after a flush so that playback doesn't underflow right away. Requires buffer_mutex_.
+    bool has_frame() const { return !buffer_.empty() && !(frame_flush_ && buffer_.size() < 4); }
+
+    void wait_for_frame(std::chrono::milliseconds timeout)
+    {
+        boost::unique_lock<boost::mutex> lock(buffer_mutex_);
+        buffer_cond_.wait_for(lock, boost::chrono::milliseconds(timeout.count()), [&] {
+            return has_frame() || buffer_eof_ || abort_request_;
+        });
+    }
+
     core::draw_frame next_frame()
     {
         CASPAR_SCOPE_EXIT { update_state(); };
 
-        boost::lock_guard<boost::mutex> lock(buffer_mutex_);
+        boost::unique_lock<boost::mutex> lock(buffer_mutex_);
 
-        if (buffer_.empty() || (frame_flush_ && buffer_.size() < 4)) {
+        if (offline_) {
+            // A looping input is only at its end until it has been re-cued.
+            buffer_cond_.wait(lock, [&] { return has_frame() || (buffer_eof_ && !loop_) || abort_request_; });
+        }
+
+        if (!has_frame()) {
             auto start    = start_.load();
             auto duration = duration_.load();
 
@@ -836,6 +924,7 @@ struct AVProducer::Impl
         CASPAR_SCOPE_EXIT { update_state(); };
 
         seek_ = av_rescale_q(time, format_tb_, TIME_BASE_Q);
+        wake();
 
         {
             boost::lock_guard<boost::mutex> lock(buffer_mutex_);
@@ -860,6 +949,7 @@ struct AVProducer::Impl
         CASPAR_SCOPE_EXIT { update_state(); };
 
         loop_ = loop;
+        wake();
     }
 
     bool loop() const { return loop_; }
@@ -868,6 +958,7 @@ struct AVProducer::Impl
     {
         CASPAR_SCOPE_EXIT { update_state(); };
         start_ = av_rescale_q(start, format_tb_, TIME_BASE_Q);
+        wake();
     }
 
     boost::optional<int64_t> start() const
@@ -881,6 +972,7 @@ struct AVProducer::Impl
         CASPAR_SCOPE_EXIT { update_state(); };
 
         duration_ = av_rescale_q(duration, format_tb_, TIME_BASE_Q);
+        wake();
     }
 
     boost::optional<int64_t> duration() const
@@ -899,6 +991,23 @@ struct AVProducer::Impl
     }
 
   private:
+    void wake()
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(wake_mutex_);
+            wake_ = true;
+        }
+        wake_cond_.notify_one();
+    }
+
+    // The timeout only bounds how late a stall is reported.
+    void wait()
+    {
+        boost::unique_lock<boost::mutex> lock(wake_mutex_);
+        wake_cond_.wait_for(lock, boost::chrono::seconds(1), [&] { return wake_ || abort_request_; });
+        wake_ = false;
+    }
+
     bool want_packet()
     {
         return std::any_of(
@@ -970,25 +1079,39 @@ struct AVProducer::Impl
         return result;
     }
 
-    void seek_internal(int64_t time)
+    int64_t input_start_time() const { return input_->start_time != AV_NOPTS_VALUE ? input_->start_time : 0; }
+
+    // A loop keeps playing what is already buffered and, if the input has already rewound to the start of the clip,
+    // continues with the packets that follow the end of file.
+    void seek_internal(int64_t time, bool loop = false)
     {
         time = time != AV_NOPTS_VALUE ? time : 0;
-        time = time + (input_->start_time != AV_NOPTS_VALUE ? input_->start_time : 0);
+        time = time + input_start_time();
+
+        const auto rewound = loop && input_.rewound() == time;
+
+        if (!rewound) {
+            // TODO (fix) Dont seek if time is close future.
+            if (input_.seek(time)) {
+                decoders_.clear();
+            }
+        }
+
+        for (auto& p : decoders_) {
+            p.second.flush(rewound);
+        }
 
-        // TODO (fix) Dont seek if time is close future.
-        input_.seek(time);
-        frame_flush_ = true;
+        frame_flush_ = frame_flush_ || !loop;
         frame_count_ = 0;
         buffer_eof_  = false;
 
-        decoders_.clear();
-
         reset(time);
     }
 
     void reset(int64_t start_time)
     {
-        video_filter_ = Filter(vfilter_, input_, decoders_, start_time, AVMEDIA_TYPE_VIDEO, format_desc_);
+        video_filter_ = Filter(
+            vfilter_, input_, decoders_, start_time, AVMEDIA_TYPE_VIDEO, format_desc_, frame_factory_->depth());
         audio_filter_ = Filter(afilter_, input_, decoders_, start_time, AVMEDIA_TYPE_AUDIO, format_desc_);
 
         sources_.clear();
@@ -1010,6 +1133,13 @@ struct AVProducer::Impl
         for (auto& key : keys) {
             decoders_.erase(key);
         }
+
+        for (auto& p : decoders_) {
+            if (!p.second.direct_buffers) {
+                p.second.direct_buffers = use_frame_factory_buffers(p.second.ctx.get(), this, frame_factory_);
+            }
+            p.second.skip_until = av_rescale_q(start_time, TIME_BASE_Q, p.second.st->time_base);
+        }
     }
 
     std::string print() const
@@ -1047,6 +1177,13 @@ AVProducer::AVProducer(std::shared_ptr<core::frame_factory> frame_factory,
 core::draw_frame AVProducer::next_frame() { return impl_->next_frame(); }
 
 core::draw_frame AVProducer::prev_frame() { return impl_->prev_frame(); }
+void AVProducer::wait_for_frame(std::chrono::milliseconds timeout) { impl_->wait_for_frame(timeout); }
+
+AVProducer& AVProducer::offline(bool offline)
+{
+    impl_->offline_ = offline;
+    return *this;
+}
 
 AVProducer& AVProducer::seek(int64_t time)
 {
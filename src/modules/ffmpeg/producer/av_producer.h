@@ -6,6 +6,7 @@
 
 #include <boost/optional.hpp>
 
+#include <chrono>
 #include <memory>
 #include <string>
 
@@ -27,6 +28,12 @@ class AVProducer
     core::draw_frame prev_frame();
     core::draw_frame next_frame();
 
+    // Blocks until next_frame has a frame to return, the input ended or the timeout expired.
+    void wait_for_frame(std::chrono::milliseconds timeout);
+
+    // Offline, next_frame waits for decoding instead of returning an empty frame on underflow.
+    AVProducer& offline(bool offline);
+
     AVProducer& seek(int64_t time);
     int64_t     time() const;
 
@@ -105,6 +105,10 @@ struct ffmpeg_producer : public core::frame_producer
 
     core::draw_frame receive_impl(int nb_samples) override { return producer_->next_frame(); }
 
+    void wait_for_first_frame(std::chrono::milliseconds timeout) override { producer_->wait_for_frame(timeout); }
+
+    void offline(bool offline) override { producer_->offline(offline); }
+
     std::uint32_t frame_number() const override
     {
         return static_cast<std::uint32_t>(producer_->time() - producer_->start());
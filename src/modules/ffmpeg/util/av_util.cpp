@@ -2,6 +2,10 @@
 
 #include "av_assert.h"
 
+#include <common/log.h>
+
+#include <core/frame/geometry.h>
+
 #if defined(_MSC_VER)
 #pragma warning(push)
 #pragma warning(disable : 4244)
@@ -10,6 +14,8 @@ extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavfilter/avfilter.h>
 #include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
 #include <libavutil/pixfmt.h>
 }
 #if defined(_MSC_VER)
@@ -18,8 +24,147 @@ extern "C" {
 
 #include <tbb/parallel_for.h>
 
+#include <algorithm>
+#include <atomic>
+
 namespace caspar { namespace ffmpeg {
 
+namespace {
+
+struct direct_allocator : std::enable_shared_from_this<direct_allocator>
+{
+    void*                                tag;
+    std::shared_ptr<core::frame_factory> frame_factory;
+    std::atomic<bool>                    enabled{true};
+};
+
+// A decoded picture living in frame_factory memory. Every plane buffer and the opaque_ref of the AVFrame keep it
+// alive, and once committed it keeps the planes alive for as long as the decoder or the filters reference them.
+struct direct_frame
+{
+    std::shared_ptr<direct_allocator> allocator;
+    core::mutable_frame               frame;
+    std::vector<std::uint8_t*>        data;
+    core::const_frame                 committed;
+    bool                              taken = false;
+};
+
+void release_direct_frame(void* opaque, uint8_t* data) { delete static_cast<std::shared_ptr<direct_frame>*>(opaque); }
+
+AVBufferRef* ref_direct_frame(const std::shared_ptr<direct_frame>& direct, uint8_t* data, int size)
+{
+    auto opaque = new std::shared_ptr<direct_frame>(direct);
+    auto ref    = av_buffer_create(data ? data : reinterpret_cast<uint8_t*>(opaque),
+                                data ? size : static_cast<int>(sizeof(*opaque)),
+                                release_direct_frame,
+                                opaque,
+                                0);
+    if (!ref) {
+        delete opaque;
+    }
+    return ref;
+}
+
+std::shared_ptr<direct_frame> find_direct_frame(const AVFrame* video)
+{
+    if (!video->opaque_ref || video->opaque_ref->size != static_cast<int>(sizeof(std::shared_ptr<direct_frame>))) {
+        return nullptr;
+    }
+    return *reinterpret_cast<std::shared_ptr<direct_frame>*>(video->opaque_ref->data);
+}
+
+bool is_direct_format(AVPixelFormat pix_fmt, bit_depth depth)
+{
+    const auto format = get_pixel_format(pix_fmt);
+    if (format != core::pixel_format::ycbcr && format != core::pixel_format::ycbcra) {
+        return false;
+    }
+    return get_bit_depth(pix_fmt) == bit_depth::bit8 || depth != bit_depth::bit8;
+}
+
+int get_direct_buffer(AVCodecContext* ctx, AVFrame* frame, int flags)
+{
+    auto       allocator = static_cast<direct_allocator*>(ctx->opaque);
+    const auto pix_fmt   = static_cast<AVPixelFormat>(frame->format);
+
+    if (!allocator->enabled || !is_direct_format(pix_fmt, allocator->frame_factory->depth())) {
+        return avcodec_default_get_buffer2(ctx, frame, flags);
+    }
+
+    try {
+        int width  = frame->width;
+        int height = frame->height;
+        int linesize_align[AV_NUM_DATA_POINTERS];
+        avcodec_align_dimensions2(ctx, &width, &height, linesize_align);
+
+        // Widen until every row meets the decoder's alignment, make_frame crops the padding away again.
+        int  linesize[4];
+        bool aligned = false;
+        while (!aligned) {
+            FF(av_image_fill_linesizes(linesize, pix_fmt, width));
+            aligned = true;
+            for (int n = 0; n < 4; ++n) {
+                aligned = aligned && linesize[n] % linesize_align[n] == 0;
+            }
+            width += aligned ? 0 : 2;
+        }
+
+        // Same slack as avcodec_default_get_buffer2 leaves for SIMD over-reads past the last row.
+        height += 2;
+
+        std::vector<int> data_map;
+        const auto       desc = pixel_format_desc(pix_fmt, width, height, data_map);
+
+        auto direct = std::make_shared<direct_frame>(
+            direct_frame{allocator->shared_from_this(), allocator->frame_factory->create_frame(allocator->tag, desc)});
+
+        for (int n = 0; n < static_cast<int>(desc.planes.size()); ++n) {
+            auto& plane = direct->frame.image_data(n);
+            direct->data.push_back(plane.data());
+
+            frame->data[n]     = plane.data();
+            frame->linesize[n] = desc.planes[n].linesize;
+            frame->buf[n]      = ref_direct_frame(direct, plane.data(), static_cast<int>(plane.size()));
+            if (!frame->buf[n]) {
+                FF_RET(AVERROR(ENOMEM), "av_buffer_create");
+            }
+        }
+        frame->extended_data = frame->data;
+
+        av_buffer_unref(&frame->opaque_ref);
+        frame->opaque_ref = ref_direct_frame(direct, nullptr, 0);
+        if (!frame->opaque_ref) {
+            FF_RET(AVERROR(ENOMEM), "av_buffer_create");
+        }
+
+        return 0;
+    } catch (...) {
+        CASPAR_LOG_CURRENT_EXCEPTION();
+        for (auto& buf : frame->buf) {
+            av_buffer_unref(&buf);
+        }
+        std::fill(std::begin(frame->data), std::end(frame->data), nullptr);
+        std::fill(std::begin(frame->linesize), std::end(frame->linesize), 0);
+        allocator->enabled = false;
+        return avcodec_default_get_buffer2(ctx, frame, flags);
+    }
+}
+
+void copy_audio(core::mutable_frame& frame, const std::shared_ptr<AVFrame>& audio)
+{
+    // TODO This is a bit of a hack
+    frame.audio_data() = std::vector<int32_t>(audio->nb_samples * 8, 0);
+    auto dst           = frame.audio_data().data();
+    auto src           = reinterpret_cast<int32_t*>(audio->data[0]);
+    tbb::parallel_for(0, audio->nb_samples, [&](int i) {
+        for (auto j = 0; j < std::min(8, audio->channels); ++j) {
+            dst[i * 8 + j] = src[i * audio->channels + j];
+        }
+    });
+}
+
+} // namespace
+
 std::shared_ptr<AVFrame> alloc_frame()
 {
     const auto frame = std::shared_ptr<AVFrame>(av_frame_alloc(), [](AVFrame* ptr) { av_frame_free(&ptr); });
@@ -36,11 +181,44 @@ std::shared_ptr<AVPacket> alloc_packet()
     return packet;
 }
 
-core::mutable_frame make_frame(void*                    tag,
-                               core::frame_factory&     frame_factory,
-                               std::shared_ptr<AVFrame> video,
-                               std::shared_ptr<AVFrame> audio)
+core::draw_frame make_frame(void*                    tag,
+                            core::frame_factory&     frame_factory,
+                            std::shared_ptr<AVFrame> video,
+                            std::shared_ptr<AVFrame> audio)
 {
+    auto direct = video ? find_direct_frame(video.get()) : nullptr;
+    if (direct) {
+        auto passed = !direct->taken;
+        for (int n = 0; n < static_cast<int>(direct->data.size()); ++n) {
+            passed = passed && video->data[n] == direct->data[n];
+        }
+
+        if (passed) {
+            auto&       frame = direct->frame;
+            const auto& desc  = frame.pixel_format_desc();
+            if (audio) {
+                copy_audio(frame, audio);
+            }
+
+            const auto u     = static_cast<double>(video->width) / desc.planes[0].width;
+            const auto v     = static_cast<double>(video->height) / desc.planes[0].height;
+            frame.geometry() = core::frame_geometry(core::frame_geometry::geometry_type::quad,
+                                                    {{0.0, 0.0, 0.0, 0.0}, // upper left
+                                                     {1.0, 0.0, u, 0.0},   // upper right
+                                                     {1.0, 1.0, u, v},     // lower right
+                                                     {0.0, 1.0, 0.0, v}}); // lower left
+
+            direct->committed = core::const_frame(std::move(frame));
+            direct->taken     = true;
+            return core::draw_frame(direct->committed);
+        }
+
+        // The filters produced a new picture, writing into upload memory only slows the decoder down from now on.
+        if (video->data[0] != direct->data[0] && direct->allocator->enabled.exchange(false)) {
+            CASPAR_LOG(debug) << L"[ffmpeg] Filters do not pass decoded frames through, disabling direct decoding.";
+        }
+    }
+
     std::vector<int> data_map; // TODO(perf) when using data_map, avoid uploading duplicate planes
 
     const auto pix_desc =
@@ -62,18 +240,30 @@ core::mutable_frame make_frame(void*                    tag,
     }
 
     if (audio) {
-        // TODO This is a bit of a hack
-        frame.audio_data() = std::vector<int32_t>(audio->nb_samples * 8, 0);
-        auto dst           = frame.audio_data().data();
-        auto src           = reinterpret_cast<int32_t*>(audio->data[0]);
-        tbb::parallel_for(0, audio->nb_samples, [&](int i) {
-            for (auto j = 0; j < std::min(8, audio->channels); ++j) {
-                dst[i * 8 + j] = src[i * audio->channels + j];
-            }
-        });
+        copy_audio(frame, audio);
     }
 
-    return frame;
+    return core::draw_frame(std::move(frame));
+}
+
+std::shared_ptr<void>
+use_frame_factory_buffers(AVCodecContext* ctx, void* tag, const std::shared_ptr<core::frame_factory>& frame_factory)
+{
+    // Reference pictures of inter codecs would be read back from write combined upload memory, which is very slow.
+    const auto descriptor = avcodec_descriptor_get(ctx->codec_id);
+    if (ctx->codec_type != AVMEDIA_TYPE_VIDEO || !ctx->codec || !(ctx->codec->capabilities & AV_CODEC_CAP_DR1) ||
+        !descriptor || !(descriptor->props & AV_CODEC_PROP_INTRA_ONLY)) {
+        return nullptr;
+    }
+
+    auto allocator           = std::make_shared<direct_allocator>();
+    allocator->tag           = tag;
+    allocator->frame_factory = frame_factory;
+
+    ctx->opaque      = allocator.get();
+    ctx->get_buffer2 = get_direct_buffer;
+
+    return allocator;
 }
 
 core::pixel_format get_pixel_format(AVPixelFormat pix_fmt)
@@ -103,12 +293,29 @@ core::pixel_format get_pixel_format(AVPixelFormat pix_fmt)
             return core::pixel_format::ycbcr;
         case AV_PIX_FMT_YUV410P:
             return core::pixel_format::ycbcr;
+        case AV_PIX_FMT_YUV420P10:
+        case AV_PIX_FMT_YUV422P10:
+        case AV_PIX_FMT_YUV444P10:
+        case AV_PIX_FMT_YUV420P12:
+        case AV_PIX_FMT_YUV422P12:
+        case AV_PIX_FMT_YUV444P12:
+        case AV_PIX_FMT_YUV420P16:
+        case AV_PIX_FMT_YUV422P16:
+        case AV_PIX_FMT_YUV444P16:
+            return core::pixel_format::ycbcr;
         case AV_PIX_FMT_YUVA420P:
             return core::pixel_format::ycbcra;
         case AV_PIX_FMT_YUVA422P:
             return core::pixel_format::ycbcra;
         case AV_PIX_FMT_YUVA444P:
             return core::pixel_format::ycbcra;
+        case AV_PIX_FMT_YUVA420P10:
+        case AV_PIX_FMT_YUVA422P10:
+        case AV_PIX_FMT_YUVA444P10:
+        case AV_PIX_FMT_YUVA420P16:
+        case AV_PIX_FMT_YUVA422P16:
+        case AV_PIX_FMT_YUVA444P16:
+            return core::pixel_format::ycbcra;
         case AV_PIX_FMT_UYVY422:
             return core::pixel_format::uyvy;
         default:
@@ -116,6 +323,21 @@ core::pixel_format get_pixel_format(AVPixelFormat pix_fmt)
     }
 }
 
+bit_depth get_bit_depth(AVPixelFormat pix_fmt)
+{
+    const auto desc = av_pix_fmt_desc_get(pix_fmt);
+    switch (desc ? desc->comp[0].depth : 8) {
+        case 10:
+            return bit_depth::bit10;
+        case 12:
+            return bit_depth::bit12;
+        case 16:
+            return bit_depth::bit16;
+        default:
+            return bit_depth::bit8;
+    }
+}
+
 core::pixel_format_desc pixel_format_desc(AVPixelFormat pix_fmt, int width, int height, std::vector<int>& data_map)
 {
     // Get linesizes
@@ -148,12 +370,17 @@ core::pixel_format_desc pixel_format_desc(AVPixelFormat pix_fmt, int width, int
             auto size2 = static_cast<int>(dummy_pict.data[2] - dummy_pict.data[1]);
             auto h2    = size2 / dummy_pict.linesize[1];
 
-            desc.planes.push_back(core::pixel_format_desc::plane(dummy_pict.linesize[0], height, 1));
-            desc.planes.push_back(core::pixel_format_desc::plane(dummy_pict.linesize[1], h2, 1));
-            desc.planes.push_back(core::pixel_format_desc::plane(dummy_pict.linesize[2], h2, 1));
+            // Linesizes are in bytes, plane widths in samples.
+            auto depth = get_bit_depth(pix_fmt);
+            auto bytes = bytes_per_sample(depth);
+
+            desc.planes.push_back(core::pixel_format_desc::plane(dummy_pict.linesize[0] / bytes, height, 1, depth));
+            desc.planes.push_back(core::pixel_format_desc::plane(dummy_pict.linesize[1] / bytes, h2, 1, depth));
+            desc.planes.push_back(core::pixel_format_desc::plane(dummy_pict.linesize[2] / bytes, h2, 1, depth));
 
             if (desc.format == core::pixel_format::ycbcra)
-                desc.planes.push_back(core::pixel_format_desc::plane(dummy_pict.linesize[3], height, 1));
+                desc.planes.push_back(
+                    core::pixel_format_desc::plane(dummy_pict.linesize[3] / bytes, height, 1, depth));
 
             return desc;
         }
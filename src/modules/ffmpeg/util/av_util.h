@@ -1,5 +1,6 @@
 #include <libavutil/pixfmt.h>
 
+#include <core/frame/draw_frame.h>
 #include <core/frame/frame.h>
 #include <core/frame/frame_factory.h>
 #include <core/frame/pixel_format.h>
@@ -19,12 +20,18 @@ std::shared_ptr<AVFrame>  alloc_frame();
 std::shared_ptr<AVPacket> alloc_packet();
 
 core::pixel_format      get_pixel_format(AVPixelFormat pix_fmt);
+bit_depth               get_bit_depth(AVPixelFormat pix_fmt);
 core::pixel_format_desc pixel_format_desc(AVPixelFormat pix_fmt, int width, int height, std::vector<int>& data_map);
-core::mutable_frame     make_frame(void*                    tag,
+core::draw_frame        make_frame(void*                    tag,
                                    core::frame_factory&     frame_factory,
                                    std::shared_ptr<AVFrame> video,
                                    std::shared_ptr<AVFrame> audio);
 
+// Lets an intra only video decoder write straight into frames from frame_factory, which make_frame then commits
+// without copying. The returned state has to outlive ctx, nullptr if the decoder does not qualify.
+std::shared_ptr<void>
+use_frame_factory_buffers(AVCodecContext* ctx, void* tag, const std::shared_ptr<core::frame_factory>& frame_factory);
+
 std::shared_ptr<AVFrame> make_av_video_frame(const core::const_frame& frame, const core::video_format_desc& format_des);
 std::shared_ptr<AVFrame> make_av_audio_frame(const core::const_frame& frame, const core::video_format_desc& format_des);
 
@@ -0,0 +1,279 @@
+#include "keyframe_index.h"
+
+#include "av_assert.h"
+#include "av_util.h"
+
+#include <common/env.h>
+#include <common/executor.h>
+#include <common/log.h>
+#include <common/scope_exit.h>
+#include <common/utf.h>
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable : 4244)
+#endif
+extern "C" {
+#include <libavformat/avformat.h>
+}
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+namespace caspar { namespace ffmpeg {
+
+namespace fs = boost::filesystem;
+
+const keyframe_index::entry* keyframe_index::find(int64_t time) const
+{
+    auto it = std::upper_bound(
+        entries.begin(), entries.end(), time, [](int64_t lhs, const entry& rhs) { return lhs < rhs.time; });
+    return it != entries.begin() ? &*std::prev(it) : nullptr;
+}
+
+namespace {
+
+const std::string CACHE_HEADER = "casparcg-keyframe-index 1";
+
+struct cached_index
+{
+    std::uintmax_t                        size       = 0;
+    std::time_t                           last_write = 0;
+    std::shared_ptr<const keyframe_index> index; // nullptr if the file has no video.
+};
+
+class keyframe_indexer
+{
+    std::mutex                           mutex_;
+    std::map<std::wstring, cached_index> indexes_; // By path.
+    std::set<std::wstring>               pending_;
+
+    const fs::path    folder_ = fs::path(env::data_folder()) / L"media-index" / L"keyframes";
+    std::atomic<bool> abort_request_{false};
+    executor          executor_{L"keyframe-index"};
+
+  public:
+    ~keyframe_indexer()
+    {
+        abort_request_ = true;
+        executor_.clear();
+    }
+
+    std::shared_ptr<const keyframe_index> get(const std::wstring& path)
+    {
+        boost::system::error_code ec;
+        const auto                size       = fs::file_size(path, ec);
+        const auto                last_write = ec ? 0 : fs::last_write_time(path, ec);
+        if (ec) {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = indexes_.find(path);
+        if (it != indexes_.end() && it->second.size == size && it->second.last_write == last_write) {
+            return it->second.index;
+        }
+
+        if (pending_.insert(path).second) {
+            executor_.begin_invoke([=] { update(path, size, last_write); });
+        }
+
+        return nullptr;
+    }
+
+  private:
+    static int interrupt_cb(void* ctx)
+    {
+        return reinterpret_cast<keyframe_indexer*>(ctx)->abort_request_ ? 1 : 0;
+    }
+
+    void update(const std::wstring& path, std::uintmax_t size, std::time_t last_write)
+    {
+        if (abort_request_) {
+            return;
+        }
+
+        auto index = load(path, size, last_write);
+        if (!index) {
+            try {
+                index = build(path);
+                save(path, size, last_write, index);
+            } catch (...) {
+                if (abort_request_) {
+                    return;
+                }
+                CASPAR_LOG_CURRENT_EXCEPTION();
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        indexes_[path] = cached_index{size, last_write, std::move(index)};
+        pending_.erase(path);
+    }
+
+    fs::path cache_file(const std::wstring& path) const
+    {
+        std::wostringstream name;
+        name << std::hex << std::setw(16) << std::setfill(L'0') << std::hash<std::wstring>()(path) << L".idx";
+        return folder_ / name.str();
+    }
+
+    std::shared_ptr<const keyframe_index>
+    load(const std::wstring& path, std::uintmax_t size, std::time_t last_write) const
+    {
+        boost::filesystem::ifstream file(cache_file(path));
+        if (!file) {
+            return nullptr;
+        }
+
+        std::string line;
+        if (!std::getline(file, line) || line != CACHE_HEADER || !std::getline(file, line)) {
+            return nullptr;
+        }
+
+        try {
+            std::vector<std::string> fields;
+            boost::split(fields, line, boost::is_any_of("\t"));
+            if (fields.size() != 4 || u16(fields[0]) != path ||
+                boost::lexical_cast<std::uintmax_t>(fields[1]) != size ||
+                boost::lexical_cast<std::time_t>(fields[2]) != last_write) {
+                return nullptr;
+            }
+
+            auto index          = std::make_shared<keyframe_index>();
+            index->stream_index = boost::lexical_cast<int>(fields[3]);
+
+            while (std::getline(file, line)) {
+                boost::split(fields, line, boost::is_any_of("\t"));
+                if (fields.size() != 3) {
+                    return nullptr;
+                }
+                index->entries.push_back({boost::lexical_cast<int64_t>(fields[0]),
+                                          boost::lexical_cast<int64_t>(fields[1]),
+                                          boost::lexical_cast<int64_t>(fields[2])});
+            }
+
+            return index;
+        } catch (...) {
+            return nullptr;
+        }
+    }
+
+    void save(const std::wstring&                          path,
+              std::uintmax_t                               size,
+              std::time_t                                  last_write,
+              const std::shared_ptr<const keyframe_index>& index) const
+    {
+        if (!index) {
+            return;
+        }
+
+        boost::system::error_code ec;
+        fs::create_directories(folder_, ec);
+
+        auto file_path = cache_file(path);
+        auto tmp_file  = fs::path(file_path.wstring() + L".tmp");
+        {
+            boost::filesystem::ofstream file(tmp_file, std::ios::trunc);
+            if (!file) {
+                CASPAR_LOG(warning) << L"[keyframe_index] Unable to write " << tmp_file.wstring();
+                return;
+            }
+
+            file << CACHE_HEADER << "\n";
+            file << u8(path) << "\t" << size << "\t" << last_write << "\t" << index->stream_index << "\n";
+            for (auto& e : index->entries) {
+                file << e.time << "\t" << e.pts << "\t" << e.pos << "\n";
+            }
+        }
+
+        fs::rename(tmp_file, file_path, ec);
+        if (ec) {
+            CASPAR_LOG(warning) << L"[keyframe_index] Unable to write " << file_path.wstring();
+        }
+    }
+
+    // Reads every packet of the video stream without decoding anything.
+    std::shared_ptr<const keyframe_index> build(const std::wstring& path)
+    {
+        AVFormatContext* ic             = avformat_alloc_context();
+        ic->interrupt_callback.callback = interrupt_cb;
+        ic->interrupt_callback.opaque   = this;
+
+        FF(avformat_open_input(&ic, u8(path).c_str(), nullptr, nullptr));
+        auto ic2 = std::shared_ptr<AVFormatContext>(ic, [](AVFormatContext* ctx) { avformat_close_input(&ctx); });
+        FF(avformat_find_stream_info(ic2.get(), nullptr));
+
+        if ((ic2->iformat->flags & AVFMT_NOTIMESTAMPS) != 0) {
+            return nullptr;
+        }
+
+        const auto stream_index = av_find_best_stream(ic2.get(), AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (stream_index < 0) {
+            return nullptr;
+        }
+
+        for (auto n = 0U; n < ic2->nb_streams; ++n) {
+            ic2->streams[n]->discard = static_cast<int>(n) == stream_index ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+        }
+
+        const auto st = ic2->streams[stream_index];
+
+        auto index          = std::make_shared<keyframe_index>();
+        index->stream_index = stream_index;
+
+        auto packet = alloc_packet();
+        while (true) {
+            auto ret = av_read_frame(ic2.get(), packet.get());
+            if (ret == AVERROR_EOF) {
+                break;
+            }
+            FF_RET(ret, "av_read_frame");
+            CASPAR_SCOPE_EXIT { av_packet_unref(packet.get()); };
+
+            if (packet->stream_index != stream_index || (packet->flags & AV_PKT_FLAG_KEY) == 0) {
+                continue;
+            }
+
+            const auto pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+            if (pts != AV_NOPTS_VALUE) {
+                index->entries.push_back({av_rescale_q(pts, st->time_base, {1, AV_TIME_BASE}), pts, packet->pos});
+            }
+        }
+
+        std::stable_sort(index->entries.begin(), index->entries.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.time < rhs.time;
+        });
+
+        return index;
+    }
+};
+
+keyframe_indexer& indexer()
+{
+    static keyframe_indexer instance;
+    return instance;
+}
+
+} // namespace
+
+std::shared_ptr<const keyframe_index> get_keyframe_index(const std::wstring& path) { return indexer().get(path); }
+
+}} // namespace caspar::ffmpeg
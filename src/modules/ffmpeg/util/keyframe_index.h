@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace caspar { namespace ffmpeg {
+
+// The video keyframes of a file, in presentation order. Seeking to the last keyframe at or before a time lands on the
+// start of the GOP that holds it, so only the frames of that GOP have to be decoded.
+struct keyframe_index
+{
+    struct entry
+    {
+        int64_t time; // AV_TIME_BASE
+        int64_t pts;  // Stream time base.
+        int64_t pos;  // Byte position of the packet, -1 if unknown.
+    };
+
+    int                stream_index = -1;
+    std::vector<entry> entries;
+
+    // The last keyframe at or before time, nullptr if time precedes the first keyframe.
+    const entry* find(int64_t time) const;
+};
+
+// Returns the index of a local file, nullptr until it is available. A missing or outdated index is rebuilt in the
+// background and persisted in the media index folder, so that it is only built once per file.
+std::shared_ptr<const keyframe_index> get_keyframe_index(const std::wstring& path);
+
+}} // namespace caspar::ffmpeg
@@ -0,0 +1,191 @@
+#include "media_probe.h"
+
+#include "av_assert.h"
+#include "av_util.h"
+
+#include <common/scope_exit.h>
+#include <common/utf.h>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable : 4244)
+#endif
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libswscale/swscale.h>
+}
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+namespace caspar { namespace ffmpeg {
+
+namespace {
+
+const int THUMBNAIL_WIDTH = 256;
+
+std::shared_ptr<AVFormatContext> open_input(const std::wstring& path)
+{
+    AVFormatContext* ic = nullptr;
+    FF(avformat_open_input(&ic, u8(path).c_str(), nullptr, nullptr));
+    auto ic2 = std::shared_ptr<AVFormatContext>(ic, [](AVFormatContext* ctx) { avformat_close_input(&ctx); });
+    FF(avformat_find_stream_info(ic2.get(), nullptr));
+    return ic2;
+}
+
+bool is_still(const AVFormatContext* ic)
+{
+    std::string name = ic->iformat->name;
+    return (ic->iformat->flags & AVFMT_NOTIMESTAMPS) != 0 || name == "image2" || boost::ends_with(name, "_pipe");
+}
+
+} // namespace
+
+bool probe_media_info(const std::wstring& path, core::media_info& info)
+{
+    std::shared_ptr<AVFormatContext> ic;
+    try {
+        ic = open_input(path);
+    } catch (...) {
+        return false;
+    }
+
+    const AVStream* video = nullptr;
+    const AVStream* audio = nullptr;
+    for (unsigned int n = 0; n < ic->nb_streams; ++n) {
+        const auto st = ic->streams[n];
+        if ((st->disposition & AV_DISPOSITION_ATTACHED_PIC) != 0)
+            continue;
+        if (video == nullptr && st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+            video = st;
+        else if (audio == nullptr && st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO)
+            audio = st;
+    }
+
+    const auto duration = ic->duration != AV_NOPTS_VALUE ? ic->duration : 0;
+
+    if (video != nullptr) {
+        if (is_still(ic.get())) {
+            info.clip_type = L"STILL";
+            info.duration  = 0;
+            info.time_base = boost::rational<std::int64_t>(0, 1);
+            return true;
+        }
+
+        auto framerate = av_guess_frame_rate(ic.get(), const_cast<AVStream*>(video), nullptr);
+        if (framerate.num <= 0 || framerate.den <= 0)
+            framerate = {25, 1};
+
+        info.clip_type = L"MOVIE";
+        info.time_base = boost::rational<std::int64_t>(framerate.den, framerate.num);
+        info.duration  = video->duration != AV_NOPTS_VALUE
+                            ? av_rescale_q(video->duration, video->time_base, av_inv_q(framerate))
+                            : av_rescale_q(duration, AV_TIME_BASE_Q, av_inv_q(framerate));
+        return true;
+    }
+
+    if (audio != nullptr && audio->codecpar->sample_rate > 0) {
+        info.clip_type = L"AUDIO";
+        info.time_base = boost::rational<std::int64_t>(1, audio->codecpar->sample_rate);
+        info.duration  = av_rescale_q(duration, AV_TIME_BASE_Q, {1, audio->codecpar->sample_rate});
+        return true;
+    }
+
+    return false;
+}
+
+std::vector<std::uint8_t> generate_thumbnail(const std::wstring& path)
+{
+    auto ic = open_input(path);
+
+    AVCodec* decoder = nullptr;
+    auto     index   = av_find_best_stream(ic.get(), AVMEDIA_TYPE_VIDEO, -1, -1, &decoder, 0);
+    if (index < 0 || decoder == nullptr)
+        return {};
+
+    auto st = ic->streams[index];
+
+    auto dec = std::shared_ptr<AVCodecContext>(avcodec_alloc_context3(decoder),
+                                               [](AVCodecContext* ptr) { avcodec_free_context(&ptr); });
+    FF(avcodec_parameters_to_context(dec.get(), st->codecpar));
+    FF(avcodec_open2(dec.get(), decoder, nullptr));
+
+    // Skip past any fade in at the start of the clip.
+    if (!is_still(ic.get()) && ic->duration != AV_NOPTS_VALUE && ic->duration > 0)
+        av_seek_frame(ic.get(), -1, ic->duration / 10, AVSEEK_FLAG_BACKWARD);
+
+    auto packet = alloc_packet();
+    auto frame  = alloc_frame();
+
+    bool eof = false;
+    while (true) {
+        if (!eof) {
+            auto ret = av_read_frame(ic.get(), packet.get());
+            if (ret == AVERROR_EOF) {
+                eof = true;
+                FF(avcodec_send_packet(dec.get(), nullptr));
+            } else {
+                FF_RET(ret, "av_read_frame");
+                CASPAR_SCOPE_EXIT { av_packet_unref(packet.get()); };
+                if (packet->stream_index != index)
+                    continue;
+                FF(avcodec_send_packet(dec.get(), packet.get()));
+            }
+        }
+
+        auto ret = avcodec_receive_frame(dec.get(), frame.get());
+        if (ret == AVERROR(EAGAIN))
+            continue;
+        if (ret == AVERROR_EOF)
+            return {};
+        FF_RET(ret, "avcodec_receive_frame");
+        break;
+    }
+
+    const auto width  = THUMBNAIL_WIDTH;
+    const auto height = std::max(1, frame->height * THUMBNAIL_WIDTH / std::max(1, frame->width));
+
+    auto sws = std::shared_ptr<SwsContext>(sws_getContext(frame->width,
+                                                          frame->height,
+                                                          static_cast<AVPixelFormat>(frame->format),
+                                                          width,
+                                                          height,
+                                                          AV_PIX_FMT_RGB24,
+                                                          SWS_BICUBIC,
+                                                          nullptr,
+                                                          nullptr,
+                                                          nullptr),
+                                           [](SwsContext* ptr) { sws_freeContext(ptr); });
+    if (!sws)
+        return {};
+
+    auto rgb    = alloc_frame();
+    rgb->width  = width;
+    rgb->height = height;
+    rgb->format = AV_PIX_FMT_RGB24;
+    FF(av_frame_get_buffer(rgb.get(), 32));
+    sws_scale(sws.get(), frame->data, frame->linesize, 0, frame->height, rgb->data, rgb->linesize);
+
+    auto encoder = avcodec_find_encoder(AV_CODEC_ID_PNG);
+    if (encoder == nullptr)
+        return {};
+
+    auto enc = std::shared_ptr<AVCodecContext>(avcodec_alloc_context3(encoder),
+                                               [](AVCodecContext* ptr) { avcodec_free_context(&ptr); });
+    enc->width     = width;
+    enc->height    = height;
+    enc->pix_fmt   = AV_PIX_FMT_RGB24;
+    enc->time_base = {1, 25};
+    FF(avcodec_open2(enc.get(), encoder, nullptr));
+
+    FF(avcodec_send_frame(enc.get(), rgb.get()));
+    FF(avcodec_receive_packet(enc.get(), packet.get()));
+    CASPAR_SCOPE_EXIT { av_packet_unref(packet.get()); };
+
+    return std::vector<std::uint8_t>(packet->data, packet->data + packet->size);
+}
+
+}} // namespace caspar::ffmpeg
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <core/producer/media_info/media_info.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace caspar { namespace ffmpeg {
+
+bool                      probe_media_info(const std::wstring& path, core::media_info& info);
+std::vector<std::uint8_t> generate_thumbnail(const std::wstring& path);
+
+}} // namespace caspar::ffmpeg
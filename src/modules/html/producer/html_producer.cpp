@@ -59,8 +59,10 @@
 #include <include/cef_render_handler.h>
 #pragma warning(pop)
 
+#include <algorithm>
 #include <queue>
 #include <utility>
+#include <vector>
 
 #include "../html.h"
 
@@ -101,6 +103,8 @@ class html_client
     core::draw_frame   last_frame_;
     mutable std::mutex last_frame_mutex_;
 
+    core::const_frame painted_frame_; // The last painted frame, only used on the UI thread.
+
     CefRefPtr<CefBrowser> browser_;
 
 #ifdef WIN32
@@ -241,15 +245,37 @@ class html_client
         pixel_desc.format = core::pixel_format::bgra;
         pixel_desc.planes.push_back(core::pixel_format_desc::plane(width, height, 4));
 
-        auto frame = frame_factory_->create_frame(this, pixel_desc);
-        auto src   = (char*)buffer;
-        auto dst   = reinterpret_cast<char*>(frame.image_data(0).begin());
-        std::memcpy(dst, src, width * height * 4);
+        std::vector<core::frame_region> regions;
+        int64_t                         dirty_area = 0;
+        for (auto& rect : dirtyRects) {
+            core::frame_region region;
+            region.x      = std::max(0, rect.x);
+            region.y      = std::max(0, rect.y);
+            region.width  = std::min(rect.x + rect.width, width) - region.x;
+            region.height = std::min(rect.y + rect.height, height) - region.y;
+            if (region.width > 0 && region.height > 0) {
+                regions.push_back(region);
+                dirty_area += static_cast<int64_t>(region.width) * region.height;
+            }
+        }
+
+        // Small updates, e.g. of lower thirds and tickers, only upload the dirty rectangles on top of the previous
+        // frame.
+        auto partial = painted_frame_ && static_cast<int>(painted_frame_.width()) == width &&
+                       static_cast<int>(painted_frame_.height()) == height &&
+                       dirty_area * 2 < static_cast<int64_t>(width) * height;
+
+        if (!partial || !regions.empty()) {
+            auto frame = partial ? frame_factory_->create_frame(this, pixel_desc, painted_frame_, regions)
+                                 : frame_factory_->create_frame(this, pixel_desc);
+            std::memcpy(frame.image_data(0).begin(), buffer, width * height * 4);
+            painted_frame_ = core::const_frame(std::move(frame));
+        }
 
         {
             std::lock_guard<std::mutex> lock(frames_mutex_);
 
-            frames_.push(core::draw_frame(std::move(frame)));
+            frames_.push(core::draw_frame(painted_frame_));
             while (frames_.size() > 8) {
                 frames_.pop();
                 graph_->set_tag(diagnostics::tag_severity::WARNING, "dropped-frame");
@@ -63,6 +63,7 @@
 #include "consumer_screen_fragment.h"
 #include "consumer_screen_vertex.h"
 #include <accelerator/ogl/util/shader.h>
+#include <accelerator/ogl/util/texture.h>
 
 namespace caspar { namespace screen {
 
@@ -119,6 +120,9 @@ struct frame
     GLuint tex   = 0;
     char*  ptr   = nullptr;
     GLsync fence = nullptr;
+
+    // The mixer's target, drawn instead of tex when the frame was left on the GPU.
+    std::shared_ptr<accelerator::ogl::texture> texture;
 };
 
 struct screen_consumer
@@ -148,6 +152,7 @@ struct screen_consumer
     std::unique_ptr<accelerator::ogl::shader> shader_;
     GLuint                                    vao_;
     GLuint                                    vbo_;
+    GLuint                                    sampler_;
 
     std::atomic<bool> is_running_{true};
     std::thread       thread_;
@@ -281,26 +286,24 @@ struct screen_consumer
                         reinterpret_cast<char*>(GL2(glMapNamedBufferRange(frame.pbo, 0, format_desc_.size, flags)));
 
                     GL(glCreateTextures(GL_TEXTURE_2D, 1, &frame.tex));
-                    GL(glTextureParameteri(frame.tex,
-                                           GL_TEXTURE_MIN_FILTER,
-                                           (config_.colour_space == configuration::colour_spaces::datavideo_full ||
-                                            config_.colour_space == configuration::colour_spaces::datavideo_limited)
-                                               ? GL_NEAREST
-                                               : GL_LINEAR));
-                    GL(glTextureParameteri(frame.tex,
-                                           GL_TEXTURE_MAG_FILTER,
-                                           (config_.colour_space == configuration::colour_spaces::datavideo_full ||
-                                            config_.colour_space == configuration::colour_spaces::datavideo_limited)
-                                               ? GL_NEAREST
-                                               : GL_LINEAR));
-                    GL(glTextureParameteri(frame.tex, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
-                    GL(glTextureParameteri(frame.tex, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
                     GL(glTextureStorage2D(frame.tex, 1, GL_RGBA8, format_desc_.width, format_desc_.height));
                     GL(glClearTexImage(frame.tex, 0, GL_BGRA, GL_UNSIGNED_BYTE, nullptr));
 
                     frames_.push_back(frame);
                 }
 
+                // The sampling of the mixer's textures can't be changed, they are shared with the device.
+                const auto filter = (config_.colour_space == configuration::colour_spaces::datavideo_full ||
+                                     config_.colour_space == configuration::colour_spaces::datavideo_limited)
+                                        ? GL_NEAREST
+                                        : GL_LINEAR;
+                GL(glCreateSamplers(1, &sampler_));
+                GL(glSamplerParameteri(sampler_, GL_TEXTURE_MIN_FILTER, filter));
+                GL(glSamplerParameteri(sampler_, GL_TEXTURE_MAG_FILTER, filter));
+                GL(glSamplerParameteri(sampler_, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+                GL(glSamplerParameteri(sampler_, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+                GL(glBindSampler(0, sampler_));
+
                 GL(glDisable(GL_DEPTH_TEST));
                 GL(glClearColor(0.0, 0.0, 0.0, 0.0));
                 GL(glViewport(
@@ -334,9 +337,14 @@ struct screen_consumer
                 GL(glUnmapNamedBuffer(frame.pbo));
                 glDeleteBuffers(1, &frame.pbo);
                 glDeleteTextures(1, &frame.tex);
+                if (frame.fence != nullptr) {
+                    glDeleteSync(frame.fence);
+                }
             }
+            frames_.clear();
 
             shader_.reset();
+            glDeleteSamplers(1, &sampler_);
             GL(glDeleteVertexArrays(1, &vao_));
             GL(glDeleteBuffers(1, &vbo_));
 
@@ -366,6 +374,20 @@ struct screen_consumer
         return count > 0;
     }
 
+    // Blocks until the fence is signaled, handling window events in the meantime.
+    void wait(GLsync& fence)
+    {
+        while (fence != nullptr) {
+            auto wait = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 2000000);
+            if (wait == GL_ALREADY_SIGNALED || wait == GL_CONDITION_SATISFIED || wait == GL_WAIT_FAILED) {
+                glDeleteSync(fence);
+                fence = nullptr;
+            } else {
+                poll();
+            }
+        }
+    }
+
     void tick()
     {
         core::const_frame in_frame;
@@ -385,26 +407,24 @@ struct screen_consumer
         {
             auto& frame = frames_.front();
 
-            while (frame.fence != nullptr) {
-                auto wait = glClientWaitSync(frame.fence, 0, 0);
-                if (wait == GL_ALREADY_SIGNALED || wait == GL_CONDITION_SATISFIED) {
-                    glDeleteSync(frame.fence);
-                    frame.fence = nullptr;
-                }
-                if (!poll()) {
-                    // TODO (fix)
-                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
-                }
-            }
+            wait(frame.fence);
+            frame.texture = nullptr;
 
-            std::memcpy(frame.ptr, in_frame.image_data(0).begin(), format_desc_.size);
+            // The window's context shares objects with the contexts of the device, so a frame that the mixer left on
+            // the GPU is drawn from its target without a round trip through memory.
+            auto texture = in_frame.image_data(0).storage<std::shared_ptr<accelerator::ogl::texture>>();
+            if (texture != nullptr) {
+                frame.texture = *texture;
+            } else {
+                std::memcpy(frame.ptr, in_frame.image_data(0).begin(), format_desc_.size);
 
-            GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, frame.pbo));
-            GL(glTextureSubImage2D(
-                frame.tex, 0, 0, 0, format_desc_.width, format_desc_.height, GL_BGRA, GL_UNSIGNED_BYTE, nullptr));
-            GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+                GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, frame.pbo));
+                GL(glTextureSubImage2D(
+                    frame.tex, 0, 0, 0, format_desc_.width, format_desc_.height, GL_BGRA, GL_UNSIGNED_BYTE, nullptr));
+                GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
 
-            frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            }
         }
 
         // Display
@@ -413,8 +433,13 @@ struct screen_consumer
 
             GL(glClear(GL_COLOR_BUFFER_BIT));
 
-            GL(glActiveTexture(GL_TEXTURE0));
-            GL(glBindTexture(GL_TEXTURE_2D, frame.tex));
+            if (frame.texture) {
+                // Waits on the GPU for the mixer to finish drawing the texture.
+                frame.texture->bind(0);
+            } else {
+                GL(glActiveTexture(GL_TEXTURE0));
+                GL(glBindTexture(GL_TEXTURE_2D, frame.tex));
+            }
 
             GL(glBufferData(GL_ARRAY_BUFFER,
                             static_cast<GLsizeiptr>(sizeof(core::frame_geometry::coord)) * draw_coords_.size(),
@@ -453,6 +478,11 @@ struct screen_consumer
             GL(glDisableVertexAttribArray(tex_loc));
 
             GL(glBindTexture(GL_TEXTURE_2D, 0));
+
+            if (frame.texture) {
+                // The texture goes back to the device's pool once it's no longer read.
+                frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            }
         }
 
         window_.display();
@@ -592,6 +622,8 @@ struct screen_consumer_proxy : public core::frame_consumer
 
     bool has_synchronization_clock() const override { return false; }
 
+    bool needs_image_data() const override { return false; }
+
     int index() const override { return 600 + (config_.key_only ? 10 : 0) + config_.screen_index; }
 };
 
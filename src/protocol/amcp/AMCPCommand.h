@@ -26,6 +26,7 @@
 #include <accelerator/accelerator.h>
 #include <core/consumer/frame_consumer.h>
 #include <core/producer/frame_producer.h>
+#include <core/producer/media_info/media_index.h>
 
 #include <boost/algorithm/string.hpp>
 
@@ -43,8 +44,7 @@ struct command_context
     spl::shared_ptr<const core::frame_consumer_registry> consumer_registry;
     std::function<void(bool)>                            shutdown_server_now;
     std::vector<std::wstring>                            parameters;
-    std::string                                          proxy_host;
-    std::string                                          proxy_port;
+    spl::shared_ptr<core::media_index>                   media_index;
     std::weak_ptr<accelerator::accelerator_device>       ogl_device;
 
     int layer_index(int default_ = 0) const { return layer_id == -1 ? default_ : layer_id; }
@@ -58,8 +58,7 @@ struct command_context
                     spl::shared_ptr<const core::frame_producer_registry> producer_registry,
                     spl::shared_ptr<const core::frame_consumer_registry> consumer_registry,
                     std::function<void(bool)>                            shutdown_server_now,
-                    std::string                                          proxy_host,
-                    std::string                                          proxy_port,
+                    spl::shared_ptr<core::media_index>                   media_index,
                     std::weak_ptr<accelerator::accelerator_device>       ogl_device)
         : client(std::move(client))
         , channel(channel)
@@ -70,8 +69,7 @@ struct command_context
         , producer_registry(std::move(producer_registry))
         , consumer_registry(std::move(consumer_registry))
         , shutdown_server_now(shutdown_server_now)
-        , proxy_host(std::move(proxy_host))
-        , proxy_port(std::move(proxy_port))
+        , media_index(std::move(media_index))
         , ogl_device(std::move(ogl_device))
     {
     }
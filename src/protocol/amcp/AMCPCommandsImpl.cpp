@@ -27,7 +27,6 @@
 
 #include "AMCPCommandsImpl.h"
 
-#include "../util/http_request.h"
 #include "AMCPCommandQueue.h"
 #include "amcp_command_repository.h"
 
@@ -46,6 +45,7 @@
 #include <core/mixer/mixer.h>
 #include <core/producer/cg_proxy.h>
 #include <core/producer/frame_producer.h>
+#include <core/producer/media_info/media_index.h>
 #include <core/producer/stage.h>
 #include <core/producer/transition/sting_producer.h>
 #include <core/producer/transition/transition_producer.h>
@@ -60,6 +60,7 @@
 #include <boost/algorithm/string/regex.hpp>
 #include <boost/archive/iterators/base64_from_binary.hpp>
 #include <boost/archive/iterators/insert_linebreaks.hpp>
+#include <boost/date_time/c_local_time_adjustor.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
@@ -214,17 +215,33 @@ core::frame_producer_dependencies get_producer_dependencies(const std::shared_pt
                                              ctx.cg_registry);
 }
 
+// Clips known to the media index and URLs are opened asynchronously. Anything else is resolved on the command thread
+// so that LOADBG still answers 404 for what no producer can be created for.
+bool can_load_async(const command_context& ctx)
+{
+    const auto& name = ctx.parameters.at(0);
+    if (boost::contains(name, L"://"))
+        return true;
+
+    return !ctx.media_index->media(name).empty() ||
+           !ctx.media_index->media(boost::filesystem::path(name).replace_extension().wstring()).empty();
+}
+
 // Basic Commands
 
-std::wstring loadbg_command(command_context& ctx)
+spl::shared_ptr<frame_producer> load_background(command_context& ctx)
 {
     // Perform loading of the clip
     core::diagnostics::scoped_call_context save;
     core::diagnostics::call_context::for_thread().video_channel = ctx.channel_index + 1;
     core::diagnostics::call_context::for_thread().layer         = ctx.layer_index();
 
-    auto channel = ctx.channel.channel;
-    auto pFP     = ctx.producer_registry->create_producer(get_producer_dependencies(channel, ctx), ctx.parameters);
+    // Clips are opened on a loader thread so that slow inputs do not hold up the command queue. PLAY waits for them to
+    // be ready and reports any error.
+    auto channel      = ctx.channel.channel;
+    auto dependencies = get_producer_dependencies(channel, ctx);
+    auto pFP          = can_load_async(ctx) ? ctx.producer_registry->create_producer_async(dependencies, ctx.parameters)
+                                            : ctx.producer_registry->create_producer(dependencies, ctx.parameters);
 
     if (pFP == frame_producer::empty())
         CASPAR_THROW_EXCEPTION(file_not_found() << msg_info(ctx.parameters.size() > 0 ? ctx.parameters[0] : L""));
@@ -249,6 +266,13 @@ std::wstring loadbg_command(command_context& ctx)
 
     channel->stage().load(ctx.layer_index(), transition_producer, false, auto_play); // TODO: LOOP
 
+    return transition_producer;
+}
+
+std::wstring loadbg_command(command_context& ctx)
+{
+    load_background(ctx);
+
     return L"202 LOADBG OK\r\n";
 }
 
@@ -268,8 +292,16 @@ std::wstring load_command(command_context& ctx)
 
 std::wstring play_command(command_context& ctx)
 {
+    // A background that failed to load is dropped by the layer, wait on the loaded producer itself so that its error
+    // is reported.
+    std::shared_ptr<frame_producer> background;
     if (!ctx.parameters.empty())
-        loadbg_command(ctx);
+        background = load_background(ctx);
+    else
+        background = ctx.channel.channel->stage().background(ctx.layer_index()).get();
+
+    if (background)
+        background->wait_until_ready();
 
     ctx.channel.channel->stage().play(ctx.layer_index());
 
@@ -420,6 +452,15 @@ std::wstring set_command(command_context& ctx)
         CASPAR_THROW_EXCEPTION(user_error() << msg_info(L"Invalid video mode"));
     }
 
+    if (name == L"OFFLINE") {
+        if (value != L"0" && value != L"1") {
+            CASPAR_THROW_EXCEPTION(user_error() << msg_info(L"Invalid offline value, expected 0 or 1"));
+        }
+
+        ctx.channel.channel->offline(value == L"1");
+        return L"202 SET OFFLINE OK\r\n";
+    }
+
     CASPAR_THROW_EXCEPTION(user_error() << msg_info(L"Invalid channel variable"));
 }
 
@@ -1233,50 +1274,133 @@ std::wstring channel_grid_command(command_context& ctx)
 
 // Thumbnail Commands
 
-std::wstring make_request(command_context& ctx, const std::string& path, const std::wstring& default_response)
+std::wstring local_iso_time(std::time_t time)
 {
-    auto res = http::request(ctx.proxy_host, ctx.proxy_port, path);
-    if (res.status_code >= 500 || res.body.size() == 0) {
-        CASPAR_LOG(error) << "Failed to connect to media-scanner. Is it running? \nReason: " << res.status_message;
-        return default_response;
-    }
-    return u16(res.body);
+    using boost::posix_time::ptime;
+
+    auto local = boost::date_time::c_local_adjustor<ptime>::utc_to_local(boost::posix_time::from_time_t(time));
+    return u16(boost::posix_time::to_iso_string(local));
 }
 
 std::wstring thumbnail_list_command(command_context& ctx)
 {
-    return make_request(ctx, "/thumbnail", L"501 THUMBNAIL LIST FAILED\r\n");
+    std::wstringstream replyString;
+    replyString << L"200 THUMBNAIL LIST OK\r\n";
+
+    for (auto& thumbnail : ctx.media_index->thumbnails()) {
+        replyString << L"\"" << thumbnail.id << L"\" " << local_iso_time(thumbnail.last_write) << L" "
+                    << thumbnail.size << L"\r\n";
+    }
+
+    replyString << L"\r\n";
+    return replyString.str();
 }
 
 std::wstring thumbnail_retrieve_command(command_context& ctx)
 {
-    return make_request(
-        ctx, "/thumbnail/" + http::url_encode(u8(ctx.parameters.at(0))), L"501 THUMBNAIL RETRIEVE FAILED\r\n");
+    auto png = ctx.media_index->thumbnail(ctx.parameters.at(0));
+
+    if (png.empty())
+        CASPAR_THROW_EXCEPTION(file_not_found() << msg_info(ctx.parameters.at(0) + L" not found"));
+
+    std::wstringstream replyString;
+    replyString << L"201 THUMBNAIL RETRIEVE OK\r\n";
+    replyString << u16(to_base64(reinterpret_cast<const char*>(png.data()), png.size()));
+    replyString << L"\r\n";
+    return replyString.str();
 }
 
 std::wstring thumbnail_generate_command(command_context& ctx)
 {
-    return make_request(
-        ctx, "/thumbnail/generate/" + http::url_encode(u8(ctx.parameters.at(0))), L"501 THUMBNAIL GENERATE FAILED\r\n");
+    if (!ctx.media_index->generate_thumbnail(ctx.parameters.at(0)))
+        CASPAR_THROW_EXCEPTION(file_not_found() << msg_info(ctx.parameters.at(0) + L" not found"));
+
+    return L"202 THUMBNAIL GENERATE OK\r\n";
 }
 
 std::wstring thumbnail_generateall_command(command_context& ctx)
 {
-    return make_request(ctx, "/thumbnail/generate", L"501 THUMBNAIL GENERATE_ALL FAILED\r\n");
+    ctx.media_index->generate_all_thumbnails();
+
+    return L"202 THUMBNAIL GENERATE_ALL OK\r\n";
 }
 
 // Query Commands
 
+std::wstring cinf_line(const core::media_index::entry& media)
+{
+    auto time = local_iso_time(media.last_write);
+    boost::erase_all(time, L"T");
+
+    std::wstringstream line;
+    line << L"\"" << media.id << L"\"  " << media.info.clip_type << L"  " << media.size << L" " << time << L" "
+         << media.info.duration << L" " << media.info.time_base.numerator() << L"/"
+         << media.info.time_base.denominator() << L"\r\n";
+    return line.str();
+}
+
+std::wstring file_line(const core::media_index::entry& file)
+{
+    auto time = local_iso_time(file.last_write);
+    boost::erase_all(time, L"T");
+
+    std::wstringstream line;
+    line << L"\"" << file.id << L"\" " << file.size << L" " << time << L"\r\n";
+    return line.str();
+}
+
 std::wstring cinf_command(command_context& ctx)
 {
-    return make_request(ctx, "/cinf/" + http::url_encode(u8(ctx.parameters.at(0))), L"501 CINF FAILED\r\n");
+    auto media = ctx.media_index->media(ctx.parameters.at(0));
+
+    if (media.empty())
+        CASPAR_THROW_EXCEPTION(file_not_found() << msg_info(ctx.parameters.at(0) + L" not found"));
+
+    std::wstringstream replyString;
+    replyString << L"200 CINF OK\r\n";
+
+    for (auto& entry : media)
+        replyString << cinf_line(entry);
+
+    replyString << L"\r\n";
+    return replyString.str();
 }
 
-std::wstring cls_command(command_context& ctx) { return make_request(ctx, "/cls", L"501 CLS FAILED\r\n"); }
+std::wstring cls_command(command_context& ctx)
+{
+    std::wstringstream replyString;
+    replyString << L"200 CLS OK\r\n";
 
-std::wstring fls_command(command_context& ctx) { return make_request(ctx, "/fls", L"501 FLS FAILED\r\n"); }
+    for (auto& media : ctx.media_index->media())
+        replyString << cinf_line(media);
 
-std::wstring tls_command(command_context& ctx) { return make_request(ctx, "/tls", L"501 TLS FAILED\r\n"); }
+    replyString << L"\r\n";
+    return replyString.str();
+}
+
+std::wstring fls_command(command_context& ctx)
+{
+    std::wstringstream replyString;
+    replyString << L"200 FLS OK\r\n";
+
+    for (auto& font : ctx.media_index->fonts())
+        replyString << file_line(font);
+
+    replyString << L"\r\n";
+    return replyString.str();
+}
+
+std::wstring tls_command(command_context& ctx)
+{
+    std::wstringstream replyString;
+    replyString << L"200 TLS OK\r\n";
+
+    for (auto& tmpl : ctx.media_index->templates())
+        replyString << file_line(tmpl);
+
+    replyString << L"\r\n";
+    return replyString.str();
+}
 
 std::wstring version_command(command_context& ctx) { return L"201 VERSION OK\r\n" + env::version() + L"\r\n"; }
 
@@ -1317,13 +1441,21 @@ std::wstring info_channel_command(command_context& ctx)
     pt::wptree channel_info;
 
     auto state = ctx.channel.channel->state();
+
+    // The state is ordered by path id, sort it so that the reply is stable.
+    std::vector<std::pair<const std::string*, const core::monitor::vector_t*>> entries;
     for (const auto& p : state) {
-        const auto replaced = boost::algorithm::replace_all_copy(p.first, "/", ".");
+        entries.emplace_back(&p.first.str(), &p.second);
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) { return *lhs.first < *rhs.first; });
+
+    for (const auto& p : entries) {
+        const auto replaced = boost::algorithm::replace_all_copy(*p.first, "/", ".");
         // avoid digit-only nodes in XML
         const auto path = boost::algorithm::replace_all_regex_copy(
             replaced, boost::regex("\\.(.*?)\\.([0-9]*?)\\."), std::string(".$1.$1_$2."));
         param_visitor param_visitor(path, channel_info);
-        for (const auto& element : p.second) {
+        for (const auto& element : *p.second) {
             boost::apply_visitor(param_visitor, element);
         }
     }
@@ -1375,6 +1507,7 @@ std::wstring info_paths_command(command_context& ctx)
     info.add(L"paths.log-path", caspar::env::log_folder());
     info.add(L"paths.data-path", caspar::env::data_folder());
     info.add(L"paths.template-path", caspar::env::template_folder());
+    info.add(L"paths.font-path", caspar::env::font_folder());
     info.add(L"paths.initial-path", caspar::env::initial_folder() + L"/");
 
     std::wstringstream replyString;
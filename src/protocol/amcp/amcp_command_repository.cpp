@@ -69,9 +69,8 @@ struct amcp_command_repository::impl
     spl::shared_ptr<const core::frame_producer_registry> producer_registry;
     spl::shared_ptr<const core::frame_consumer_registry> consumer_registry;
     std::weak_ptr<accelerator::accelerator_device>       ogl_device;
+    spl::shared_ptr<core::media_index>                   media_index;
     std::function<void(bool)>                            shutdown_server_now;
-    std::string proxy_host = u8(caspar::env::properties().get(L"configuration.amcp.media-server.host", L"127.0.0.1"));
-    std::string proxy_port = u8(caspar::env::properties().get(L"configuration.amcp.media-server.port", L"8000"));
 
     std::map<std::wstring, std::pair<amcp_command_func, int>> commands;
     std::map<std::wstring, std::pair<amcp_command_func, int>> channel_commands;
@@ -80,11 +79,13 @@ struct amcp_command_repository::impl
          const spl::shared_ptr<const core::frame_producer_registry>& producer_registry,
          const spl::shared_ptr<const core::frame_consumer_registry>& consumer_registry,
          const std::weak_ptr<accelerator::accelerator_device>&       ogl_device,
+         const spl::shared_ptr<core::media_index>&                   media_index,
          std::function<void(bool)>                                   shutdown_server_now)
         : cg_registry(cg_registry)
         , producer_registry(producer_registry)
         , consumer_registry(consumer_registry)
         , ogl_device(ogl_device)
+        , media_index(media_index)
         , shutdown_server_now(shutdown_server_now)
     {
     }
@@ -105,8 +106,9 @@ amcp_command_repository::amcp_command_repository(
     const spl::shared_ptr<const core::frame_producer_registry>& producer_registry,
     const spl::shared_ptr<const core::frame_consumer_registry>& consumer_registry,
     const std::weak_ptr<accelerator::accelerator_device>&       ogl_device,
+    const spl::shared_ptr<core::media_index>&                   media_index,
     std::function<void(bool)>                                   shutdown_server_now)
-    : impl_(new impl(cg_registry, producer_registry, consumer_registry, ogl_device, shutdown_server_now))
+    : impl_(new impl(cg_registry, producer_registry, consumer_registry, ogl_device, media_index, shutdown_server_now))
 {
 }
 
@@ -130,8 +132,7 @@ AMCPCommand::ptr_type amcp_command_repository::create_command(const std::wstring
                         self.producer_registry,
                         self.consumer_registry,
                         self.shutdown_server_now,
-                        self.proxy_host,
-                        self.proxy_port,
+                        self.media_index,
                         self.ogl_device);
 
     auto command = find_command(self.commands, s, ctx, tokens);
@@ -163,8 +164,7 @@ AMCPCommand::ptr_type amcp_command_repository::create_channel_command(const std:
                         self.producer_registry,
                         self.consumer_registry,
                         self.shutdown_server_now,
-                        self.proxy_host,
-                        self.proxy_port,
+                        self.media_index,
                         self.ogl_device);
 
     auto command = find_command(self.channel_commands, s, ctx, tokens);
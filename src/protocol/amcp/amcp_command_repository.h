@@ -39,6 +39,7 @@ class amcp_command_repository
                             const spl::shared_ptr<const core::frame_producer_registry>& producer_registry,
                             const spl::shared_ptr<const core::frame_consumer_registry>& consumer_registry,
                             const std::weak_ptr<accelerator::accelerator_device>&       ogl_device,
+                            const spl::shared_ptr<core::media_index>&                   media_index,
                             std::function<void(bool)>                                   shutdown_server_now);
 
     void init(const std::vector<spl::shared_ptr<core::video_channel>>& channels);
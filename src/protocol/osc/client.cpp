@@ -34,9 +34,13 @@
 #include <boost/asio.hpp>
 #include <boost/optional.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 using namespace boost::asio::ip;
@@ -66,18 +70,45 @@ struct param_visitor : public boost::static_visitor<void>
 
 struct client::impl : public spl::enable_shared_from_this<client::impl>
 {
+    using clock     = std::chrono::steady_clock;
+    using message_t = std::pair<core::monitor::path, const core::monitor::vector_t*>;
+
+    // Drop the oldest states rather than letting the queue grow when the sender can not keep up.
+    static const size_t MAX_PENDING_BUNDLES = 64;
+
+    struct delta_entry
+    {
+        explicit delta_entry(core::monitor::vector_t value)
+            : value(std::move(value))
+        {
+        }
+
+        core::monitor::vector_t value;
+        clock::time_point       last_sent;
+        bool                    dirty  = false;
+        bool                    seen   = true;
+        bool                    queued = false; // Part of the messages sent by the current pass.
+    };
+
     std::shared_ptr<boost::asio::io_context> service_;
     udp::socket                              socket_;
     std::map<udp::endpoint, int>             reference_counts_by_endpoint_;
     std::vector<char>                        buffer_;
 
-    std::mutex              mutex_;
-    std::condition_variable cond_;
-    core::monitor::state    bundle_;
-    uint64_t                bundle_time_ = 0;
+    std::mutex                                            mutex_;
+    std::condition_variable                               cond_;
+    std::deque<std::pair<uint64_t, core::monitor::state>> bundles_;
+    delta_options                                         delta_;
 
     uint64_t time_ = 0;
 
+    // Only accessed from the sender thread.
+    std::unordered_map<core::monitor::path, delta_entry> sent_;
+    std::vector<core::monitor::path>                     dirty_;
+    clock::time_point                                    next_keyframe_;
+    std::vector<udp::endpoint>                           last_endpoints_;
+    uint64_t                                             last_bundle_time_ = 0;
+
     std::atomic<bool> abort_request_{false};
     std::thread       thread_;
 
@@ -89,73 +120,206 @@ struct client::impl : public spl::enable_shared_from_this<client::impl>
     {
         thread_ = std::thread([=] {
             try {
-                while (!abort_request_) {
-                    core::monitor::state       bundle;
-                    uint64_t                   bundle_time;
-                    std::vector<udp::endpoint> endpoints;
-
-                    {
-                        std::unique_lock<std::mutex> lock(mutex_);
-                        cond_.wait(lock, [&] { return bundle_time_ > 0 || abort_request_; });
-
-                        if (abort_request_) {
-                            return;
-                        }
-
-                        bundle       = std::move(bundle_);
-                        bundle_time  = bundle_time_;
-                        bundle_time_ = 0;
-
-                        for (auto& p : reference_counts_by_endpoint_) {
-                            endpoints.push_back(p.first);
-                        }
-                    }
+                run();
+            } catch (...) {
+                CASPAR_LOG_CURRENT_EXCEPTION();
+            }
+        });
+    }
+
+    ~impl()
+    {
+        abort_request_ = true;
+        cond_.notify_all();
+        thread_.join();
+    }
 
-                    if (endpoints.empty()) {
-                        continue;
+    void run()
+    {
+        while (!abort_request_) {
+            std::deque<std::pair<uint64_t, core::monitor::state>> bundles;
+            std::vector<udp::endpoint>                            endpoints;
+            delta_options                                         delta;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+
+                auto ready = [&] { return !bundles_.empty() || abort_request_; };
+
+                if (!delta_.enabled) {
+                    cond_.wait(lock, ready);
+                } else {
+                    // Wake up for deferred changes and keyframes even when no new state arrives.
+                    auto deadline = next_keyframe_;
+                    if (!dirty_.empty())
+                        deadline = std::min(deadline, clock::now() + delta_.min_send_interval);
+                    cond_.wait_until(lock, deadline, ready);
+                }
+
+                if (abort_request_) {
+                    return;
+                }
+
+                bundles = std::move(bundles_);
+                bundles_.clear();
+                delta = delta_;
+
+                for (auto& p : reference_counts_by_endpoint_) {
+                    endpoints.push_back(p.first);
+                }
+            }
+
+            if (!delta.enabled) {
+                sent_.clear();
+                dirty_.clear();
+
+                if (endpoints.empty()) {
+                    continue;
+                }
+
+                for (const auto& bundle : bundles) {
+                    std::vector<message_t> messages;
+                    for (const auto& p : bundle.second) {
+                        messages.emplace_back(p.first, &p.second);
                     }
+                    send_messages(messages, bundle.first, endpoints);
+                }
+            } else {
+                send_delta(bundles, endpoints, delta);
+            }
+        }
+    }
 
-                    auto it = std::begin(bundle);
+    void send_delta(const std::deque<std::pair<uint64_t, core::monitor::state>>& bundles,
+                    const std::vector<udp::endpoint>&                            endpoints,
+                    const delta_options&                                         delta)
+    {
+        const auto now = clock::now();
 
-                    while (it != std::end(bundle)) {
-                        ::osc::OutboundPacketStream o(reinterpret_cast<char*>(buffer_.data()),
-                                                      static_cast<unsigned long>(buffer_.size()));
+        std::vector<message_t> messages;
 
-                        o << ::osc::BeginBundle(bundle_time);
+        for (const auto& bundle : bundles) {
+            last_bundle_time_ = bundle.first;
 
-                        // TODO (fix): < 2048 is a hack. Properly calculate if messages will fit.
-                        while (it != std::end(bundle) && o.Size() < 2048) {
-                            o << ::osc::BeginMessage(it->first.c_str());
+            for (const auto& p : bundle.second) {
+                auto it = sent_.find(p.first);
+                if (it == sent_.end()) {
+                    it                   = sent_.emplace(p.first, delta_entry(p.second)).first;
+                    it->second.last_sent = now;
+                    it->second.queued    = true;
+                    messages.emplace_back(it->first, &it->second.value);
+                    continue;
+                }
 
-                            param_visitor<decltype(o)> param_visitor(o);
-                            for (const auto& element : it->second) {
-                                boost::apply_visitor(param_visitor, element);
-                            }
+                auto& entry = it->second;
+                entry.seen  = true;
 
-                            o << ::osc::EndMessage;
+                if (entry.value == p.second) {
+                    continue;
+                }
 
-                            ++it;
-                        }
+                entry.value = p.second;
 
-                        o << ::osc::EndBundle;
+                if (entry.queued || entry.dirty) {
+                    // Already queued in this pass or waiting for its interval, the latest value will be sent.
+                    continue;
+                }
 
-                        boost::system::error_code ec;
-                        for (const auto& endpoint : endpoints) {
-                            socket_.send_to(boost::asio::buffer(o.Data(), o.Size()), endpoint, 0, ec);
-                        }
-                    }
+                if (now - entry.last_sent < delta.min_send_interval) {
+                    entry.dirty = true;
+                    dirty_.push_back(it->first);
+                    continue;
                 }
-            } catch (...) {
-                CASPAR_LOG_CURRENT_EXCEPTION();
+
+                entry.last_sent = now;
+                entry.queued    = true;
+                messages.emplace_back(it->first, &entry.value);
             }
+        }
+
+        // Flush deferred changes whose interval has elapsed.
+        dirty_.erase(std::remove_if(dirty_.begin(),
+                                    dirty_.end(),
+                                    [&](const core::monitor::path& path) {
+                                        auto& entry = sent_.at(path);
+                                        if (now - entry.last_sent < delta.min_send_interval)
+                                            return false;
+                                        entry.dirty     = false;
+                                        entry.last_sent = now;
+                                        entry.queued    = true;
+                                        messages.emplace_back(path, &entry.value);
+                                        return true;
+                                    }),
+                     dirty_.end());
+
+        // New subscribers need the full state, as does anyone who missed a datagram.
+        auto new_subscriber = std::any_of(endpoints.begin(), endpoints.end(), [&](const udp::endpoint& endpoint) {
+            return std::find(last_endpoints_.begin(), last_endpoints_.end(), endpoint) == last_endpoints_.end();
         });
+        last_endpoints_ = endpoints;
+
+        if (new_subscriber || now >= next_keyframe_) {
+            messages.clear();
+            dirty_.clear();
+
+            for (auto it = sent_.begin(); it != sent_.end();) {
+                // Paths that have not been reported since the last keyframe no longer exist.
+                if (!it->second.seen) {
+                    it = sent_.erase(it);
+                    continue;
+                }
+                it->second.seen      = false;
+                it->second.dirty     = false;
+                it->second.last_sent = now;
+                messages.emplace_back(it->first, &it->second.value);
+                ++it;
+            }
+
+            next_keyframe_ = now + delta.keyframe_interval;
+        }
+
+        if (!endpoints.empty()) {
+            send_messages(messages, last_bundle_time_, endpoints);
+        }
+
+        for (const auto& message : messages) {
+            sent_.at(message.first).queued = false;
+        }
     }
 
-    ~impl()
+    void send_messages(const std::vector<message_t>&     messages,
+                       uint64_t                          time,
+                       const std::vector<udp::endpoint>& endpoints)
     {
-        abort_request_ = true;
-        cond_.notify_all();
-        thread_.join();
+        auto it = std::begin(messages);
+
+        while (it != std::end(messages)) {
+            ::osc::OutboundPacketStream o(reinterpret_cast<char*>(buffer_.data()),
+                                          static_cast<unsigned long>(buffer_.size()));
+
+            o << ::osc::BeginBundle(time);
+
+            // TODO (fix): < 2048 is a hack. Properly calculate if messages will fit.
+            while (it != std::end(messages) && o.Size() < 2048) {
+                o << ::osc::BeginMessage(it->first.str().c_str());
+
+                param_visitor<decltype(o)> param_visitor(o);
+                for (const auto& element : *it->second) {
+                    boost::apply_visitor(param_visitor, element);
+                }
+
+                o << ::osc::EndMessage;
+
+                ++it;
+            }
+
+            o << ::osc::EndBundle;
+
+            boost::system::error_code ec;
+            for (const auto& endpoint : endpoints) {
+                socket_.send_to(boost::asio::buffer(o.Data(), o.Size()), endpoint, 0, ec);
+            }
+        }
     }
 
     // TODO (refactor) This is wierd...
@@ -185,14 +349,27 @@ struct client::impl : public spl::enable_shared_from_this<client::impl>
         });
     }
 
+    void set_delta_options(const delta_options& options)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            delta_ = options;
+        }
+        cond_.notify_all();
+    }
+
     void send(const core::monitor::state& state)
     {
         {
             std::lock_guard<std::mutex> lock(mutex_);
 
+            // Every channel sends its own state, so keep them all rather than only the latest one.
+            if (bundles_.size() >= MAX_PENDING_BUNDLES) {
+                bundles_.pop_front();
+            }
+
             // TODO: time_++ is a hack. Use proper channel time.
-            bundle_time_ = time_++;
-            bundle_      = state;
+            bundles_.emplace_back(time_++, state);
         }
         cond_.notify_all();
     }
@@ -221,6 +398,8 @@ std::shared_ptr<void> client::get_subscription_token(const boost::asio::ip::udp:
     return impl_->get_subscription_token(endpoint);
 }
 
+void client::set_delta_options(const delta_options& options) { impl_->set_delta_options(options); }
+
 void client::send(core::monitor::state state) { impl_->send(state); }
 
 }}} // namespace caspar::protocol::osc
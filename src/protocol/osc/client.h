@@ -27,8 +27,22 @@
 #include <common/memory.h>
 #include <core/monitor/monitor.h>
 
+#include <chrono>
+
 namespace caspar { namespace protocol { namespace osc {
 
+/**
+ * When enabled only the paths whose values changed since they were last sent are transmitted, with the full state
+ * sent every keyframe interval and whenever a new endpoint subscribes. A path is sent at most once per minimum
+ * send interval, changes in between are coalesced and the latest value sent when the interval has elapsed.
+ */
+struct delta_options
+{
+    bool                      enabled           = false;
+    std::chrono::milliseconds keyframe_interval = std::chrono::milliseconds(5000);
+    std::chrono::milliseconds min_send_interval = std::chrono::milliseconds(0);
+};
+
 class client
 {
     client(const client&);
@@ -55,6 +69,8 @@ class client
 
     client& operator=(client&&);
 
+    void set_delta_options(const delta_options& options);
+
     void send(core::monitor::state state);
 
   private:
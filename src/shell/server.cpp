@@ -37,6 +37,7 @@
 #include <core/producer/cg_proxy.h>
 #include <core/producer/color/color_producer.h>
 #include <core/producer/frame_producer.h>
+#include <core/producer/media_info/media_index.h>
 #include <core/video_channel.h>
 #include <core/video_format.h>
 
@@ -65,6 +66,18 @@ namespace caspar {
 using namespace core;
 using namespace protocol;
 
+accelerator::image_mixer_type get_image_mixer_type(const boost::property_tree::wptree& xml_channel)
+{
+    auto type = xml_channel.get(L"image-mixer", L"ogl");
+
+    if (boost::iequals(type, L"ogl"))
+        return accelerator::image_mixer_type::ogl;
+    if (boost::iequals(type, L"cpu"))
+        return accelerator::image_mixer_type::cpu;
+
+    CASPAR_THROW_EXCEPTION(user_error() << msg_info(L"Invalid image-mixer: " + type));
+}
+
 std::shared_ptr<boost::asio::io_service> create_running_io_service()
 {
     auto service = std::make_shared<boost::asio::io_service>();
@@ -108,6 +121,7 @@ struct server::impl
     spl::shared_ptr<core::cg_producer_registry>        cg_registry_;
     spl::shared_ptr<core::frame_producer_registry>     producer_registry_;
     spl::shared_ptr<core::frame_consumer_registry>     consumer_registry_;
+    spl::shared_ptr<core::media_index>                 media_index_;
     std::function<void(bool)>                          shutdown_server_now_;
 
     impl(const impl&) = delete;
@@ -117,15 +131,26 @@ struct server::impl
         : accelerator_()
         , producer_registry_(spl::make_shared<core::frame_producer_registry>())
         , consumer_registry_(spl::make_shared<core::frame_consumer_registry>())
+        , media_index_(spl::make_shared<core::media_index>(cg_registry_))
         , shutdown_server_now_(std::move(shutdown_server_now))
     {
         caspar::core::diagnostics::osd::register_sink();
 
-        auto ogl_device    = accelerator_.get_device();
+        // Only bring up OpenGL when a channel needs it, the cpu mixer runs on machines without a usable GPU.
+        std::shared_ptr<accelerator::accelerator_device> ogl_device;
+        for (auto& xml_channel : env::properties() | witerate_children(L"configuration.channels")) {
+            if (xml_channel.first == L"channel" &&
+                get_image_mixer_type(xml_channel.second) == accelerator::image_mixer_type::ogl) {
+                ogl_device = accelerator_.get_device();
+                break;
+            }
+        }
+
         amcp_command_repo_ = spl::make_shared<amcp::amcp_command_repository>(
-            cg_registry_, producer_registry_, consumer_registry_, ogl_device, shutdown_server_now_);
+            cg_registry_, producer_registry_, consumer_registry_, ogl_device, media_index_, shutdown_server_now_);
 
-        module_dependencies dependencies(cg_registry_, producer_registry_, consumer_registry_, amcp_command_repo_);
+        module_dependencies dependencies(
+            cg_registry_, producer_registry_, consumer_registry_, media_index_, amcp_command_repo_);
 
         initialize_modules(dependencies);
         core::init_cg_proxy_as_producer(dependencies);
@@ -141,6 +166,9 @@ struct server::impl
 
         setup_osc(env::properties());
         CASPAR_LOG(info) << L"Initialized osc.";
+
+        media_index_->start();
+        CASPAR_LOG(info) << L"Initialized media index.";
     }
 
     ~impl()
@@ -177,12 +205,29 @@ struct server::impl
             if (format_desc.format == video_format::invalid)
                 CASPAR_THROW_EXCEPTION(user_error() << msg_info(L"Invalid video-mode: " + format_desc_str));
 
+            auto pipeline_depth = xml_channel.second.get(L"pipeline-depth", 1);
+            if (pipeline_depth < 1 || pipeline_depth > 3)
+                CASPAR_THROW_EXCEPTION(user_error()
+                                       << msg_info(L"Invalid pipeline-depth: " + std::to_wstring(pipeline_depth)));
+
+            auto offline = xml_channel.second.get(L"offline", false);
+
+            auto image_mixer_type = get_image_mixer_type(xml_channel.second);
+
+            auto color_depth = xml_channel.second.get(L"color-depth", 8);
+            if (color_depth != 8 && color_depth != 16)
+                CASPAR_THROW_EXCEPTION(user_error()
+                                       << msg_info(L"Invalid color-depth: " + std::to_wstring(color_depth)));
+            auto image_depth = color_depth == 16 ? bit_depth::bit16 : bit_depth::bit8;
+
             auto weak_client = std::weak_ptr<osc::client>(osc_client_);
             auto channel_id  = static_cast<int>(channels_.size() + 1);
+            auto image_mixer = accelerator_.create_image_mixer(channel_id, image_mixer_type, image_depth);
             auto channel =
                 spl::make_shared<video_channel>(channel_id,
                                                 format_desc,
-                                                accelerator_.create_image_mixer(channel_id),
+                                                std::move(image_mixer),
+                                                pipeline_depth,
                                                 [channel_id, weak_client](core::monitor::state channel_state) {
                                                     monitor::state state;
                                                     state[""]["channel"][channel_id] = channel_state;
@@ -191,6 +236,7 @@ struct server::impl
                                                         client->send(std::move(state));
                                                     }
                                                 });
+            channel->offline(offline);
 
             channels_.push_back(channel);
         }
@@ -225,6 +271,15 @@ struct server::impl
         auto disable_send_to_amcp_clients = pt.get(L"configuration.osc.disable-send-to-amcp-clients", false);
         auto predefined_clients           = pt.get_child_optional(L"configuration.osc.predefined-clients");
 
+        osc::delta_options delta;
+        delta.enabled = pt.get(L"configuration.osc.delta", false);
+        delta.keyframe_interval =
+            std::chrono::milliseconds(pt.get(L"configuration.osc.keyframe-interval", delta.keyframe_interval.count()));
+        auto max_rate = pt.get(L"configuration.osc.max-rate", 0.0);
+        if (max_rate > 0.0)
+            delta.min_send_interval = std::chrono::milliseconds(static_cast<int64_t>(1000.0 / max_rate));
+        osc_client_->set_delta_options(delta);
+
         if (predefined_clients) {
             for (auto& predefined_client :
                  pt | witerate_children(L"configuration.osc.predefined-clients") | welement_context_iteration) {